@@ -130,19 +130,29 @@ bool are_equivalent_with_paths(const PathHandleGraph* graph_1,
             return false;
         }
         
-        vector<handle_t> handles_1, handles_2;
-        for (handle_t handle : graph_1->scan_path(path_handle_1)) {
-            handles_1.push_back(handle);
-        }
-        for (handle_t handle : graph_2->scan_path(path_handle_2)) {
-            handles_2.push_back(handle);
-        }
-        
-        assert(handles_1.size() == handles_2.size());
-        
-        for (size_t i = 0; i < handles_1.size(); i++) {
-            handle_t handle_1 = handles_1[i];
-            handle_t handle_2 = handles_2[i];
+        // Walk the two paths in lockstep, a block of steps at a time
+        handle_t block_1[PathHandleGraph::STEP_BLOCK_SIZE];
+        handle_t block_2[PathHandleGraph::STEP_BLOCK_SIZE];
+        step_handle_t step_1 = graph_1->path_begin(path_handle_1);
+        step_handle_t step_2 = graph_2->path_begin(path_handle_2);
+        size_t count_1 = 0, count_2 = 0, i_1 = 0, i_2 = 0;
+        while (true) {
+            if (i_1 == count_1) {
+                count_1 = graph_1->get_step_handles(path_handle_1, step_1, block_1, PathHandleGraph::STEP_BLOCK_SIZE);
+                i_1 = 0;
+            }
+            if (i_2 == count_2) {
+                count_2 = graph_2->get_step_handles(path_handle_2, step_2, block_2, PathHandleGraph::STEP_BLOCK_SIZE);
+                i_2 = 0;
+            }
+            if (count_1 == 0 || count_2 == 0) {
+                // We already know the step counts match
+                assert(count_1 == count_2);
+                break;
+            }
+            
+            handle_t handle_1 = block_1[i_1++];
+            handle_t handle_2 = block_2[i_2++];
             
             if (graph_1->get_id(handle_1) != graph_2->get_id(handle_2) ||
                 graph_1->get_is_reverse(handle_1) != graph_2->get_is_reverse(handle_2)) {
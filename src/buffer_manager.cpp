@@ -0,0 +1,225 @@
+#include "handlegraph/buffer_manager.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+/** \file buffer_manager.cpp
+ * Implement the page cache.
+ */
+
+namespace handlegraph {
+
+const size_t BufferManager::DEFAULT_PAGE_SIZE = 64 * 1024;
+const size_t BufferManager::DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+const size_t BufferManager::DEFAULT_READ_AHEAD_PAGES = 32;
+
+BufferManager::BufferManager(int fd, size_t memory_budget, size_t page_size, size_t read_ahead_pages) :
+    fd(fd), page_size(std::max<size_t>(page_size, 1)), read_ahead_pages(read_ahead_pages),
+    hits(0), misses(0), pages_read(0) {
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        throw std::runtime_error("error:[BufferManager] could not inspect file: " + std::string(::strerror(errno)));
+    }
+    file_size = info.st_size;
+    // Always leave room for a page being read ahead next to one being used
+    page_budget = std::max<size_t>(memory_budget / this->page_size, 2);
+    if (read_ahead_pages != 0) {
+        reader = std::thread(&BufferManager::read_ahead_loop, this);
+    }
+}
+
+BufferManager::~BufferManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queue_changed.notify_all();
+    if (reader.joinable()) {
+        reader.join();
+    }
+}
+
+void BufferManager::read(uint64_t offset, size_t length, void* dest) const {
+    if (offset > file_size || length > file_size - offset) {
+        throw std::runtime_error("error:[BufferManager] cannot read " + std::to_string(length) + " bytes at "
+                                 + std::to_string(offset) + " in a file of " + std::to_string(file_size) + " bytes");
+    }
+    char* out = (char*) dest;
+    while (length != 0) {
+        std::shared_ptr<Page> page = get_page(offset / page_size, false);
+        size_t in_page = offset % page_size;
+        size_t count = std::min(length, page->data.size() - in_page);
+        std::copy(page->data.begin() + in_page, page->data.begin() + in_page + count, out);
+        out += count;
+        offset += count;
+        length -= count;
+    }
+}
+
+void BufferManager::prefetch(uint64_t offset, size_t length) const {
+    if (length == 0 || offset >= file_size) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    enqueue(offset / page_size, (offset + length + page_size - 1) / page_size);
+}
+
+uint64_t BufferManager::get_file_size() const {
+    return file_size;
+}
+
+size_t BufferManager::get_page_size() const {
+    return page_size;
+}
+
+size_t BufferManager::get_page_hits() const {
+    return hits.load();
+}
+
+size_t BufferManager::get_page_misses() const {
+    return misses.load();
+}
+
+size_t BufferManager::get_pages_read() const {
+    return pages_read.load();
+}
+
+std::shared_ptr<BufferManager::Page> BufferManager::get_page(uint64_t number, bool for_read_ahead) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto found = frames.find(number);
+    if (found != frames.end()) {
+        std::shared_ptr<Page> page = found->second.page;
+        if (for_read_ahead) {
+            return page;
+        }
+        recency.splice(recency.begin(), recency, found->second.recency);
+        if (!page->ready && !page->failed) {
+            misses++;
+            page_loaded.wait(lock, [&]() {
+                return page->ready || page->failed;
+            });
+        } else {
+            hits++;
+        }
+        if (page->failed) {
+            throw std::runtime_error("error:[BufferManager] could not read page " + std::to_string(number));
+        }
+        if (page->read_ahead) {
+            // The scan caught up with what we read ahead, so keep going
+            page->read_ahead = false;
+            enqueue(number + 1, number + 1 + read_ahead_pages);
+        }
+        return page;
+    }
+
+    // We have to read it ourselves
+    std::shared_ptr<Page> page = std::make_shared<Page>();
+    page->read_ahead = for_read_ahead;
+    if (!for_read_ahead) {
+        misses++;
+        if (number != 0 && frames.count(number - 1)) {
+            // Looks like a scan is starting
+            enqueue(number + 1, number + 1 + read_ahead_pages);
+        }
+    }
+    recency.push_front(number);
+    frames[number] = Frame{page, recency.begin()};
+    while (frames.size() > page_budget) {
+        // Anyone still using an evicted page keeps it alive
+        frames.erase(recency.back());
+        recency.pop_back();
+    }
+    lock.unlock();
+
+    load_page(number, *page, !for_read_ahead);
+    return page;
+}
+
+void BufferManager::load_page(uint64_t number, Page& page, bool rethrow) const {
+    uint64_t start = number * page_size;
+    std::vector<char> data(std::min<uint64_t>(page_size, file_size - start));
+    std::string problem;
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t result = ::pread(fd, data.data() + done, data.size() - done, start + done);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0) {
+            problem = ::strerror(errno);
+            break;
+        }
+        if (result == 0) {
+            problem = "unexpected end of file";
+            break;
+        }
+        done += result;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (problem.empty()) {
+        page.data = std::move(data);
+        page.ready = true;
+        pages_read++;
+    } else {
+        page.failed = true;
+        // Let the next request try again
+        auto found = frames.find(number);
+        if (found != frames.end() && found->second.page.get() == &page) {
+            recency.erase(found->second.recency);
+            frames.erase(found);
+        }
+    }
+    page_loaded.notify_all();
+    if (!problem.empty() && rethrow) {
+        throw std::runtime_error("error:[BufferManager] could not read page " + std::to_string(number) + ": " + problem);
+    }
+}
+
+void BufferManager::enqueue(uint64_t first, uint64_t past_last) const {
+    if (read_ahead_pages == 0) {
+        return;
+    }
+    past_last = std::min<uint64_t>(past_last, (file_size + page_size - 1) / page_size);
+    bool queued = false;
+    for (uint64_t number = first; number < past_last && queue.size() < page_budget / 2; number++) {
+        if (!frames.count(number)) {
+            queue.push_back(number);
+            queued = true;
+        }
+    }
+    if (queued) {
+        queue_changed.notify_one();
+    }
+}
+
+void BufferManager::read_ahead_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        queue_changed.wait(lock, [&]() {
+            return stopping || !queue.empty();
+        });
+        if (stopping) {
+            return;
+        }
+        uint64_t number = queue.front();
+        queue.pop_front();
+        if (frames.count(number)) {
+            continue;
+        }
+        lock.unlock();
+        try {
+            get_page(number, true);
+        } catch (std::exception& e) {
+            // Whoever actually needs the page will see the problem
+        }
+        lock.lock();
+    }
+}
+
+}
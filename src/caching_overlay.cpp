@@ -0,0 +1,358 @@
+#include "handlegraph/overlays/caching_overlay.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/** \file caching_overlay.cpp
+ * Implement the caching overlays.
+ */
+
+namespace handlegraph {
+
+/// Bytes we charge for each cache entry on top of its contents, for the list
+/// and hash table nodes
+static const size_t ENTRY_OVERHEAD = 96;
+
+CachingOverlay::CachingOverlay(const HandleGraph* graph, size_t byte_budget, size_t shard_count) :
+    CachingOverlay(graph, byte_budget / 2, byte_budget / 2, shard_count) {
+    // Nothing to do
+}
+
+CachingOverlay::CachingOverlay(const HandleGraph* graph, size_t sequence_bytes, size_t edge_bytes, size_t shard_count) :
+    graph(graph), sequence_cache(sequence_bytes, shard_count), edge_cache(edge_bytes, shard_count) {
+    // Nothing to do
+}
+
+std::string CachingOverlay::get_cached_sequence(const handle_t& handle) const {
+    std::string sequence;
+    if (!sequence_cache.get(handle, sequence)) {
+        sequence = graph->get_sequence(handle);
+        sequence_cache.put(handle, sequence, sequence.size() + sizeof(std::string) + ENTRY_OVERHEAD);
+    }
+    return sequence;
+}
+
+std::vector<handle_t> CachingOverlay::get_cached_edges(const handle_t& handle) const {
+    std::vector<handle_t> next;
+    if (!edge_cache.get(handle, next)) {
+        graph->follow_edges(handle, false, [&](const handle_t& other) {
+            next.push_back(other);
+        });
+        edge_cache.put(handle, next, next.size() * sizeof(handle_t) + sizeof(next) + ENTRY_OVERHEAD);
+    }
+    return next;
+}
+
+void CachingOverlay::prefetch(const std::vector<handle_t>& handles, const ExecutionOptions& execution) const {
+    execution.parallel_for(handles.size(), [&](size_t i) {
+        // Algorithms tend to look at both orientations of a node
+        handle_t flipped = graph->flip(handles[i]);
+        get_cached_sequence(handles[i]);
+        get_cached_sequence(flipped);
+        get_cached_edges(handles[i]);
+        get_cached_edges(flipped);
+    });
+}
+
+CacheStatistics CachingOverlay::get_statistics() const {
+    CacheStatistics statistics;
+    statistics.sequence_hits = sequence_cache.get_hits();
+    statistics.sequence_misses = sequence_cache.get_misses();
+    statistics.edge_hits = edge_cache.get_hits();
+    statistics.edge_misses = edge_cache.get_misses();
+    statistics.bytes_used = sequence_cache.get_bytes_used() + edge_cache.get_bytes_used();
+    return statistics;
+}
+
+void CachingOverlay::reset_statistics() const {
+    sequence_cache.reset_statistics();
+    edge_cache.reset_statistics();
+}
+
+void CachingOverlay::clear_cache() const {
+    sequence_cache.clear();
+    edge_cache.clear();
+}
+
+bool CachingOverlay::has_node(nid_t node_id) const {
+    return graph->has_node(node_id);
+}
+
+handle_t CachingOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return graph->get_handle(node_id, is_reverse);
+}
+
+nid_t CachingOverlay::get_id(const handle_t& handle) const {
+    return graph->get_id(handle);
+}
+
+bool CachingOverlay::get_is_reverse(const handle_t& handle) const {
+    return graph->get_is_reverse(handle);
+}
+
+handle_t CachingOverlay::flip(const handle_t& handle) const {
+    return graph->flip(handle);
+}
+
+size_t CachingOverlay::get_length(const handle_t& handle) const {
+    return get_cached_sequence(handle).size();
+}
+
+std::string CachingOverlay::get_sequence(const handle_t& handle) const {
+    return get_cached_sequence(handle);
+}
+
+size_t CachingOverlay::get_node_count() const {
+    return graph->get_node_count();
+}
+
+nid_t CachingOverlay::min_node_id() const {
+    return graph->min_node_id();
+}
+
+nid_t CachingOverlay::max_node_id() const {
+    return graph->max_node_id();
+}
+
+size_t CachingOverlay::get_degree(const handle_t& handle, bool go_left) const {
+    return get_cached_edges(go_left ? graph->flip(handle) : handle).size();
+}
+
+bool CachingOverlay::has_edge(const handle_t& left, const handle_t& right) const {
+    auto next = get_cached_edges(left);
+    return std::find(next.begin(), next.end(), right) != next.end();
+}
+
+size_t CachingOverlay::get_edge_count() const {
+    return graph->get_edge_count();
+}
+
+size_t CachingOverlay::get_total_length() const {
+    return graph->get_total_length();
+}
+
+char CachingOverlay::get_base(const handle_t& handle, size_t index) const {
+    return get_cached_sequence(handle).at(index);
+}
+
+std::string CachingOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    std::string sequence = get_cached_sequence(handle);
+    if (index >= sequence.size()) {
+        return "";
+    }
+    return sequence.substr(index, size);
+}
+
+size_t CachingOverlay::copy_sequence(const handle_t& handle, char* dest) const {
+    std::string sequence = get_cached_sequence(handle);
+    memcpy(dest, sequence.data(), sequence.size());
+    return sequence.size();
+}
+
+handle_t CachingOverlay::get_underlying_handle(const handle_t& handle) const {
+    return handle;
+}
+
+bool CachingOverlay::follow_edges_impl(const handle_t& handle, bool go_left,
+                                       const std::function<bool(const handle_t&)>& iteratee) const {
+    // The left side of a handle is the right side of its flip
+    for (const handle_t& other : get_cached_edges(go_left ? graph->flip(handle) : handle)) {
+        if (!iteratee(go_left ? graph->flip(other) : other)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CachingOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    return graph->for_each_handle(iteratee, parallel);
+}
+
+PathCachingOverlay::PathCachingOverlay(const PathHandleGraph* graph, size_t byte_budget, size_t shard_count) :
+    CachingOverlay(graph, byte_budget / 3, byte_budget / 3, shard_count), path_graph(graph),
+    step_cache(byte_budget / 3, shard_count) {
+    // Nothing to do
+}
+
+PathCachingOverlay::StepBlock PathCachingOverlay::get_cached_block(const path_handle_t& path_handle,
+                                                                   const step_handle_t& step) const {
+    StepBlock block;
+    if (step_cache.get(step, block) && block.path == path_handle) {
+        return block;
+    }
+    block.path = path_handle;
+    block.handles.resize(STEP_BLOCK_SIZE);
+    block.next = step;
+    block.handles.resize(path_graph->get_step_handles(path_handle, block.next, block.handles.data(), STEP_BLOCK_SIZE));
+    step_cache.put(step, block, block.handles.size() * sizeof(handle_t) + sizeof(block) + ENTRY_OVERHEAD);
+    return block;
+}
+
+void PathCachingOverlay::prefetch_path(const path_handle_t& path_handle) const {
+    step_handle_t here = path_begin(path_handle);
+    step_handle_t end = path_end(path_handle);
+    while (here != end) {
+        StepBlock block = get_cached_block(path_handle, here);
+        if (block.handles.empty()) {
+            break;
+        }
+        here = block.next;
+    }
+}
+
+CacheStatistics PathCachingOverlay::get_statistics() const {
+    CacheStatistics statistics = CachingOverlay::get_statistics();
+    statistics.step_hits = step_cache.get_hits();
+    statistics.step_misses = step_cache.get_misses();
+    statistics.bytes_used += step_cache.get_bytes_used();
+    return statistics;
+}
+
+void PathCachingOverlay::reset_statistics() const {
+    CachingOverlay::reset_statistics();
+    step_cache.reset_statistics();
+}
+
+void PathCachingOverlay::clear_cache() const {
+    CachingOverlay::clear_cache();
+    step_cache.clear();
+}
+
+size_t PathCachingOverlay::get_path_count() const {
+    return path_graph->get_path_count();
+}
+
+bool PathCachingOverlay::has_path(const std::string& path_name) const {
+    return path_graph->has_path(path_name);
+}
+
+path_handle_t PathCachingOverlay::get_path_handle(const std::string& path_name) const {
+    return path_graph->get_path_handle(path_name);
+}
+
+std::string PathCachingOverlay::get_path_name(const path_handle_t& path_handle) const {
+    return path_graph->get_path_name(path_handle);
+}
+
+bool PathCachingOverlay::get_is_circular(const path_handle_t& path_handle) const {
+    return path_graph->get_is_circular(path_handle);
+}
+
+size_t PathCachingOverlay::get_step_count(const path_handle_t& path_handle) const {
+    return path_graph->get_step_count(path_handle);
+}
+
+size_t PathCachingOverlay::get_step_count(const handle_t& handle) const {
+    return path_graph->get_step_count(handle);
+}
+
+handle_t PathCachingOverlay::get_handle_of_step(const step_handle_t& step_handle) const {
+    return path_graph->get_handle_of_step(step_handle);
+}
+
+path_handle_t PathCachingOverlay::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    return path_graph->get_path_handle_of_step(step_handle);
+}
+
+step_handle_t PathCachingOverlay::path_begin(const path_handle_t& path_handle) const {
+    return path_graph->path_begin(path_handle);
+}
+
+step_handle_t PathCachingOverlay::path_end(const path_handle_t& path_handle) const {
+    return path_graph->path_end(path_handle);
+}
+
+step_handle_t PathCachingOverlay::path_back(const path_handle_t& path_handle) const {
+    return path_graph->path_back(path_handle);
+}
+
+step_handle_t PathCachingOverlay::path_front_end(const path_handle_t& path_handle) const {
+    return path_graph->path_front_end(path_handle);
+}
+
+bool PathCachingOverlay::has_next_step(const step_handle_t& step_handle) const {
+    return path_graph->has_next_step(step_handle);
+}
+
+bool PathCachingOverlay::has_previous_step(const step_handle_t& step_handle) const {
+    return path_graph->has_previous_step(step_handle);
+}
+
+step_handle_t PathCachingOverlay::get_next_step(const step_handle_t& step_handle) const {
+    return path_graph->get_next_step(step_handle);
+}
+
+step_handle_t PathCachingOverlay::get_previous_step(const step_handle_t& step_handle) const {
+    return path_graph->get_previous_step(step_handle);
+}
+
+size_t PathCachingOverlay::get_step_handles(const path_handle_t& path, step_handle_t& step,
+                                            handle_t* buffer, size_t max_steps) const {
+    if (max_steps < STEP_BLOCK_SIZE) {
+        // We couldn't stop partway through a cached block
+        return path_graph->get_step_handles(path, step, buffer, max_steps);
+    }
+    size_t written = 0;
+    while (written + STEP_BLOCK_SIZE <= max_steps && step != path_end(path)) {
+        StepBlock block = get_cached_block(path, step);
+        if (block.handles.empty()) {
+            break;
+        }
+        std::copy(block.handles.begin(), block.handles.end(), buffer + written);
+        written += block.handles.size();
+        step = block.next;
+    }
+    return written;
+}
+
+PathSense PathCachingOverlay::get_sense(const path_handle_t& handle) const {
+    return path_graph->get_sense(handle);
+}
+
+std::string PathCachingOverlay::get_sample_name(const path_handle_t& handle) const {
+    return path_graph->get_sample_name(handle);
+}
+
+std::string PathCachingOverlay::get_locus_name(const path_handle_t& handle) const {
+    return path_graph->get_locus_name(handle);
+}
+
+size_t PathCachingOverlay::get_haplotype(const path_handle_t& handle) const {
+    return path_graph->get_haplotype(handle);
+}
+
+size_t PathCachingOverlay::get_phase_block(const path_handle_t& handle) const {
+    return path_graph->get_phase_block(handle);
+}
+
+subrange_t PathCachingOverlay::get_subrange(const path_handle_t& handle) const {
+    return path_graph->get_subrange(handle);
+}
+
+bool PathCachingOverlay::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
+    return path_graph->for_each_path_handle(iteratee);
+}
+
+bool PathCachingOverlay::for_each_step_on_handle_impl(const handle_t& handle,
+                                                      const std::function<bool(const step_handle_t&)>& iteratee) const {
+    return path_graph->for_each_step_on_handle(handle, iteratee);
+}
+
+bool PathCachingOverlay::for_each_path_interval_impl(const std::vector<std::pair<nid_t, nid_t>>& id_ranges,
+                                                     const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const {
+    return path_graph->for_each_path_interval(id_ranges, iteratee);
+}
+
+bool PathCachingOverlay::for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                                     const std::unordered_set<std::string>* samples,
+                                                     const std::unordered_set<std::string>* loci,
+                                                     const std::function<bool(const path_handle_t&)>& iteratee) const {
+    return path_graph->for_each_path_matching(senses, samples, loci, iteratee);
+}
+
+bool PathCachingOverlay::for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                                     const std::function<bool(const step_handle_t&)>& iteratee) const {
+    return path_graph->for_each_step_of_sense(visited, sense, iteratee);
+}
+
+}
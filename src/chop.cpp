@@ -700,8 +700,8 @@ void unchop(MutablePathDeletableHandleGraph& graph) {
         path_names[rank] = graph.get_path_name(p);
         
         auto& seq = path_sequences[rank];
-        graph.for_each_step_in_path(p, [&](const step_handle_t& s) {
-            seq.append(graph.get_sequence(graph.get_handle_of_step(s)));
+        graph.for_each_handle_in_path(p, [&](const handle_t& h) {
+            seq.append(graph.get_sequence(h));
         });
         
         ++rank;
@@ -0,0 +1,427 @@
+#include "handlegraph/overlays/chopped_overlay.hpp"
+#include "handlegraph/util.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/** \file chopped_overlay.cpp
+ * Implement the chopped overlay.
+ */
+
+namespace handlegraph {
+
+ChoppedOverlay::ChoppedOverlay(const PathHandleGraph* graph, size_t max_node_length) :
+    graph(graph), max_node_length(max_node_length) {
+
+    if (max_node_length == 0) {
+        throw std::runtime_error("error:[ChoppedOverlay] maximum node length must be positive");
+    }
+
+    // Find all the nodes and their piece counts
+    std::vector<std::pair<nid_t, size_t>> node_pieces;
+    node_pieces.reserve(graph->get_node_count());
+    graph->for_each_handle([&](const handle_t& handle) {
+        size_t length = graph->get_length(handle);
+        // Even an empty node gets a piece
+        size_t pieces = std::max<size_t>(1, (length + max_node_length - 1) / max_node_length);
+        if (pieces - 1 > step_number_packing::MAX_NUMBER) {
+            throw std::runtime_error("error:[ChoppedOverlay] node " + std::to_string(graph->get_id(handle))
+                                     + " has too many pieces at maximum length " + std::to_string(max_node_length));
+        }
+        node_pieces.emplace_back(graph->get_id(handle), pieces);
+    });
+    std::sort(node_pieces.begin(), node_pieces.end());
+
+    // Make sure the underlying step handles leave room for piece numbers, so
+    // graphs that use those bits fail here and not with corrupted steps.
+    graph->for_each_path_matching(nullptr, nullptr, nullptr, [&](const path_handle_t& path) {
+        for (const step_handle_t& step : {graph->path_begin(path), graph->path_end(path),
+                                          graph->path_back(path), graph->path_front_end(path)}) {
+            if (!step_number_packing::can_pack(step)) {
+                throw std::runtime_error("error:[ChoppedOverlay] step handles on path " + graph->get_path_name(path)
+                                         + " have no room for a piece number");
+            }
+        }
+    });
+
+    // Lay out the pieces in ID order
+    node_ids.reserve(node_pieces.size());
+    first_pieces.reserve(node_pieces.size() + 1);
+    first_pieces.push_back(0);
+    for (auto& node : node_pieces) {
+        node_ids.push_back(node.first);
+        first_pieces.push_back(first_pieces.back() + node.second);
+    }
+}
+
+size_t ChoppedOverlay::get_rank(nid_t piece_id) const {
+    return std::upper_bound(first_pieces.begin(), first_pieces.end(), (size_t) (piece_id - 1)) - first_pieces.begin() - 1;
+}
+
+size_t ChoppedOverlay::get_rank_of_node(nid_t node_id) const {
+    return std::lower_bound(node_ids.begin(), node_ids.end(), node_id) - node_ids.begin();
+}
+
+handle_t ChoppedOverlay::get_piece_handle(size_t rank, size_t piece, bool is_reverse) const {
+    return number_bool_packing::pack(first_pieces[rank] + piece + 1, is_reverse);
+}
+
+handle_t ChoppedOverlay::get_piece_handle(size_t rank, const handle_t& underlying, size_t piece) const {
+    bool is_reverse = graph->get_is_reverse(underlying);
+    return get_piece_handle(rank, is_reverse ? get_piece_count(rank) - 1 - piece : piece, is_reverse);
+}
+
+void ChoppedOverlay::decode(const handle_t& handle, handle_t& underlying, size_t& rank, size_t& piece) const {
+    nid_t piece_id = get_id(handle);
+    bool is_reverse = get_is_reverse(handle);
+    rank = get_rank(piece_id);
+    underlying = graph->get_handle(node_ids[rank], is_reverse);
+    piece = piece_id - 1 - first_pieces[rank];
+    if (is_reverse) {
+        // Count along the reverse strand instead
+        piece = get_piece_count(rank) - 1 - piece;
+    }
+}
+
+void ChoppedOverlay::get_piece_range(const handle_t& handle, handle_t& underlying, size_t& offset, size_t& length) const {
+    nid_t piece_id = get_id(handle);
+    size_t rank = get_rank(piece_id);
+    size_t piece = piece_id - 1 - first_pieces[rank];
+    underlying = graph->get_handle(node_ids[rank], get_is_reverse(handle));
+
+    // Find where we are along the forward strand
+    size_t node_length = graph->get_length(underlying);
+    offset = piece * max_node_length;
+    length = std::min(max_node_length, node_length - offset);
+    if (get_is_reverse(handle)) {
+        offset = node_length - offset - length;
+    }
+}
+
+bool ChoppedOverlay::is_front_end(const step_handle_t& underlying) const {
+    return underlying == graph->path_front_end(graph->get_path_handle_of_step(underlying));
+}
+
+step_handle_t ChoppedOverlay::pack_step(const step_handle_t& underlying, size_t piece) const {
+    // Even packing 0, which changes nothing, needs the spare bits to be free,
+    // or unpacking would find a piece number in them.
+    if (!step_number_packing::can_pack(underlying)) {
+        throw std::runtime_error("error:[ChoppedOverlay] underlying step handle has no room for a piece number");
+    }
+    return step_number_packing::pack(underlying, piece);
+}
+
+bool ChoppedOverlay::has_node(nid_t node_id) const {
+    return node_id >= 1 && (size_t) node_id <= first_pieces.back();
+}
+
+handle_t ChoppedOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(node_id, is_reverse);
+}
+
+nid_t ChoppedOverlay::get_id(const handle_t& handle) const {
+    return number_bool_packing::unpack_number(handle);
+}
+
+bool ChoppedOverlay::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t ChoppedOverlay::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t ChoppedOverlay::get_length(const handle_t& handle) const {
+    nid_t piece_id = get_id(handle);
+    size_t rank = get_rank(piece_id);
+    if (piece_id < (nid_t) first_pieces[rank + 1]) {
+        // Only the last piece can be short
+        return max_node_length;
+    }
+    size_t node_length = graph->get_length(graph->get_handle(node_ids[rank]));
+    return node_length - (get_piece_count(rank) - 1) * max_node_length;
+}
+
+std::string ChoppedOverlay::get_sequence(const handle_t& handle) const {
+    handle_t underlying;
+    size_t offset, length;
+    get_piece_range(handle, underlying, offset, length);
+    return graph->get_subsequence(underlying, offset, length);
+}
+
+size_t ChoppedOverlay::get_node_count() const {
+    return first_pieces.back();
+}
+
+nid_t ChoppedOverlay::min_node_id() const {
+    return 1;
+}
+
+nid_t ChoppedOverlay::max_node_id() const {
+    return first_pieces.back();
+}
+
+size_t ChoppedOverlay::get_edge_count() const {
+    // Each extra piece adds an edge
+    return graph->get_edge_count() + first_pieces.back() - node_ids.size();
+}
+
+size_t ChoppedOverlay::get_total_length() const {
+    return graph->get_total_length();
+}
+
+char ChoppedOverlay::get_base(const handle_t& handle, size_t index) const {
+    handle_t underlying;
+    size_t offset, length;
+    get_piece_range(handle, underlying, offset, length);
+    return graph->get_base(underlying, offset + index);
+}
+
+std::string ChoppedOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    handle_t underlying;
+    size_t offset, length;
+    get_piece_range(handle, underlying, offset, length);
+    if (index >= length) {
+        return "";
+    }
+    return graph->get_subsequence(underlying, offset + index, std::min(size, length - index));
+}
+
+size_t ChoppedOverlay::copy_sequence(const handle_t& handle, char* dest) const {
+    std::string sequence = get_sequence(handle);
+    memcpy(dest, sequence.data(), sequence.size());
+    return sequence.size();
+}
+
+handle_t ChoppedOverlay::get_underlying_handle(const handle_t& handle) const {
+    return graph->get_handle(node_ids[get_rank(get_id(handle))], get_is_reverse(handle));
+}
+
+bool ChoppedOverlay::follow_edges_impl(const handle_t& handle, bool go_left,
+                                       const std::function<bool(const handle_t&)>& iteratee) const {
+    handle_t underlying;
+    size_t rank, piece;
+    decode(handle, underlying, rank, piece);
+
+    if (!go_left && piece + 1 < get_piece_count(rank)) {
+        // Go to the next piece of the same node
+        return iteratee(get_piece_handle(rank, underlying, piece + 1));
+    }
+    if (go_left && piece > 0) {
+        // Go to the previous piece of the same node
+        return iteratee(get_piece_handle(rank, underlying, piece - 1));
+    }
+
+    // Otherwise we go to the near ends of the adjacent nodes
+    return graph->follow_edges(underlying, go_left, [&](const handle_t& other) {
+        size_t other_rank = get_rank_of_node(graph->get_id(other));
+        return iteratee(get_piece_handle(other_rank, other, go_left ? get_piece_count(other_rank) - 1 : 0));
+    });
+}
+
+bool ChoppedOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    if (!parallel) {
+        for (size_t piece_id = 1; piece_id <= first_pieces.back(); piece_id++) {
+            if (!iteratee(get_handle(piece_id))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Let the underlying graph divide up the work
+    return graph->for_each_handle([&](const handle_t& handle) {
+        size_t rank = get_rank_of_node(graph->get_id(handle));
+        for (size_t piece = 0; piece < get_piece_count(rank); piece++) {
+            if (!iteratee(get_piece_handle(rank, piece, false))) {
+                return false;
+            }
+        }
+        return true;
+    }, true);
+}
+
+size_t ChoppedOverlay::get_path_count() const {
+    return graph->get_path_count();
+}
+
+bool ChoppedOverlay::has_path(const std::string& path_name) const {
+    return graph->has_path(path_name);
+}
+
+path_handle_t ChoppedOverlay::get_path_handle(const std::string& path_name) const {
+    return graph->get_path_handle(path_name);
+}
+
+std::string ChoppedOverlay::get_path_name(const path_handle_t& path_handle) const {
+    return graph->get_path_name(path_handle);
+}
+
+bool ChoppedOverlay::get_is_circular(const path_handle_t& path_handle) const {
+    return graph->get_is_circular(path_handle);
+}
+
+size_t ChoppedOverlay::get_step_count(const path_handle_t& path_handle) const {
+    size_t count = 0;
+    graph->for_each_step_in_path(path_handle, [&](const step_handle_t& step) {
+        count += get_piece_count(get_rank_of_node(graph->get_id(graph->get_handle_of_step(step))));
+    });
+    return count;
+}
+
+size_t ChoppedOverlay::get_step_count(const handle_t& handle) const {
+    // Every visit to the node visits every piece once
+    return graph->get_step_count(get_underlying_handle(handle));
+}
+
+bool ChoppedOverlay::is_empty(const path_handle_t& path_handle) const {
+    return graph->is_empty(path_handle);
+}
+
+handle_t ChoppedOverlay::get_handle_of_step(const step_handle_t& step_handle) const {
+    handle_t underlying = graph->get_handle_of_step(step_number_packing::unpack_step(step_handle));
+    return get_piece_handle(get_rank_of_node(graph->get_id(underlying)), underlying,
+                            step_number_packing::unpack_number(step_handle));
+}
+
+path_handle_t ChoppedOverlay::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    return graph->get_path_handle_of_step(step_number_packing::unpack_step(step_handle));
+}
+
+step_handle_t ChoppedOverlay::path_begin(const path_handle_t& path_handle) const {
+    return pack_step(graph->path_begin(path_handle), 0);
+}
+
+step_handle_t ChoppedOverlay::path_end(const path_handle_t& path_handle) const {
+    return pack_step(graph->path_end(path_handle), 0);
+}
+
+step_handle_t ChoppedOverlay::path_back(const path_handle_t& path_handle) const {
+    step_handle_t back = graph->path_back(path_handle);
+    if (back == graph->path_front_end(path_handle)) {
+        // The path is empty
+        return pack_step(back, 0);
+    }
+    size_t rank = get_rank_of_node(graph->get_id(graph->get_handle_of_step(back)));
+    return pack_step(back, get_piece_count(rank) - 1);
+}
+
+step_handle_t ChoppedOverlay::path_front_end(const path_handle_t& path_handle) const {
+    return pack_step(graph->path_front_end(path_handle), 0);
+}
+
+bool ChoppedOverlay::has_next_step(const step_handle_t& step_handle) const {
+    step_handle_t underlying = step_number_packing::unpack_step(step_handle);
+    size_t piece = step_number_packing::unpack_number(step_handle);
+    if (piece == 0 && is_front_end(underlying)) {
+        return graph->has_next_step(underlying);
+    }
+    size_t rank = get_rank_of_node(graph->get_id(graph->get_handle_of_step(underlying)));
+    return piece + 1 < get_piece_count(rank) || graph->has_next_step(underlying);
+}
+
+bool ChoppedOverlay::has_previous_step(const step_handle_t& step_handle) const {
+    return step_number_packing::unpack_number(step_handle) > 0
+        || graph->has_previous_step(step_number_packing::unpack_step(step_handle));
+}
+
+step_handle_t ChoppedOverlay::get_next_step(const step_handle_t& step_handle) const {
+    step_handle_t underlying = step_number_packing::unpack_step(step_handle);
+    size_t piece = step_number_packing::unpack_number(step_handle);
+    if (piece != 0 || !is_front_end(underlying)) {
+        size_t rank = get_rank_of_node(graph->get_id(graph->get_handle_of_step(underlying)));
+        if (piece + 1 < get_piece_count(rank)) {
+            // Stay on the same underlying step
+            return pack_step(underlying, piece + 1);
+        }
+    }
+    return pack_step(graph->get_next_step(underlying), 0);
+}
+
+step_handle_t ChoppedOverlay::get_previous_step(const step_handle_t& step_handle) const {
+    step_handle_t underlying = step_number_packing::unpack_step(step_handle);
+    size_t piece = step_number_packing::unpack_number(step_handle);
+    if (piece > 0) {
+        // Stay on the same underlying step
+        return pack_step(underlying, piece - 1);
+    }
+    step_handle_t previous = graph->get_previous_step(underlying);
+    if (previous == graph->path_front_end(graph->get_path_handle_of_step(previous))) {
+        return pack_step(previous, 0);
+    }
+    size_t rank = get_rank_of_node(graph->get_id(graph->get_handle_of_step(previous)));
+    return pack_step(previous, get_piece_count(rank) - 1);
+}
+
+PathSense ChoppedOverlay::get_sense(const path_handle_t& handle) const {
+    return graph->get_sense(handle);
+}
+
+std::string ChoppedOverlay::get_sample_name(const path_handle_t& handle) const {
+    return graph->get_sample_name(handle);
+}
+
+std::string ChoppedOverlay::get_locus_name(const path_handle_t& handle) const {
+    return graph->get_locus_name(handle);
+}
+
+size_t ChoppedOverlay::get_haplotype(const path_handle_t& handle) const {
+    return graph->get_haplotype(handle);
+}
+
+size_t ChoppedOverlay::get_phase_block(const path_handle_t& handle) const {
+    return graph->get_phase_block(handle);
+}
+
+subrange_t ChoppedOverlay::get_subrange(const path_handle_t& handle) const {
+    return graph->get_subrange(handle);
+}
+
+std::vector<oriented_node_range_t> ChoppedOverlay::translate_back(const oriented_node_range_t& range) const {
+    handle_t underlying;
+    size_t offset, length;
+    get_piece_range(get_handle(std::get<0>(range), std::get<1>(range)), underlying, offset, length);
+    return {oriented_node_range_t(graph->get_id(underlying), std::get<1>(range),
+                                  offset + std::get<2>(range), std::get<3>(range))};
+}
+
+std::string ChoppedOverlay::get_back_graph_node_name(const nid_t& back_node_id) const {
+    return std::to_string(back_node_id);
+}
+
+bool ChoppedOverlay::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
+    return graph->for_each_path_handle(iteratee);
+}
+
+bool ChoppedOverlay::for_each_step_on_handle_impl(const handle_t& handle,
+                                                  const std::function<bool(const step_handle_t&)>& iteratee) const {
+    handle_t underlying;
+    size_t rank, piece;
+    decode(handle, underlying, rank, piece);
+    return graph->for_each_step_on_handle(underlying, [&](const step_handle_t& step) {
+        // Count the piece along the strand the step visits
+        bool same_strand = (graph->get_handle_of_step(step) == underlying);
+        return iteratee(pack_step(step, same_strand ? piece : get_piece_count(rank) - 1 - piece));
+    });
+}
+
+bool ChoppedOverlay::for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                                 const std::unordered_set<std::string>* samples,
+                                                 const std::unordered_set<std::string>* loci,
+                                                 const std::function<bool(const path_handle_t&)>& iteratee) const {
+    return graph->for_each_path_matching(senses, samples, loci, iteratee);
+}
+
+bool ChoppedOverlay::for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                                 const std::function<bool(const step_handle_t&)>& iteratee) const {
+    handle_t underlying;
+    size_t rank, piece;
+    decode(visited, underlying, rank, piece);
+    return graph->for_each_step_of_sense(underlying, sense, [&](const step_handle_t& step) {
+        bool same_strand = (graph->get_handle_of_step(step) == underlying);
+        return iteratee(pack_step(step, same_strand ? piece : get_piece_count(rank) - 1 - piece));
+    });
+}
+
+}
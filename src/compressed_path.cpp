@@ -0,0 +1,285 @@
+#include "handlegraph/compressed_path.hpp"
+#include "handlegraph/util.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+/** \file compressed_path.cpp
+ * Implement the CompressedPath storage component.
+ */
+
+namespace handlegraph {
+
+const size_t CompressedPath::CHECKPOINT_INTERVAL = 64;
+
+/// Map a two's complement difference to a small unsigned number.
+static inline uint64_t zigzag_encode(uint64_t value) {
+    return (value << 1) ^ (uint64_t) ((int64_t) value >> 63);
+}
+
+/// Undo zigzag_encode().
+static inline uint64_t zigzag_decode(uint64_t value) {
+    return (value >> 1) ^ (~(value & 1) + 1);
+}
+
+/// Append a varint to the end of a byte vector.
+static inline void append_varint(std::vector<uint8_t>& bytes, uint64_t value) {
+    while (value >= 0x80) {
+        bytes.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back((uint8_t) value);
+}
+
+/// Read a varint from a byte vector, and advance the offset past it.
+static inline uint64_t read_varint(const std::vector<uint8_t>& bytes, size_t& offset) {
+    uint64_t value = 0;
+    for (int shift = 0; ; shift += 7) {
+        uint8_t byte = bytes[offset++];
+        value |= (uint64_t) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+CompressedPath::CompressedPath(const std::vector<handle_t>& handles) {
+    for (auto& handle : handles) {
+        push_back(handle);
+    }
+}
+
+size_t CompressedPath::size() const {
+    return step_count;
+}
+
+bool CompressedPath::empty() const {
+    return step_count == 0;
+}
+
+void CompressedPath::read_run(size_t& offset, uint64_t& run_length, uint64_t& delta) const {
+    run_length = read_varint(bytes, offset);
+    delta = zigzag_decode(read_varint(bytes, offset));
+}
+
+void CompressedPath::write_run(uint64_t run_length, uint64_t delta) {
+    append_varint(bytes, run_length);
+    append_varint(bytes, zigzag_encode(delta));
+}
+
+void CompressedPath::find_run(size_t rank, Checkpoint& run, uint64_t& run_length, uint64_t& delta) const {
+    // Find the last checkpoint at or before the rank
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), rank, [](size_t r, const Checkpoint& c) {
+        return r < c.rank;
+    });
+    run = *(--it);
+    size_t offset = run.offset;
+    while (true) {
+        read_run(offset, run_length, delta);
+        if (rank < run.rank + run_length) {
+            return;
+        }
+        run.rank += run_length;
+        run.value += delta * run_length;
+        run.offset = offset;
+    }
+}
+
+handle_t CompressedPath::get_handle(size_t rank) const {
+    Checkpoint run;
+    uint64_t run_length, delta;
+    find_run(rank, run, run_length, delta);
+    return as_handle(run.value + delta * (rank - run.rank + 1));
+}
+
+size_t CompressedPath::decode(size_t rank, handle_t* buffer, size_t max_count) const {
+    if (rank >= step_count || max_count == 0) {
+        return 0;
+    }
+    max_count = std::min(max_count, step_count - rank);
+    
+    Checkpoint run;
+    uint64_t run_length, delta;
+    find_run(rank, run, run_length, delta);
+    
+    size_t offset = run.offset;
+    // Skip the header of the run we are in
+    read_run(offset, run_length, delta);
+    uint64_t value = run.value + delta * (rank - run.rank);
+    uint64_t remaining = run_length - (rank - run.rank);
+    
+    size_t count = 0;
+    while (true) {
+        for (; remaining > 0 && count < max_count; remaining--) {
+            value += delta;
+            buffer[count++] = as_handle(value);
+        }
+        if (count == max_count) {
+            return count;
+        }
+        read_run(offset, remaining, delta);
+    }
+}
+
+std::vector<handle_t> CompressedPath::decode() const {
+    std::vector<handle_t> handles(step_count);
+    decode(0, handles.data(), step_count);
+    return handles;
+}
+
+size_t CompressedPath::get_memory_usage() const {
+    return sizeof(*this) + bytes.capacity() + checkpoints.capacity() * sizeof(Checkpoint);
+}
+
+void CompressedPath::push_back(const handle_t& handle) {
+    uint64_t value = as_integer(handle);
+    uint64_t delta = value - last_value;
+    
+    if (last_run_length != 0 && delta == last_delta) {
+        // Extend the last run in place
+        bytes.resize(last_run_offset);
+        last_run_length++;
+    } else {
+        // Start a new run
+        if (checkpoints.empty() || step_count - checkpoints.back().rank >= CHECKPOINT_INTERVAL) {
+            checkpoints.push_back({step_count, bytes.size(), last_value});
+        }
+        last_run_offset = bytes.size();
+        last_run_length = 1;
+        last_delta = delta;
+    }
+    write_run(last_run_length, last_delta);
+    last_value = value;
+    step_count++;
+}
+
+void CompressedPath::truncate(size_t new_size) {
+    if (new_size >= step_count) {
+        return;
+    }
+    if (new_size == 0) {
+        clear();
+        return;
+    }
+    
+    // Find the run holding the new last step
+    Checkpoint run;
+    uint64_t run_length, delta;
+    find_run(new_size - 1, run, run_length, delta);
+    
+    // Cut it short
+    bytes.resize(run.offset);
+    while (!checkpoints.empty() && checkpoints.back().rank > run.rank) {
+        checkpoints.pop_back();
+    }
+    if (run.rank - checkpoints.back().rank >= CHECKPOINT_INTERVAL) {
+        // The run didn't have a checkpoint, but now it ends the path
+        checkpoints.push_back(run);
+    }
+    last_run_offset = run.offset;
+    last_run_length = new_size - run.rank;
+    last_delta = delta;
+    last_value = run.value + delta * last_run_length;
+    step_count = new_size;
+    write_run(last_run_length, last_delta);
+}
+
+void CompressedPath::rewrite(size_t begin, size_t end, const std::vector<handle_t>& replacement) {
+    if (begin > end || end > step_count) {
+        throw std::out_of_range("Cannot rewrite steps " + std::to_string(begin) + " to " + std::to_string(end) +
+                                " of a path with " + std::to_string(step_count) + " steps");
+    }
+    std::vector<handle_t> tail(step_count - end);
+    decode(end, tail.data(), tail.size());
+    truncate(begin);
+    for (auto& handle : replacement) {
+        push_back(handle);
+    }
+    for (auto& handle : tail) {
+        push_back(handle);
+    }
+}
+
+void CompressedPath::clear() {
+    bytes.clear();
+    checkpoints.clear();
+    step_count = 0;
+    last_value = 0;
+    last_run_offset = 0;
+    last_run_length = 0;
+    last_delta = 0;
+}
+
+void CompressedPath::shrink_to_fit() {
+    bytes.shrink_to_fit();
+    checkpoints.shrink_to_fit();
+}
+
+void CompressedPath::serialize(std::ostream& out) const {
+    uint64_t header[2] = {step_count, bytes.size()};
+    out.write((const char*) header, sizeof(header));
+    out.write((const char*) bytes.data(), bytes.size());
+}
+
+void CompressedPath::deserialize(std::istream& in) {
+    clear();
+    uint64_t header[2];
+    if (!in.read((char*) header, sizeof(header))) {
+        throw std::runtime_error("Could not read compressed path header");
+    }
+    bytes.resize(header[1]);
+    if (!in.read((char*) bytes.data(), bytes.size())) {
+        throw std::runtime_error("Could not read compressed path data");
+    }
+    
+    // Rebuild the checkpoints and the state of the last run
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        size_t run_offset = offset;
+        uint64_t run_length, delta;
+        for (size_t i = 0; i < 2; i++) {
+            // Make sure both varints are complete before reading them
+            while (true) {
+                if (offset == bytes.size()) {
+                    throw std::runtime_error("Compressed path data is truncated");
+                }
+                if (!(bytes[offset++] & 0x80)) {
+                    break;
+                }
+            }
+        }
+        offset = run_offset;
+        read_run(offset, run_length, delta);
+        if (run_length == 0 || step_count + run_length > header[0]) {
+            throw std::runtime_error("Compressed path data is malformed");
+        }
+        if (checkpoints.empty() || step_count - checkpoints.back().rank >= CHECKPOINT_INTERVAL) {
+            checkpoints.push_back({step_count, run_offset, last_value});
+        }
+        last_run_offset = run_offset;
+        last_run_length = run_length;
+        last_delta = delta;
+        last_value += delta * run_length;
+        step_count += run_length;
+    }
+    if (step_count != header[0]) {
+        throw std::runtime_error("Compressed path data is malformed");
+    }
+}
+
+step_handle_t CompressedPath::make_step(const path_handle_t& path, size_t rank) {
+    step_handle_t step;
+    as_integers(step)[0] = as_integer(path);
+    as_integers(step)[1] = rank;
+    return step;
+}
+
+path_handle_t CompressedPath::get_path(const step_handle_t& step) {
+    return as_path_handle(as_integers(step)[0]);
+}
+
+size_t CompressedPath::get_rank(const step_handle_t& step) {
+    return as_integers(step)[1];
+}
+
+}
@@ -73,9 +73,9 @@ void copy_path(const PathHandleGraph* from, const path_handle_t& from_path,
                MutablePathHandleGraph* into, const path_handle_t& into_path) {
     
     // copy steps
-    for (handle_t handle : from->scan_path(from_path)) {
+    from->for_each_handle_in_path(from_path, [&](const handle_t& handle) {
         into->append_step(into_path, into->get_handle(from->get_id(handle), from->get_is_reverse(handle)));
-    }
+    });
 }
 
 }
@@ -8,8 +8,10 @@
 #include <vector>
 #include <unordered_set>
 #include <atomic>
+#include <algorithm>
 
 #include "handlegraph/expanding_overlay_graph.hpp"
+#include "handlegraph/execution.hpp"
 #include "handlegraph/algorithms/dagify.hpp"
 #include "handlegraph/algorithms/is_single_stranded.hpp"
 #include "handlegraph/algorithms/strongly_connected_components.hpp"
@@ -21,6 +23,9 @@ namespace algorithms {
 
 using namespace std;
 
+/// Number of nodes handed to a thread at a time when looping in parallel.
+static const size_t NODE_BLOCK_SIZE = 4096;
+
 // TODO: ugly copypasta
 
 class SubHandleGraph : public ExpandingOverlayGraph {
@@ -163,13 +168,26 @@ bool SubHandleGraph::follow_edges_impl(const handle_t& handle, bool go_left, con
 }
 
 bool SubHandleGraph::for_each_handle_impl(const function<bool(const handle_t&)>& iteratee, bool parallel) const {
-    // non-parallel so we don't pull in any dependencies
-    for (nid_t node_id : contents) {
-        if (!iteratee(super->get_handle(node_id))) {
-            return false;
+    if (!parallel || contents.size() < 2 * NODE_BLOCK_SIZE) {
+        for (nid_t node_id : contents) {
+            if (!iteratee(super->get_handle(node_id))) {
+                return false;
+            }
         }
+        return true;
     }
-    return true;
+    // The set can't be split up, so hand out blocks of a copy
+    vector<nid_t> node_ids(contents.begin(), contents.end());
+    atomic<bool> keep_going(true);
+    ExecutionOptions().parallel_for((node_ids.size() + NODE_BLOCK_SIZE - 1) / NODE_BLOCK_SIZE, [&](size_t block) {
+        size_t block_end = min(node_ids.size(), (block + 1) * NODE_BLOCK_SIZE);
+        for (size_t i = block * NODE_BLOCK_SIZE; i < block_end && keep_going.load(); i++) {
+            if (!iteratee(super->get_handle(node_ids[i]))) {
+                keep_going.store(false);
+            }
+        }
+    });
+    return keep_going.load();
 }
 
 size_t SubHandleGraph::get_node_count() const {
@@ -0,0 +1,938 @@
+#include "handlegraph/disk_graph.hpp"
+#include "handlegraph/util.hpp"
+#include "handlegraph/algorithms/internal/parallel.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+
+/** \file disk_graph.cpp
+ * Implement the disk-backed graph and its builder.
+ */
+
+namespace handlegraph {
+
+const uint32_t DiskGraph::MAGIC_NUMBER = 0x44475248; // "HRGD"
+const uint32_t DiskGraph::FORMAT_VERSION = 2;
+const size_t DiskGraph::DEFAULT_BUILD_MEMORY = 1024 * 1024 * 1024;
+
+/// Number of node table entries handed out at a time when looping over nodes
+static const size_t TABLE_BLOCK_SIZE = 4096;
+
+/// Number of steps read at a time when looping over the steps on a node, or
+/// scanning path steps while building
+static const size_t STEP_READ_SIZE = 4096;
+
+/// Bytes to collect before writing while building
+static const size_t WRITE_BUFFER_SIZE = 1024 * 1024;
+
+/// Numbers in each spill file entry: node ID, path number, and rank
+static const size_t SPILL_ENTRY_SIZE = 3;
+
+/// Throw a runtime_error describing errno, for the given action on the given file
+static void throw_errno(const std::string& action, const std::string& filename) {
+    throw std::runtime_error("error:[DiskGraph] could not " + action + " " + filename + ": " + ::strerror(errno));
+}
+
+/// Write all of the given bytes at the given offset in a file.
+static void write_fully(int fd, const char* data, size_t length, uint64_t offset) {
+    while (length != 0) {
+        ssize_t result = ::pwrite(fd, data, length, offset);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            throw_errno("write to", "graph file");
+        }
+        data += result;
+        length -= result;
+        offset += result;
+    }
+}
+
+/// Read all of the given bytes from the given offset in a file.
+static void read_fully(int fd, char* data, size_t length, uint64_t offset) {
+    while (length != 0) {
+        ssize_t result = ::pread(fd, data, length, offset);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            throw_errno("read back", "graph file");
+        }
+        data += result;
+        length -= result;
+        offset += result;
+    }
+}
+
+/// Writes a section of a file sequentially, through a buffer.
+class SectionWriter {
+public:
+    SectionWriter(int fd, uint64_t offset, size_t buffer_size = WRITE_BUFFER_SIZE) :
+        fd(fd), offset(offset), buffer_size(buffer_size) {
+        buffer.reserve(buffer_size);
+    }
+
+    void write(const void* data, size_t length) {
+        const char* bytes = (const char*) data;
+        buffer.insert(buffer.end(), bytes, bytes + length);
+        if (buffer.size() >= buffer_size) {
+            flush();
+        }
+    }
+
+    void write_number(uint64_t value) {
+        write(&value, sizeof(value));
+    }
+
+    void flush() {
+        write_fully(fd, buffer.data(), buffer.size(), offset);
+        offset += buffer.size();
+        buffer.clear();
+    }
+
+    /// Get the offset in the file that will be written next
+    uint64_t tell() const {
+        return offset + buffer.size();
+    }
+
+private:
+    int fd;
+    uint64_t offset;
+    size_t buffer_size;
+    std::vector<char> buffer;
+};
+
+/// Complement a base, leaving anything unusual as N
+static char complement(char base) {
+    switch (base) {
+    case 'A': return 'T';
+    case 'C': return 'G';
+    case 'G': return 'C';
+    case 'T': return 'A';
+    case 'a': return 't';
+    case 'c': return 'g';
+    case 'g': return 'c';
+    case 't': return 'a';
+    default: return 'N';
+    }
+}
+
+/// Reverse complement a sequence in place
+static void reverse_complement_in_place(std::string& sequence) {
+    std::reverse(sequence.begin(), sequence.end());
+    for (char& base : sequence) {
+        base = complement(base);
+    }
+}
+
+void DiskGraph::build(const HandleGraph* graph, const std::string& filename, size_t build_memory) {
+    const PathHandleGraph* path_graph = dynamic_cast<const PathHandleGraph*>(graph);
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic_number = MAGIC_NUMBER;
+    header.format_version = FORMAT_VERSION;
+    header.node_count = graph->get_node_count();
+    header.edge_count = graph->get_edge_count();
+    header.total_length = graph->get_total_length();
+    // An empty graph gets an empty ID range
+    header.min_id = 1;
+    header.max_id = 0;
+    if (header.node_count != 0) {
+        header.min_id = graph->min_node_id();
+        header.max_id = graph->max_node_id();
+        if (header.min_id < 0) {
+            throw std::runtime_error("error:[DiskGraph] cannot store negative node ID " + std::to_string(header.min_id));
+        }
+    }
+
+    // Keep paths of every sense, haplotypes included, with their metadata
+    std::vector<path_handle_t> path_handles;
+    std::vector<PathRecord> records;
+    bool has_haplotypes = false;
+    if (path_graph != nullptr) {
+        path_graph->for_each_path_matching(nullptr, nullptr, nullptr, [&](const path_handle_t& path) {
+            path_handles.push_back(path);
+            records.emplace_back();
+            records.back().name = path_graph->get_path_name(path);
+            records.back().sense = path_graph->get_sense(path);
+            records.back().sample = path_graph->get_sample_name(path);
+            records.back().locus = path_graph->get_locus_name(path);
+            records.back().haplotype = path_graph->get_haplotype(path);
+            records.back().phase_block = path_graph->get_phase_block(path);
+            records.back().subrange = path_graph->get_subrange(path);
+            records.back().is_circular = path_graph->get_is_circular(path);
+            has_haplotypes |= (records.back().sense == PathSense::HAPLOTYPE);
+            records.back().step_count = path_graph->get_step_count(path);
+            records.back().first_step = header.step_count;
+            header.step_count += records.back().step_count;
+        });
+    }
+    header.path_count = records.size();
+
+    // Everything but the node records and path directory has a size we know
+    size_t table_size = header.max_id >= header.min_id ? header.max_id - header.min_id + 1 : 0;
+    header.node_table_offset = sizeof(Header);
+    header.node_steps_offset = header.node_table_offset + table_size * sizeof(uint64_t);
+    header.path_handles_offset = header.node_steps_offset + header.step_count * 2 * sizeof(uint64_t);
+    header.path_positions_offset = header.path_handles_offset + header.step_count * sizeof(uint64_t);
+    header.node_records_offset = header.path_positions_offset + header.step_count * sizeof(uint64_t);
+
+    // Split the node IDs into chunks whose steps fit in the build memory,
+    // and find the first step of each chunk.
+    // Graphs may hide haplotype steps from get_step_count(), so if there are
+    // any we count the steps of each sense instead.
+    auto get_node_step_count = [&](nid_t id) -> size_t {
+        if (path_graph == nullptr || !graph->has_node(id)) {
+            return 0;
+        }
+        handle_t handle = graph->get_handle(id);
+        if (!has_haplotypes) {
+            return path_graph->get_step_count(handle);
+        }
+        size_t count = 0;
+        for (auto& sense : {PathSense::REFERENCE, PathSense::GENERIC, PathSense::HAPLOTYPE}) {
+            path_graph->for_each_step_of_sense(handle, sense, [&](const step_handle_t&) {
+                count++;
+            });
+        }
+        return count;
+    };
+    size_t chunk_limit = std::max<size_t>(build_memory / (2 * sizeof(uint64_t)), 1);
+    std::vector<nid_t> chunk_ends;
+    std::vector<uint64_t> chunk_first_steps(1, 0);
+    if (table_size != 0) {
+        nid_t chunk_start = header.min_id;
+        size_t chunk_steps = 0;
+        for (nid_t id = header.min_id; id <= header.max_id; id++) {
+            size_t count = get_node_step_count(id);
+            if (id != chunk_start && chunk_steps + count > chunk_limit) {
+                chunk_ends.push_back(id);
+                chunk_first_steps.push_back(chunk_first_steps.back() + chunk_steps);
+                chunk_start = id;
+                chunk_steps = 0;
+            }
+            chunk_steps += count;
+        }
+        chunk_ends.push_back(header.max_id + 1);
+        chunk_first_steps.push_back(chunk_first_steps.back() + chunk_steps);
+    }
+
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw_errno("create", filename);
+    }
+    // Steps are inverted through a spill file, which is unlinked as soon as
+    // it is made so it goes away however we finish.
+    int spill_fd = -1;
+    try {
+        std::string spill_filename = filename + ".steps.tmp";
+        if (chunk_first_steps.back() != 0) {
+            spill_fd = ::open(spill_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+            if (spill_fd < 0) {
+                throw_errno("create", spill_filename);
+            }
+            if (::unlink(spill_filename.c_str()) != 0) {
+                throw_errno("remove", spill_filename);
+            }
+        }
+
+        // Write out the paths' handles and positions, and sort each step
+        // into its chunk's part of the spill file, in path and then rank
+        // order. The spill buffers share the build memory.
+        SectionWriter handles(fd, header.path_handles_offset);
+        SectionWriter positions(fd, header.path_positions_offset);
+        std::vector<SectionWriter> spills;
+        std::vector<uint64_t> spilled;
+        if (spill_fd >= 0) {
+            size_t spill_buffer_size = std::min(WRITE_BUFFER_SIZE,
+                                                std::max(SPILL_ENTRY_SIZE * sizeof(uint64_t),
+                                                         build_memory / chunk_ends.size()));
+            spills.reserve(chunk_ends.size());
+            for (size_t chunk = 0; chunk < chunk_ends.size(); chunk++) {
+                spills.emplace_back(spill_fd, chunk_first_steps[chunk] * SPILL_ENTRY_SIZE * sizeof(uint64_t),
+                                    spill_buffer_size);
+            }
+            spilled = chunk_first_steps;
+        }
+        for (size_t i = 0; i < records.size(); i++) {
+            size_t position = 0;
+            size_t count = 0;
+            path_graph->for_each_handle_in_path(path_handles[i], [&](const handle_t& handle) {
+                nid_t id = graph->get_id(handle);
+                handles.write_number(as_integer(number_bool_packing::pack(id, graph->get_is_reverse(handle))));
+                positions.write_number(position);
+                if (!spills.empty() && id >= header.min_id && id <= header.max_id) {
+                    size_t chunk = std::upper_bound(chunk_ends.begin(), chunk_ends.end(), id) - chunk_ends.begin();
+                    if (spilled[chunk] == chunk_first_steps[chunk + 1]) {
+                        throw std::runtime_error("error:[DiskGraph] node " + std::to_string(id)
+                                                 + " has more path steps than it claims");
+                    }
+                    uint64_t entry[SPILL_ENTRY_SIZE] = {(uint64_t) id, i, count};
+                    spills[chunk].write(entry, sizeof(entry));
+                    spilled[chunk]++;
+                }
+                position += graph->get_length(handle);
+                count++;
+            });
+            if (count != records[i].step_count) {
+                throw std::runtime_error("error:[DiskGraph] path " + records[i].name + " has " + std::to_string(count)
+                                         + " steps but claims " + std::to_string(records[i].step_count));
+            }
+            records[i].length = position;
+        }
+        handles.flush();
+        positions.flush();
+        for (auto& spill : spills) {
+            spill.flush();
+        }
+        spills.clear();
+
+        // Write out the nodes, a chunk of IDs at a time, gathering the steps
+        // on each chunk from its part of the spill file.
+        SectionWriter table(fd, header.node_table_offset);
+        SectionWriter node_steps(fd, header.node_steps_offset);
+        SectionWriter node_records(fd, header.node_records_offset);
+        uint64_t next_node_step = 0;
+        std::vector<uint64_t> buffer(STEP_READ_SIZE * SPILL_ENTRY_SIZE);
+        for (size_t chunk = 0; chunk < chunk_ends.size(); chunk++) {
+            nid_t chunk_start = chunk == 0 ? header.min_id : chunk_ends[chunk - 1];
+            nid_t chunk_end = chunk_ends[chunk];
+            size_t chunk_steps = chunk_first_steps[chunk + 1] - chunk_first_steps[chunk];
+            std::vector<size_t> counts(chunk_end - chunk_start);
+            for (size_t index = 0; index < counts.size(); index++) {
+                counts[index] = get_node_step_count(chunk_start + index);
+            }
+
+            std::vector<size_t> starts(counts.size());
+            for (size_t i = 1; i < counts.size(); i++) {
+                starts[i] = starts[i - 1] + counts[i - 1];
+            }
+            std::vector<size_t> filled = starts;
+            std::vector<uint64_t> entries(2 * chunk_steps);
+            size_t chunk_spilled = spill_fd >= 0 ? spilled[chunk] - chunk_first_steps[chunk] : 0;
+            for (size_t done = 0; done < chunk_spilled; done += STEP_READ_SIZE) {
+                size_t count = std::min(STEP_READ_SIZE, chunk_spilled - done);
+                read_fully(spill_fd, (char*) buffer.data(), count * SPILL_ENTRY_SIZE * sizeof(uint64_t),
+                           (chunk_first_steps[chunk] + done) * SPILL_ENTRY_SIZE * sizeof(uint64_t));
+                for (size_t j = 0; j < count; j++) {
+                    const uint64_t* entry = &buffer[j * SPILL_ENTRY_SIZE];
+                    size_t index = entry[0] - chunk_start;
+                    if (filled[index] == starts[index] + counts[index]) {
+                        throw std::runtime_error("error:[DiskGraph] node " + std::to_string(entry[0])
+                                                 + " has more path steps than it claims");
+                    }
+                    entries[2 * filled[index]] = entry[1];
+                    entries[2 * filled[index] + 1] = entry[2];
+                    filled[index]++;
+                }
+            }
+            for (size_t index = 0; index < counts.size(); index++) {
+                if (filled[index] != starts[index] + counts[index]) {
+                    throw std::runtime_error("error:[DiskGraph] node " + std::to_string(chunk_start + index)
+                                             + " has fewer path steps than it claims");
+                }
+            }
+            node_steps.write(entries.data(), entries.size() * sizeof(uint64_t));
+
+            for (size_t index = 0; index < counts.size(); index++) {
+                nid_t id = chunk_start + index;
+                if (!graph->has_node(id)) {
+                    table.write_number(0);
+                    continue;
+                }
+                table.write_number(node_records.tell() - header.node_records_offset + 1);
+
+                handle_t handle = graph->get_handle(id);
+                std::vector<uint64_t> edges;
+                size_t left_degree = 0;
+                for (bool go_left : {true, false}) {
+                    graph->follow_edges(handle, go_left, [&](const handle_t& other) {
+                        edges.push_back(as_integer(number_bool_packing::pack(graph->get_id(other),
+                                                                             graph->get_is_reverse(other))));
+                    });
+                    if (go_left) {
+                        left_degree = edges.size();
+                    }
+                }
+                std::string sequence = graph->get_sequence(handle);
+
+                NodeRecord record;
+                record.length = sequence.size();
+                record.left_degree = left_degree;
+                record.right_degree = edges.size() - record.left_degree;
+                record.step_count = counts[index];
+                record.first_step = next_node_step;
+                next_node_step += counts[index];
+                node_records.write(&record, sizeof(record));
+                node_records.write(edges.data(), edges.size() * sizeof(uint64_t));
+                node_records.write(sequence.data(), sequence.size());
+            }
+        }
+        table.flush();
+        node_steps.flush();
+        node_records.flush();
+
+        header.path_directory_offset = node_records.tell();
+        SectionWriter directory(fd, header.path_directory_offset);
+        for (auto& record : records) {
+            directory.write_number(record.step_count);
+            directory.write_number(record.length);
+            directory.write_number(record.first_step);
+            directory.write_number(record.is_circular);
+            directory.write_number((uint64_t) record.sense);
+            directory.write_number(record.haplotype);
+            directory.write_number(record.phase_block);
+            directory.write_number(record.subrange.first);
+            directory.write_number(record.subrange.second);
+            for (const std::string* text : {&record.name, &record.sample, &record.locus}) {
+                directory.write_number(text->size());
+                directory.write(text->data(), text->size());
+            }
+        }
+        header.file_size = directory.tell();
+        directory.flush();
+
+        // Only write the header once everything it describes is there
+        write_fully(fd, (const char*) &header, sizeof(header), 0);
+    } catch (...) {
+        if (spill_fd >= 0) {
+            ::close(spill_fd);
+        }
+        ::close(fd);
+        throw;
+    }
+    if (spill_fd >= 0) {
+        ::close(spill_fd);
+    }
+    if (::close(fd) != 0) {
+        throw_errno("close", filename);
+    }
+}
+
+DiskGraph::DiskGraph(const std::string& filename, size_t memory_budget, size_t page_size, size_t read_ahead_pages) {
+    fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw_errno("open", filename);
+    }
+    try {
+        buffers.reset(new BufferManager(fd, memory_budget, page_size, read_ahead_pages));
+        if (buffers->get_file_size() < sizeof(Header)) {
+            throw std::runtime_error("error:[DiskGraph] " + filename + " is not a disk graph");
+        }
+        buffers->read(0, sizeof(Header), &header);
+        if (header.magic_number != MAGIC_NUMBER) {
+            throw std::runtime_error("error:[DiskGraph] " + filename + " is not a disk graph");
+        }
+        if (header.format_version != FORMAT_VERSION) {
+            throw std::runtime_error("error:[DiskGraph] " + filename + " is format version "
+                                     + std::to_string(header.format_version) + " but we read version "
+                                     + std::to_string(FORMAT_VERSION));
+        }
+        if (header.file_size != buffers->get_file_size()) {
+            throw std::runtime_error("error:[DiskGraph] " + filename + " is truncated or incomplete");
+        }
+
+        // Load the path directory
+        std::vector<char> directory(header.file_size - header.path_directory_offset);
+        buffers->read(header.path_directory_offset, directory.size(), directory.data());
+        size_t cursor = 0;
+        auto take_number = [&]() {
+            uint64_t value;
+            memcpy(&value, directory.data() + cursor, sizeof(value));
+            cursor += sizeof(value);
+            return value;
+        };
+        paths.resize(header.path_count);
+        for (size_t i = 0; i < paths.size(); i++) {
+            paths[i].step_count = take_number();
+            paths[i].length = take_number();
+            paths[i].first_step = take_number();
+            paths[i].is_circular = take_number();
+            paths[i].sense = (PathSense) take_number();
+            paths[i].haplotype = take_number();
+            paths[i].phase_block = take_number();
+            paths[i].subrange.first = take_number();
+            paths[i].subrange.second = take_number();
+            for (std::string* text : {&paths[i].name, &paths[i].sample, &paths[i].locus}) {
+                size_t length = take_number();
+                text->assign(directory.data() + cursor, length);
+                cursor += length;
+            }
+            path_indexes[paths[i].name] = i;
+            if (paths[i].sense != PathSense::HAPLOTYPE) {
+                visible_path_count++;
+            }
+        }
+    } catch (...) {
+        buffers.reset();
+        ::close(fd);
+        throw;
+    }
+}
+
+DiskGraph::~DiskGraph() {
+    // Stop reading ahead before the file goes away
+    buffers.reset();
+    ::close(fd);
+}
+
+const BufferManager& DiskGraph::get_buffer_manager() const {
+    return *buffers;
+}
+
+uint64_t DiskGraph::read_number(uint64_t offset) const {
+    uint64_t value;
+    buffers->read(offset, sizeof(value), &value);
+    return value;
+}
+
+size_t DiskGraph::get_table_size() const {
+    return header.max_id >= header.min_id ? header.max_id - header.min_id + 1 : 0;
+}
+
+uint64_t DiskGraph::get_record_offset(nid_t node_id) const {
+    if (node_id < header.min_id || node_id > header.max_id) {
+        return 0;
+    }
+    uint64_t entry = read_number(header.node_table_offset + (node_id - header.min_id) * sizeof(uint64_t));
+    return entry == 0 ? 0 : header.node_records_offset + entry - 1;
+}
+
+DiskGraph::NodeRecord DiskGraph::get_record(nid_t node_id, uint64_t& offset) const {
+    offset = get_record_offset(node_id);
+    if (offset == 0) {
+        throw std::runtime_error("error:[DiskGraph] no node " + std::to_string(node_id));
+    }
+    NodeRecord record;
+    buffers->read(offset, sizeof(record), &record);
+    return record;
+}
+
+step_handle_t DiskGraph::make_step(size_t path_index, int64_t rank) {
+    step_handle_t step;
+    as_integers(step)[0] = path_index;
+    as_integers(step)[1] = rank;
+    return step;
+}
+
+bool DiskGraph::has_node(nid_t node_id) const {
+    return get_record_offset(node_id) != 0;
+}
+
+handle_t DiskGraph::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(node_id, is_reverse);
+}
+
+nid_t DiskGraph::get_id(const handle_t& handle) const {
+    return number_bool_packing::unpack_number(handle);
+}
+
+bool DiskGraph::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t DiskGraph::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t DiskGraph::get_length(const handle_t& handle) const {
+    uint64_t offset;
+    return get_record(get_id(handle), offset).length;
+}
+
+std::string DiskGraph::get_sequence(const handle_t& handle) const {
+    return get_subsequence(handle, 0, std::numeric_limits<size_t>::max());
+}
+
+size_t DiskGraph::get_node_count() const {
+    return header.node_count;
+}
+
+nid_t DiskGraph::min_node_id() const {
+    return header.min_id;
+}
+
+nid_t DiskGraph::max_node_id() const {
+    return header.max_id;
+}
+
+size_t DiskGraph::get_degree(const handle_t& handle, bool go_left) const {
+    uint64_t offset;
+    NodeRecord record = get_record(get_id(handle), offset);
+    // The reverse strand's left side is the forward strand's right side
+    return go_left != get_is_reverse(handle) ? record.left_degree : record.right_degree;
+}
+
+size_t DiskGraph::get_edge_count() const {
+    return header.edge_count;
+}
+
+size_t DiskGraph::get_total_length() const {
+    return header.total_length;
+}
+
+char DiskGraph::get_base(const handle_t& handle, size_t index) const {
+    return get_subsequence(handle, index, 1).at(0);
+}
+
+std::string DiskGraph::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    uint64_t offset;
+    NodeRecord record = get_record(get_id(handle), offset);
+    if (index >= record.length) {
+        return "";
+    }
+    size = std::min<size_t>(size, record.length - index);
+    bool is_reverse = get_is_reverse(handle);
+    size_t start = is_reverse ? record.length - index - size : index;
+    std::string sequence(size, 'N');
+    buffers->read(offset + sizeof(NodeRecord) + (record.left_degree + record.right_degree) * sizeof(uint64_t) + start,
+                  size, &sequence[0]);
+    if (is_reverse) {
+        reverse_complement_in_place(sequence);
+    }
+    return sequence;
+}
+
+bool DiskGraph::has_efficient_cursors() const {
+    return true;
+}
+
+size_t DiskGraph::get_next_handles(uint64_t& cursor, handle_t* buffer, size_t max_handles) const {
+    // The cursor is the index in the node table to look at next
+    size_t table_size = get_table_size();
+    size_t count = 0;
+    std::vector<uint64_t> entries;
+    while (count < max_handles && cursor < table_size) {
+        entries.resize(std::min<size_t>(TABLE_BLOCK_SIZE, table_size - cursor));
+        buffers->read(header.node_table_offset + cursor * sizeof(uint64_t), entries.size() * sizeof(uint64_t),
+                      entries.data());
+        size_t i = 0;
+        for (; i < entries.size() && count < max_handles; i++) {
+            if (entries[i] != 0) {
+                buffer[count++] = get_handle(header.min_id + cursor + i);
+            }
+        }
+        cursor += i;
+    }
+    return count;
+}
+
+size_t DiskGraph::get_next_neighbors(const handle_t& handle, bool go_left, uint64_t& cursor,
+                                     handle_t* buffer, size_t max_handles) const {
+    uint64_t offset;
+    NodeRecord record = get_record(get_id(handle), offset);
+    bool is_reverse = get_is_reverse(handle);
+    bool stored_left = go_left != is_reverse;
+    size_t degree = stored_left ? record.left_degree : record.right_degree;
+    if (cursor >= degree) {
+        return 0;
+    }
+    size_t count = std::min<size_t>(max_handles, degree - cursor);
+    buffers->read(offset + sizeof(NodeRecord) + ((stored_left ? 0 : record.left_degree) + cursor) * sizeof(uint64_t),
+                  count * sizeof(uint64_t), buffer);
+    if (is_reverse) {
+        for (size_t i = 0; i < count; i++) {
+            buffer[i] = flip(buffer[i]);
+        }
+    }
+    cursor += count;
+    return count;
+}
+
+bool DiskGraph::follow_edges_impl(const handle_t& handle, bool go_left,
+                                  const std::function<bool(const handle_t&)>& iteratee) const {
+    uint64_t offset;
+    NodeRecord record = get_record(get_id(handle), offset);
+    bool is_reverse = get_is_reverse(handle);
+    // Edges are stored from the forward strand, so the reverse strand's left
+    // side is the flipped right side
+    bool stored_left = go_left != is_reverse;
+    std::vector<uint64_t> edges(stored_left ? record.left_degree : record.right_degree);
+    buffers->read(offset + sizeof(NodeRecord) + (stored_left ? 0 : record.left_degree) * sizeof(uint64_t),
+                  edges.size() * sizeof(uint64_t), edges.data());
+    for (uint64_t& edge : edges) {
+        handle_t other = as_handle(edge);
+        if (!iteratee(is_reverse ? flip(other) : other)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DiskGraph::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    size_t table_size = get_table_size();
+    size_t block_count = (table_size + TABLE_BLOCK_SIZE - 1) / TABLE_BLOCK_SIZE;
+    auto scan_block = [&](size_t block) {
+        size_t first = block * TABLE_BLOCK_SIZE;
+        std::vector<uint64_t> entries(std::min(TABLE_BLOCK_SIZE, table_size - first));
+        buffers->read(header.node_table_offset + first * sizeof(uint64_t), entries.size() * sizeof(uint64_t),
+                      entries.data());
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (entries[i] != 0 && !iteratee(get_handle(header.min_id + first + i))) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (!parallel) {
+        for (size_t block = 0; block < block_count; block++) {
+            if (!scan_block(block)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::atomic<bool> keep_going(true);
+    algorithms::internal::parallel_for(block_count, 0, [&](size_t block) {
+        if (keep_going.load() && !scan_block(block)) {
+            keep_going.store(false);
+        }
+    });
+    return keep_going.load();
+}
+
+size_t DiskGraph::get_path_count() const {
+    return visible_path_count;
+}
+
+bool DiskGraph::has_path(const std::string& path_name) const {
+    return path_indexes.count(path_name);
+}
+
+path_handle_t DiskGraph::get_path_handle(const std::string& path_name) const {
+    auto found = path_indexes.find(path_name);
+    if (found == path_indexes.end()) {
+        throw std::runtime_error("error:[DiskGraph] no path named " + path_name);
+    }
+    return as_path_handle(found->second);
+}
+
+std::string DiskGraph::get_path_name(const path_handle_t& path_handle) const {
+    return paths.at(as_integer(path_handle)).name;
+}
+
+bool DiskGraph::get_is_circular(const path_handle_t& path_handle) const {
+    return paths.at(as_integer(path_handle)).is_circular;
+}
+
+size_t DiskGraph::get_step_count(const path_handle_t& path_handle) const {
+    return paths.at(as_integer(path_handle)).step_count;
+}
+
+size_t DiskGraph::get_step_count(const handle_t& handle) const {
+    uint64_t offset;
+    return get_record(get_id(handle), offset).step_count;
+}
+
+handle_t DiskGraph::get_handle_of_step(const step_handle_t& step_handle) const {
+    const PathRecord& path = paths.at(as_integers(step_handle)[0]);
+    uint64_t value = read_number(header.path_handles_offset
+                                 + (path.first_step + as_integers(step_handle)[1]) * sizeof(uint64_t));
+    return as_handle(value);
+}
+
+path_handle_t DiskGraph::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    return as_path_handle(as_integers(step_handle)[0]);
+}
+
+step_handle_t DiskGraph::path_begin(const path_handle_t& path_handle) const {
+    return make_step(as_integer(path_handle), 0);
+}
+
+step_handle_t DiskGraph::path_end(const path_handle_t& path_handle) const {
+    return make_step(as_integer(path_handle), get_step_count(path_handle));
+}
+
+step_handle_t DiskGraph::path_back(const path_handle_t& path_handle) const {
+    return make_step(as_integer(path_handle), (int64_t) get_step_count(path_handle) - 1);
+}
+
+step_handle_t DiskGraph::path_front_end(const path_handle_t& path_handle) const {
+    return make_step(as_integer(path_handle), -1);
+}
+
+bool DiskGraph::has_next_step(const step_handle_t& step_handle) const {
+    const PathRecord& path = paths.at(as_integers(step_handle)[0]);
+    return path.is_circular || as_integers(step_handle)[1] + 1 < (int64_t) path.step_count;
+}
+
+bool DiskGraph::has_previous_step(const step_handle_t& step_handle) const {
+    const PathRecord& path = paths.at(as_integers(step_handle)[0]);
+    return path.is_circular || as_integers(step_handle)[1] > 0;
+}
+
+step_handle_t DiskGraph::get_next_step(const step_handle_t& step_handle) const {
+    size_t path_index = as_integers(step_handle)[0];
+    int64_t rank = as_integers(step_handle)[1] + 1;
+    if (rank == (int64_t) paths.at(path_index).step_count && paths[path_index].is_circular) {
+        rank = 0;
+    }
+    return make_step(path_index, rank);
+}
+
+step_handle_t DiskGraph::get_previous_step(const step_handle_t& step_handle) const {
+    size_t path_index = as_integers(step_handle)[0];
+    int64_t rank = as_integers(step_handle)[1] - 1;
+    if (rank == -1 && paths.at(path_index).is_circular) {
+        rank = paths[path_index].step_count - 1;
+    }
+    return make_step(path_index, rank);
+}
+
+size_t DiskGraph::get_step_handles(const path_handle_t& path, step_handle_t& step,
+                                   handle_t* buffer, size_t max_steps) const {
+    const PathRecord& record = paths.at(as_integer(path));
+    int64_t rank = as_integers(step)[1];
+    if (rank >= (int64_t) record.step_count) {
+        return 0;
+    }
+    size_t count = std::min<size_t>(max_steps, record.step_count - rank);
+    buffers->read(header.path_handles_offset + (record.first_step + rank) * sizeof(uint64_t),
+                  count * sizeof(uint64_t), buffer);
+    as_integers(step)[1] = rank + count;
+    return count;
+}
+
+size_t DiskGraph::get_next_steps_on_handle(const handle_t& handle, uint64_t& cursor,
+                                           step_handle_t* buffer, size_t max_steps) const {
+    uint64_t offset;
+    NodeRecord record = get_record(get_id(handle), offset);
+    if (cursor >= record.step_count) {
+        return 0;
+    }
+    std::vector<uint64_t> entries(2 * std::min<size_t>(max_steps, record.step_count - cursor));
+    buffers->read(header.node_steps_offset + (record.first_step + cursor) * 2 * sizeof(uint64_t),
+                  entries.size() * sizeof(uint64_t), entries.data());
+    for (size_t i = 0; i < entries.size(); i += 2) {
+        buffer[i / 2] = make_step(entries[i], entries[i + 1]);
+    }
+    cursor += entries.size() / 2;
+    return entries.size() / 2;
+}
+
+size_t DiskGraph::get_path_length(const path_handle_t& path_handle) const {
+    return paths.at(as_integer(path_handle)).length;
+}
+
+size_t DiskGraph::get_position_of_step(const step_handle_t& step) const {
+    const PathRecord& path = paths.at(as_integers(step)[0]);
+    size_t rank = as_integers(step)[1];
+    if (rank == path.step_count) {
+        return path.length;
+    }
+    return read_number(header.path_positions_offset + (path.first_step + rank) * sizeof(uint64_t));
+}
+
+step_handle_t DiskGraph::get_step_at_position(const path_handle_t& path, const size_t& position) const {
+    const PathRecord& record = paths.at(as_integer(path));
+    if (position >= record.length) {
+        return path_end(path);
+    }
+    // Find the last step starting at or before the position, which is the
+    // one covering it even if there are empty nodes.
+    size_t low = 0;
+    size_t high = record.step_count - 1;
+    while (low < high) {
+        size_t middle = low + (high - low + 1) / 2;
+        if (read_number(header.path_positions_offset + (record.first_step + middle) * sizeof(uint64_t)) <= position) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return make_step(as_integer(path), low);
+}
+
+bool DiskGraph::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (paths[i].sense != PathSense::HAPLOTYPE && !iteratee(as_path_handle(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DiskGraph::for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                            const std::unordered_set<std::string>* samples,
+                                            const std::unordered_set<std::string>* loci,
+                                            const std::function<bool(const path_handle_t&)>& iteratee) const {
+    for (size_t i = 0; i < paths.size(); i++) {
+        if ((senses && !senses->count(paths[i].sense)) ||
+            (samples && !samples->count(paths[i].sample)) ||
+            (loci && !loci->count(paths[i].locus))) {
+            continue;
+        }
+        if (!iteratee(as_path_handle(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DiskGraph::for_each_step_on_handle_impl(const handle_t& handle,
+                                             const std::function<bool(const step_handle_t&)>& iteratee) const {
+    return for_each_stored_step(handle, [&](const step_handle_t& step) {
+        return paths[as_integers(step)[0]].sense == PathSense::HAPLOTYPE || iteratee(step);
+    });
+}
+
+bool DiskGraph::for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                            const std::function<bool(const step_handle_t&)>& iteratee) const {
+    return for_each_stored_step(visited, [&](const step_handle_t& step) {
+        return paths[as_integers(step)[0]].sense != sense || iteratee(step);
+    });
+}
+
+PathSense DiskGraph::get_sense(const path_handle_t& handle) const {
+    return paths.at(as_integer(handle)).sense;
+}
+
+std::string DiskGraph::get_sample_name(const path_handle_t& handle) const {
+    return paths.at(as_integer(handle)).sample;
+}
+
+std::string DiskGraph::get_locus_name(const path_handle_t& handle) const {
+    return paths.at(as_integer(handle)).locus;
+}
+
+size_t DiskGraph::get_haplotype(const path_handle_t& handle) const {
+    return paths.at(as_integer(handle)).haplotype;
+}
+
+size_t DiskGraph::get_phase_block(const path_handle_t& handle) const {
+    return paths.at(as_integer(handle)).phase_block;
+}
+
+subrange_t DiskGraph::get_subrange(const path_handle_t& handle) const {
+    return paths.at(as_integer(handle)).subrange;
+}
+
+bool DiskGraph::for_each_stored_step(const handle_t& handle,
+                                     const std::function<bool(const step_handle_t&)>& iteratee) const {
+    uint64_t offset;
+    NodeRecord record = get_record(get_id(handle), offset);
+    std::vector<uint64_t> entries;
+    for (size_t i = 0; i < record.step_count; i += STEP_READ_SIZE) {
+        entries.resize(2 * std::min(STEP_READ_SIZE, record.step_count - i));
+        buffers->read(header.node_steps_offset + (record.first_step + i) * 2 * sizeof(uint64_t),
+                      entries.size() * sizeof(uint64_t), entries.data());
+        for (size_t j = 0; j < entries.size(); j += 2) {
+            if (!iteratee(make_step(entries[j], entries[j + 1]))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,135 @@
+#include "handlegraph/elias_fano.hpp"
+
+#include <algorithm>
+
+/** \file elias_fano.cpp
+ * Implement the EliasFanoSequence storage component.
+ */
+
+namespace handlegraph {
+
+const size_t EliasFanoSequence::SAMPLE_INTERVAL = 256;
+
+EliasFanoSequence::EliasFanoSequence(const std::vector<uint64_t>& values) : count(values.size()) {
+    if (count == 0) {
+        return;
+    }
+    last_value = values.back();
+
+    // Use the largest low width where there are still at least as many
+    // numbers as high parts.
+    uint64_t universe = last_value + 1;
+    while (low_width < 63 && (universe >> (low_width + 1)) >= count) {
+        low_width++;
+    }
+    uint64_t low_mask = low_width == 0 ? 0 : (uint64_t(-1) >> (64 - low_width));
+
+    low_bits.assign((count * low_width + 63) / 64 + 1, 0);
+    size_t high_size = count + (last_value >> low_width) + 1;
+    high_bits.assign((high_size + 63) / 64, 0);
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t low = values[i] & low_mask;
+        if (low_width != 0) {
+            size_t bit = i * low_width;
+            low_bits[bit / 64] |= low << (bit % 64);
+            if (bit % 64 + low_width > 64) {
+                low_bits[bit / 64 + 1] |= low >> (64 - bit % 64);
+            }
+        }
+        size_t position = (values[i] >> low_width) + i;
+        high_bits[position / 64] |= uint64_t(1) << (position % 64);
+    }
+
+    size_t ones = 0;
+    size_t zeros = 0;
+    for (size_t position = 0; position < high_size; position++) {
+        if ((high_bits[position / 64] >> (position % 64)) & 1) {
+            if (ones % SAMPLE_INTERVAL == 0) {
+                one_samples.push_back(position);
+            }
+            ones++;
+        } else {
+            if (zeros % SAMPLE_INTERVAL == 0) {
+                zero_samples.push_back(position);
+            }
+            zeros++;
+        }
+    }
+}
+
+size_t EliasFanoSequence::size() const {
+    return count;
+}
+
+bool EliasFanoSequence::empty() const {
+    return count == 0;
+}
+
+uint64_t EliasFanoSequence::get(size_t index) const {
+    return ((uint64_t) (select(true, index) - index) << low_width) | get_low(index);
+}
+
+size_t EliasFanoSequence::lower_bound(uint64_t value) const {
+    if (count == 0 || value > last_value) {
+        return count;
+    }
+    // Find the numbers with the same high part, which come after the zero
+    // for each smaller high part.
+    uint64_t high = value >> low_width;
+    size_t begin = high == 0 ? 0 : select(false, high - 1) - (high - 1);
+    size_t end = select(false, high) - high;
+    uint64_t low = value - (high << low_width);
+    while (begin < end) {
+        size_t middle = begin + (end - begin) / 2;
+        if (get_low(middle) < low) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+    return begin;
+}
+
+size_t EliasFanoSequence::get_memory_usage() const {
+    return sizeof(*this) +
+        low_bits.capacity() * sizeof(uint64_t) +
+        high_bits.capacity() * sizeof(uint64_t) +
+        one_samples.capacity() * sizeof(size_t) +
+        zero_samples.capacity() * sizeof(size_t);
+}
+
+size_t EliasFanoSequence::select(bool ones, size_t index) const {
+    size_t position = (ones ? one_samples : zero_samples)[index / SAMPLE_INTERVAL];
+    size_t remaining = index % SAMPLE_INTERVAL;
+    size_t word = position / 64;
+    uint64_t bits = ones ? high_bits[word] : ~high_bits[word];
+    bits &= uint64_t(-1) << (position % 64);
+    while (true) {
+        size_t here = __builtin_popcountll(bits);
+        if (remaining < here) {
+            for (; remaining > 0; remaining--) {
+                // Drop the lowest set bit
+                bits &= bits - 1;
+            }
+            return word * 64 + __builtin_ctzll(bits);
+        }
+        remaining -= here;
+        word++;
+        bits = ones ? high_bits[word] : ~high_bits[word];
+    }
+}
+
+uint64_t EliasFanoSequence::get_low(size_t index) const {
+    if (low_width == 0) {
+        return 0;
+    }
+    size_t bit = index * low_width;
+    uint64_t low = low_bits[bit / 64] >> (bit % 64);
+    if (bit % 64 + low_width > 64) {
+        low |= low_bits[bit / 64 + 1] << (64 - bit % 64);
+    }
+    return low & (uint64_t(-1) >> (64 - low_width));
+}
+
+}
@@ -0,0 +1,239 @@
+#include "handlegraph/execution.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+
+/** \file execution.cpp
+ * Implement the built-in executor and execution options.
+ */
+
+namespace handlegraph {
+
+struct WorkStealingExecutor::Job {
+
+    /// Indexes one thread has left to do
+    struct Range {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    Job(const std::function<void(size_t)>& body, size_t count, size_t slot_count) :
+        body(body), count(count), ranges(slot_count) {
+        for (size_t slot = 0; slot < slot_count; slot++) {
+            ranges[slot].begin = count * slot / slot_count;
+            ranges[slot].end = count * (slot + 1) / slot_count;
+        }
+    }
+
+    /// Take the next index from the given slot's range, or steal from the
+    /// slot with the most left. Returns false if there is nothing left.
+    bool take(size_t slot, size_t& index) {
+        {
+            std::lock_guard<std::mutex> lock(ranges[slot].mutex);
+            if (ranges[slot].begin < ranges[slot].end) {
+                index = ranges[slot].begin++;
+                taken++;
+                return true;
+            }
+        }
+        while (true) {
+            size_t victim = std::numeric_limits<size_t>::max();
+            size_t most = 0;
+            for (size_t i = 0; i < ranges.size(); i++) {
+                std::lock_guard<std::mutex> lock(ranges[i].mutex);
+                if (ranges[i].end - ranges[i].begin > most) {
+                    most = ranges[i].end - ranges[i].begin;
+                    victim = i;
+                }
+            }
+            if (most == 0) {
+                return false;
+            }
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(ranges[victim].mutex);
+                size_t left = ranges[victim].end - ranges[victim].begin;
+                if (left == 0) {
+                    // Someone else got there first
+                    continue;
+                }
+                if (left == 1) {
+                    index = ranges[victim].begin++;
+                    taken++;
+                    return true;
+                }
+                // Take the back half
+                begin = ranges[victim].begin + left / 2;
+                end = ranges[victim].end;
+                ranges[victim].end = begin;
+            }
+            {
+                std::lock_guard<std::mutex> lock(ranges[slot].mutex);
+                ranges[slot].begin = begin + 1;
+                ranges[slot].end = end;
+            }
+            index = begin;
+            taken++;
+            return true;
+        }
+    }
+
+    /// Returns true if a pool thread could usefully join.
+    bool is_joinable() const {
+        return joined < ranges.size() && taken.load() < count && !failed.load();
+    }
+
+    const std::function<void(size_t)>& body;
+    size_t count;
+    std::vector<Range> ranges;
+    /// Number of slots handed out, under the pool's mutex. The caller has
+    /// slot 0.
+    size_t joined = 1;
+    /// Number of pool threads working on this, under the pool's mutex
+    size_t active = 0;
+    /// Number of indexes taken so far
+    std::atomic<size_t> taken{0};
+    /// Set when a call throws, to stop everyone
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+};
+
+WorkStealingExecutor::WorkStealingExecutor(size_t thread_count) :
+    thread_count(thread_count == 0 ? std::max<size_t>(std::thread::hardware_concurrency(), 1) : thread_count) {
+    // The caller of each loop is one of the threads
+    workers.reserve(this->thread_count - 1);
+    for (size_t i = 1; i < this->thread_count; i++) {
+        workers.emplace_back(&WorkStealingExecutor::worker_loop, this);
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_started.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingExecutor::parallel_for(size_t count, size_t thread_count, const std::function<void(size_t)>& body) {
+    if (thread_count == 0 || thread_count > this->thread_count) {
+        thread_count = this->thread_count;
+    }
+    thread_count = std::min(thread_count, count);
+    if (thread_count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            body(i);
+        }
+        return;
+    }
+
+    Job job(body, count, thread_count);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(&job);
+    }
+    job_started.notify_all();
+
+    participate(job, 0);
+
+    {
+        // Let no more threads join, and wait for the ones that did
+        std::unique_lock<std::mutex> lock(mutex);
+        jobs.erase(std::find(jobs.begin(), jobs.end(), &job));
+        worker_left.wait(lock, [&]() {
+            return job.active == 0;
+        });
+    }
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+size_t WorkStealingExecutor::get_thread_count() const {
+    return thread_count;
+}
+
+WorkStealingExecutor& WorkStealingExecutor::get_default() {
+    static WorkStealingExecutor shared;
+    return shared;
+}
+
+void WorkStealingExecutor::participate(Job& job, size_t slot) {
+    size_t index;
+    while (!job.failed.load() && job.take(slot, index)) {
+        try {
+            job.body(index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job.error_mutex);
+            if (!job.error) {
+                job.error = std::current_exception();
+            }
+            job.failed.store(true);
+        }
+    }
+}
+
+void WorkStealingExecutor::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        Job* job = nullptr;
+        job_started.wait(lock, [&]() {
+            if (stopping) {
+                return true;
+            }
+            for (Job* candidate : jobs) {
+                if (candidate->is_joinable()) {
+                    job = candidate;
+                    return true;
+                }
+            }
+            return false;
+        });
+        if (stopping) {
+            return;
+        }
+        size_t slot = job->joined++;
+        job->active++;
+        lock.unlock();
+        participate(*job, slot);
+        lock.lock();
+        job->active--;
+        worker_left.notify_all();
+    }
+}
+
+ExecutionOptions::ExecutionOptions(size_t thread_count, Executor* executor) :
+    thread_count(thread_count), executor(executor) {
+    // Nothing to do
+}
+
+Executor& ExecutionOptions::get_executor() const {
+    return executor != nullptr ? *executor : WorkStealingExecutor::get_default();
+}
+
+size_t ExecutionOptions::get_thread_count() const {
+    if (thread_count == 1) {
+        return 1;
+    }
+    size_t available = get_executor().get_thread_count();
+    return thread_count == 0 ? available : std::min(thread_count, available);
+}
+
+void ExecutionOptions::parallel_for(size_t count, const std::function<void(size_t)>& body) const {
+    if (thread_count == 1 || count <= 1) {
+        // Don't start up a pool we don't need
+        for (size_t i = 0; i < count; i++) {
+            body(i);
+        }
+        return;
+    }
+    get_executor().parallel_for(count, thread_count, body);
+}
+
+}
@@ -0,0 +1,392 @@
+#include "handlegraph/algorithms/fingerprint.hpp"
+#include "handlegraph/algorithms/for_each_path_range.hpp"
+#include "handlegraph/path_position_handle_graph.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <unordered_map>
+#include <limits>
+#include <tuple>
+
+namespace handlegraph {
+namespace algorithms {
+
+using namespace std;
+
+const size_t DEFAULT_FINGERPRINT_BUCKET_COUNT = 256;
+
+/// Number of node IDs handed to a thread at a time.
+static const size_t NODE_BLOCK_SIZE = 4096;
+
+/// Kinds of things we hash, so they can't be confused for each other.
+enum : uint64_t {NODE_TAG = 1, EDGE_TAG, PATH_TAG, STEP_TAG, BUCKET_TAG};
+
+/// Stand-in for a missing previous step.
+static const uint64_t NO_SIDE = numeric_limits<uint64_t>::max();
+
+/// Scramble a 64-bit value (the splitmix64 finalizer).
+static inline uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * Hashes a sequence of words into 4 independently seeded lanes at once.
+ */
+struct LaneHasher {
+    fingerprint_t state;
+    
+    LaneHasher(uint64_t tag) {
+        static const uint64_t LANE_SEEDS[4] = {0x243f6a8885a308d3ull, 0x13198a2e03707344ull,
+                                               0xa4093822299f31d0ull, 0x082efa98ec4e6c89ull};
+        for (size_t i = 0; i < 4; i++) {
+            state[i] = mix(LANE_SEEDS[i] ^ tag);
+        }
+    }
+    
+    inline void add(uint64_t word) {
+        for (size_t i = 0; i < 4; i++) {
+            state[i] = mix(state[i] ^ word) + word;
+        }
+    }
+    
+    void add_bytes(const char* bytes, size_t length) {
+        add(length);
+        for (; length >= sizeof(uint64_t); bytes += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, bytes, sizeof(uint64_t));
+            add(word);
+        }
+        if (length > 0) {
+            uint64_t word = 0;
+            memcpy(&word, bytes, length);
+            add(word);
+        }
+    }
+};
+
+/// Add one fingerprint into another, lane by lane.
+static inline void accumulate(fingerprint_t& into, const fingerprint_t& value) {
+    for (size_t i = 0; i < 4; i++) {
+        into[i] += value[i];
+    }
+}
+
+/// Pack an oriented node into a number.
+static inline uint64_t pack_side(const HandleGraph* graph, const handle_t& handle) {
+    return ((uint64_t) graph->get_id(handle) << 1) | (uint64_t) graph->get_is_reverse(handle);
+}
+
+bool GraphFingerprint::operator==(const GraphFingerprint& other) const {
+    return digest == other.digest;
+}
+
+bool GraphFingerprint::operator!=(const GraphFingerprint& other) const {
+    return !(*this == other);
+}
+
+string GraphFingerprint::to_string() const {
+    stringstream s;
+    s << hex << setfill('0');
+    for (auto& lane : digest) {
+        s << setw(16) << lane;
+    }
+    return s.str();
+}
+
+bool FingerprintDifference::empty() const {
+    return node_buckets.empty() && path_buckets.empty();
+}
+
+size_t get_fingerprint_bucket(const nid_t& node_id, size_t bucket_count) {
+    return mix(node_id ^ mix(BUCKET_TAG)) % bucket_count;
+}
+
+size_t get_fingerprint_bucket(const string& path_name, size_t bucket_count) {
+    LaneHasher hasher(BUCKET_TAG);
+    hasher.add_bytes(path_name.data(), path_name.size());
+    return hasher.state[0] % bucket_count;
+}
+
+/// Hash a node and the edges it has the lowest ID in, for all nodes in
+/// parallel, or just the nodes in the wanted buckets. Passes each block of
+/// (ID, node hash, edges hash) results to the callback, which is called by
+/// one thread at a time.
+static void hash_nodes(const HandleGraph* graph, const ExecutionOptions& execution, size_t bucket_count,
+                       const vector<bool>* wanted_buckets,
+                       const function<void(const vector<tuple<nid_t, fingerprint_t, fingerprint_t>>&)>& callback) {
+    if (graph->get_node_count() == 0) {
+        return;
+    }
+    nid_t min_id = graph->min_node_id();
+    size_t width = graph->max_node_id() - min_id + 1;
+    mutex callback_mutex;
+    
+    execution.parallel_for((width + NODE_BLOCK_SIZE - 1) / NODE_BLOCK_SIZE, [&](size_t block) {
+        vector<tuple<nid_t, fingerprint_t, fingerprint_t>> results;
+        string sequence;
+        size_t block_end = min(width, (block + 1) * NODE_BLOCK_SIZE);
+        for (size_t index = block * NODE_BLOCK_SIZE; index < block_end; index++) {
+            nid_t node_id = min_id + index;
+            if (!graph->has_node(node_id)) {
+                continue;
+            }
+            if (wanted_buckets && !(*wanted_buckets)[get_fingerprint_bucket(node_id, bucket_count)]) {
+                continue;
+            }
+            handle_t handle = graph->get_handle(node_id);
+            
+            sequence.resize(graph->get_length(handle));
+            graph->copy_sequence(handle, &sequence[0]);
+            LaneHasher node_hasher(NODE_TAG);
+            node_hasher.add(node_id);
+            node_hasher.add_bytes(sequence.data(), sequence.size());
+            
+            fingerprint_t edges = {{0, 0, 0, 0}};
+            auto add_edge = [&](const handle_t& left, const handle_t& right) {
+                // Use the smaller of the edge's two orientations
+                uint64_t first = pack_side(graph, left);
+                uint64_t second = pack_side(graph, right);
+                uint64_t flipped_first = second ^ 1;
+                uint64_t flipped_second = first ^ 1;
+                if (make_pair(flipped_first, flipped_second) < make_pair(first, second)) {
+                    first = flipped_first;
+                    second = flipped_second;
+                }
+                LaneHasher edge_hasher(EDGE_TAG);
+                edge_hasher.add(first);
+                edge_hasher.add(second);
+                accumulate(edges, edge_hasher.state);
+            };
+            // Take each edge once, from its lowest ID node, as in for_each_edge()
+            graph->follow_edges(handle, false, [&](const handle_t& next) {
+                if (node_id <= graph->get_id(next)) {
+                    add_edge(handle, next);
+                }
+            });
+            graph->follow_edges(handle, true, [&](const handle_t& prev) {
+                if (node_id < graph->get_id(prev) || (node_id == graph->get_id(prev) && graph->get_is_reverse(prev))) {
+                    add_edge(prev, handle);
+                }
+            });
+            
+            results.emplace_back(node_id, node_hasher.state, edges);
+        }
+        lock_guard<mutex> lock(callback_mutex);
+        callback(results);
+    });
+}
+
+/// Hash each of the given distinct paths, in parallel.
+static vector<fingerprint_t> hash_paths(const PathHandleGraph* graph, const vector<path_handle_t>& paths,
+                                        const ExecutionOptions& execution) {
+    
+    vector<fingerprint_t> path_hashes(paths.size(), fingerprint_t{{0, 0, 0, 0}});
+    vector<uint64_t> name_hashes(paths.size());
+    unordered_map<path_handle_t, size_t> path_index;
+    for (size_t i = 0; i < paths.size(); i++) {
+        path_index.emplace(paths[i], i);
+        string name = graph->get_path_name(paths[i]);
+        LaneHasher path_hasher(PATH_TAG);
+        path_hasher.add_bytes(name.data(), name.size());
+        name_hashes[i] = path_hasher.state[0];
+        path_hasher.add(graph->get_is_circular(paths[i]));
+        path_hasher.add(graph->get_step_count(paths[i]));
+        path_hashes[i] = path_hasher.state;
+    }
+    
+    auto position_graph = dynamic_cast<const PathPositionHandleGraph*>(graph);
+    // Without positions, each path is done in order by one thread, so we can
+    // keep a running offset for it.
+    vector<size_t> next_offset(position_graph ? 0 : paths.size(), 0);
+    mutex hashes_mutex;
+    
+    for_each_path_range_parallel(graph, paths, [&](const path_handle_t& path, const step_handle_t& start,
+                                                   const handle_t* handles, size_t count) {
+        size_t i = path_index.at(path);
+        size_t offset = position_graph ? position_graph->get_position_of_step(start) : next_offset[i];
+        uint64_t prev_side = graph->has_previous_step(start) ?
+            pack_side(graph, graph->get_handle_of_step(graph->get_previous_step(start))) : NO_SIDE;
+        
+        // Hash each step with where it is and what comes before it, so that
+        // the sum captures the order of steps.
+        fingerprint_t run_hash = {{0, 0, 0, 0}};
+        for (size_t j = 0; j < count; j++) {
+            uint64_t side = pack_side(graph, handles[j]);
+            LaneHasher step_hasher(STEP_TAG);
+            step_hasher.add(name_hashes[i]);
+            step_hasher.add(offset);
+            step_hasher.add(prev_side);
+            step_hasher.add(side);
+            accumulate(run_hash, step_hasher.state);
+            offset += graph->get_length(handles[j]);
+            prev_side = side;
+        }
+        if (!position_graph) {
+            next_offset[i] = offset;
+        }
+        
+        lock_guard<mutex> lock(hashes_mutex);
+        accumulate(path_hashes[i], run_hash);
+    }, DEFAULT_PATH_RANGE_LENGTH, execution);
+    
+    return path_hashes;
+}
+
+/// Get all the paths of all senses.
+static vector<path_handle_t> get_all_paths(const PathHandleGraph* graph) {
+    vector<path_handle_t> paths;
+    for (auto& sense : {PathSense::REFERENCE, PathSense::GENERIC, PathSense::HAPLOTYPE}) {
+        graph->for_each_path_of_sense(sense, [&](const path_handle_t& path) {
+            paths.push_back(path);
+        });
+    }
+    return paths;
+}
+
+GraphFingerprint compute_fingerprint(const HandleGraph* graph, const ExecutionOptions& execution, size_t bucket_count) {
+    GraphFingerprint fingerprint;
+    fingerprint.node_buckets.resize(bucket_count, fingerprint_t{{0, 0, 0, 0}});
+    
+    hash_nodes(graph, execution, bucket_count, nullptr, [&](const vector<tuple<nid_t, fingerprint_t, fingerprint_t>>& results) {
+        for (auto& result : results) {
+            auto& bucket = fingerprint.node_buckets[get_fingerprint_bucket(get<0>(result), bucket_count)];
+            accumulate(bucket, get<1>(result));
+            accumulate(bucket, get<2>(result));
+            accumulate(fingerprint.node_digest, get<1>(result));
+            accumulate(fingerprint.edge_digest, get<2>(result));
+        }
+    });
+    
+    accumulate(fingerprint.digest, fingerprint.node_digest);
+    accumulate(fingerprint.digest, fingerprint.edge_digest);
+    return fingerprint;
+}
+
+GraphFingerprint compute_fingerprint_with_paths(const PathHandleGraph* graph, const ExecutionOptions& execution, size_t bucket_count) {
+    GraphFingerprint fingerprint = compute_fingerprint(graph, execution, bucket_count);
+    fingerprint.path_buckets.resize(bucket_count, fingerprint_t{{0, 0, 0, 0}});
+    
+    vector<path_handle_t> paths = get_all_paths(graph);
+    vector<fingerprint_t> path_hashes = hash_paths(graph, paths, execution);
+    for (size_t i = 0; i < paths.size(); i++) {
+        accumulate(fingerprint.path_buckets[get_fingerprint_bucket(graph->get_path_name(paths[i]), bucket_count)], path_hashes[i]);
+        accumulate(fingerprint.path_digest, path_hashes[i]);
+    }
+    
+    accumulate(fingerprint.digest, fingerprint.path_digest);
+    return fingerprint;
+}
+
+FingerprintDifference compare_fingerprints(const GraphFingerprint& fingerprint_1,
+                                           const GraphFingerprint& fingerprint_2) {
+    if (fingerprint_1.node_buckets.size() != fingerprint_2.node_buckets.size() ||
+        fingerprint_1.path_buckets.size() != fingerprint_2.path_buckets.size()) {
+        throw runtime_error("Cannot compare fingerprints with different numbers of buckets");
+    }
+    FingerprintDifference difference;
+    for (size_t i = 0; i < fingerprint_1.node_buckets.size(); i++) {
+        if (fingerprint_1.node_buckets[i] != fingerprint_2.node_buckets[i]) {
+            difference.node_buckets.push_back(i);
+        }
+    }
+    for (size_t i = 0; i < fingerprint_1.path_buckets.size(); i++) {
+        if (fingerprint_1.path_buckets[i] != fingerprint_2.path_buckets[i]) {
+            difference.path_buckets.push_back(i);
+        }
+    }
+    return difference;
+}
+
+/// Put the differences between two maps into a sorted vector.
+template<typename Key>
+static vector<Key> differing_keys(const unordered_map<Key, fingerprint_t>& hashes_1,
+                                  const unordered_map<Key, fingerprint_t>& hashes_2) {
+    vector<Key> differing;
+    for (auto& entry : hashes_1) {
+        auto found = hashes_2.find(entry.first);
+        if (found == hashes_2.end() || found->second != entry.second) {
+            differing.push_back(entry.first);
+        }
+    }
+    for (auto& entry : hashes_2) {
+        if (!hashes_1.count(entry.first)) {
+            differing.push_back(entry.first);
+        }
+    }
+    sort(differing.begin(), differing.end());
+    return differing;
+}
+
+vector<nid_t> find_differing_nodes(const HandleGraph* graph_1,
+                                   const HandleGraph* graph_2,
+                                   const FingerprintDifference& difference,
+                                   size_t bucket_count,
+                                   const ExecutionOptions& execution) {
+    if (difference.node_buckets.empty()) {
+        return vector<nid_t>();
+    }
+    vector<bool> wanted_buckets(bucket_count, false);
+    for (auto& bucket : difference.node_buckets) {
+        wanted_buckets.at(bucket) = true;
+    }
+    
+    unordered_map<nid_t, fingerprint_t> hashes[2];
+    const HandleGraph* graphs[2] = {graph_1, graph_2};
+    for (size_t i = 0; i < 2; i++) {
+        hash_nodes(graphs[i], execution, bucket_count, &wanted_buckets, [&](const vector<tuple<nid_t, fingerprint_t, fingerprint_t>>& results) {
+            for (auto& result : results) {
+                fingerprint_t combined = get<1>(result);
+                accumulate(combined, get<2>(result));
+                hashes[i].emplace(get<0>(result), combined);
+            }
+        });
+    }
+    
+    return differing_keys(hashes[0], hashes[1]);
+}
+
+vector<string> find_differing_paths(const PathHandleGraph* graph_1,
+                                    const PathHandleGraph* graph_2,
+                                    const FingerprintDifference& difference,
+                                    size_t bucket_count,
+                                    const ExecutionOptions& execution) {
+    if (difference.path_buckets.empty()) {
+        return vector<string>();
+    }
+    vector<bool> wanted_buckets(bucket_count, false);
+    for (auto& bucket : difference.path_buckets) {
+        wanted_buckets.at(bucket) = true;
+    }
+    
+    unordered_map<string, fingerprint_t> hashes[2];
+    const PathHandleGraph* graphs[2] = {graph_1, graph_2};
+    for (size_t i = 0; i < 2; i++) {
+        vector<path_handle_t> paths;
+        vector<string> names;
+        for (auto& path : get_all_paths(graphs[i])) {
+            string name = graphs[i]->get_path_name(path);
+            if (wanted_buckets[get_fingerprint_bucket(name, bucket_count)]) {
+                paths.push_back(path);
+                names.push_back(name);
+            }
+        }
+        vector<fingerprint_t> path_hashes = hash_paths(graphs[i], paths, execution);
+        for (size_t j = 0; j < paths.size(); j++) {
+            hashes[i].emplace(names[j], path_hashes[j]);
+        }
+    }
+    
+    return differing_keys(hashes[0], hashes[1]);
+}
+
+}
+}
@@ -0,0 +1,137 @@
+#include "handlegraph/algorithms/for_each_path_range.hpp"
+#include "handlegraph/path_position_handle_graph.hpp"
+
+#include <algorithm>
+
+namespace handlegraph {
+namespace algorithms {
+
+using namespace std;
+
+const size_t DEFAULT_PATH_RANGE_LENGTH = 1 << 20;
+
+/// A piece of work for one thread: a run of steps on a path, from the first
+/// step up to but not including the end step.
+struct PathRangeTask {
+    path_handle_t path;
+    step_handle_t begin;
+    step_handle_t end;
+    /// Estimated amount of work, for scheduling the big things first
+    size_t size;
+};
+
+void for_each_path_range_parallel(const PathHandleGraph* graph,
+                                  const vector<path_handle_t>& paths,
+                                  const function<void(const path_handle_t&, const step_handle_t&, const handle_t*, size_t)>& iteratee,
+                                  size_t range_length,
+                                  const ExecutionOptions& execution) {
+    
+    range_length = max<size_t>(range_length, 1);
+    
+    auto position_graph = dynamic_cast<const PathPositionHandleGraph*>(graph);
+    
+    // Work out the pieces of each path in parallel, since finding the cut
+    // points takes a position query each.
+    vector<vector<PathRangeTask>> tasks_by_path(paths.size());
+    execution.parallel_for(paths.size(), [&](size_t i) {
+        const path_handle_t& path = paths[i];
+        auto& path_tasks = tasks_by_path[i];
+        step_handle_t end = graph->path_end(path);
+        step_handle_t begin = graph->path_begin(path);
+        if (begin == end) {
+            // Empty path
+            return;
+        }
+        if (position_graph == nullptr) {
+            // We have to do the whole path at once
+            path_tasks.push_back({path, begin, end, graph->get_step_count(path)});
+            return;
+        }
+        
+        size_t path_length = position_graph->get_path_length(path);
+        size_t range_start = 0;
+        for (size_t cut = range_length; cut < path_length; cut += range_length) {
+            step_handle_t cut_step = position_graph->get_step_at_position(path, cut);
+            if (cut_step == end || cut_step == begin) {
+                continue;
+            }
+            size_t cut_position = position_graph->get_position_of_step(cut_step);
+            if (cut_position <= range_start) {
+                // A long node covers several cut points
+                continue;
+            }
+            path_tasks.push_back({path, begin, cut_step, cut_position - range_start});
+            begin = cut_step;
+            range_start = cut_position;
+        }
+        path_tasks.push_back({path, begin, end, path_length - range_start});
+    });
+    
+    vector<PathRangeTask> tasks;
+    for (auto& path_tasks : tasks_by_path) {
+        for (auto& task : path_tasks) {
+            tasks.push_back(task);
+        }
+        path_tasks.clear();
+        path_tasks.shrink_to_fit();
+    }
+    stable_sort(tasks.begin(), tasks.end(), [](const PathRangeTask& a, const PathRangeTask& b) {
+        return a.size > b.size;
+    });
+    
+    execution.parallel_for(tasks.size(), [&](size_t i) {
+        const PathRangeTask& task = tasks[i];
+        vector<handle_t> buffer(min(range_length, max<size_t>(task.size, 1)));
+        
+        if (position_graph == nullptr) {
+            // Take the whole path a run at a time
+            step_handle_t here = task.begin;
+            step_handle_t run_start = here;
+            size_t count;
+            while ((count = graph->get_step_handles(task.path, here, buffer.data(), buffer.size())) != 0) {
+                iteratee(task.path, run_start, buffer.data(), count);
+                run_start = here;
+            }
+            return;
+        }
+        
+        // Walk up to the start of the next piece, which may not be the end
+        // of the path, so we can't use get_step_handles().
+        step_handle_t back = graph->path_back(task.path);
+        step_handle_t run_start = task.begin;
+        size_t count = 0;
+        for (step_handle_t here = task.begin; here != task.end; here = graph->get_next_step(here)) {
+            if (count == buffer.size()) {
+                iteratee(task.path, run_start, buffer.data(), count);
+                run_start = here;
+                count = 0;
+            }
+            buffer[count++] = graph->get_handle_of_step(here);
+            if (here == back) {
+                // Don't go around circular paths
+                break;
+            }
+        }
+        if (count != 0) {
+            iteratee(task.path, run_start, buffer.data(), count);
+        }
+    });
+}
+
+void for_each_path_range_parallel(const PathHandleGraph* graph,
+                                  const function<void(const path_handle_t&, const step_handle_t&, const handle_t*, size_t)>& iteratee,
+                                  size_t range_length,
+                                  const ExecutionOptions& execution) {
+    
+    vector<path_handle_t> paths;
+    for (auto& sense : {PathSense::REFERENCE, PathSense::GENERIC, PathSense::HAPLOTYPE}) {
+        graph->for_each_path_of_sense(sense, [&](const path_handle_t& path) {
+            paths.push_back(path);
+        });
+    }
+    
+    for_each_path_range_parallel(graph, paths, iteratee, range_length, execution);
+}
+
+}
+}
@@ -0,0 +1,46 @@
+#include "handlegraph/algorithms/for_each_rank_range.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace handlegraph {
+namespace algorithms {
+
+using namespace std;
+
+const size_t DEFAULT_RANK_BLOCK_SIZE = 4096;
+
+pair<size_t, size_t> get_rank_partition(const RankedHandleGraph* graph, size_t part, size_t part_count) {
+    if (part >= part_count) {
+        throw runtime_error("error:[get_rank_partition] part " + to_string(part) +
+                            " does not exist among " + to_string(part_count) + " parts");
+    }
+    size_t node_count = graph->get_node_count();
+    return make_pair(1 + node_count * part / part_count, 1 + node_count * (part + 1) / part_count);
+}
+
+size_t get_rank_block_count(size_t begin_rank, size_t end_rank, size_t block_size) {
+    block_size = max<size_t>(block_size, 1);
+    if (end_rank <= begin_rank) {
+        return 0;
+    }
+    return (end_rank - begin_rank + block_size - 1) / block_size;
+}
+
+void for_each_rank_range_parallel(const RankedHandleGraph* graph,
+                                  size_t begin_rank, size_t end_rank,
+                                  const function<void(size_t, size_t, size_t)>& iteratee,
+                                  size_t block_size,
+                                  const ExecutionOptions& execution) {
+
+    block_size = max<size_t>(block_size, 1);
+    end_rank = min(end_rank, graph->get_node_count() + 1);
+    execution.parallel_for(get_rank_block_count(begin_rank, end_rank, block_size), [&](size_t block) {
+        size_t block_begin = begin_rank + block * block_size;
+        iteratee(block, block_begin, min(end_rank, block_begin + block_size));
+    });
+}
+
+}
+}
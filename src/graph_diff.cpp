@@ -0,0 +1,387 @@
+#include "handlegraph/algorithms/graph_diff.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <limits>
+
+namespace handlegraph {
+namespace algorithms {
+
+using namespace std;
+
+/// Number of node IDs handled by a thread at a time.
+static const size_t NODE_BLOCK_SIZE = 4096;
+
+/// Number of blocks of node IDs, per thread, that may be started past the
+/// first block not yet reported.
+static const size_t MAX_BLOCKS_AHEAD_PER_THREAD = 4;
+
+/// Number of path steps compared at a time.
+static const size_t STEP_BLOCK_SIZE = 1024;
+
+/// An oriented node, packed as ID and orientation bit, that means the same
+/// thing in any graph.
+using packed_side_t = uint64_t;
+
+static inline packed_side_t pack_side(const HandleGraph* graph, const handle_t& handle) {
+    return ((uint64_t) graph->get_id(handle) << 1) | (uint64_t) graph->get_is_reverse(handle);
+}
+
+static inline handle_t unpack_side(const HandleGraph* graph, packed_side_t side) {
+    return graph->get_handle((nid_t) (side >> 1), side & 1);
+}
+
+/// Get the edges that a node has the lowest ID in, as for for_each_edge(), in
+/// their smaller orientation, sorted.
+static vector<pair<packed_side_t, packed_side_t>> get_owned_edges(const HandleGraph* graph, const handle_t& handle) {
+    vector<pair<packed_side_t, packed_side_t>> edges;
+    nid_t node_id = graph->get_id(handle);
+    auto add_edge = [&](const handle_t& left, const handle_t& right) {
+        pair<packed_side_t, packed_side_t> edge(pack_side(graph, left), pack_side(graph, right));
+        pair<packed_side_t, packed_side_t> flipped(edge.second ^ 1, edge.first ^ 1);
+        edges.push_back(min(edge, flipped));
+    };
+    graph->follow_edges(handle, false, [&](const handle_t& next) {
+        if (node_id <= graph->get_id(next)) {
+            add_edge(handle, next);
+        }
+    });
+    graph->follow_edges(handle, true, [&](const handle_t& prev) {
+        if (node_id < graph->get_id(prev) || (node_id == graph->get_id(prev) && graph->get_is_reverse(prev))) {
+            add_edge(prev, handle);
+        }
+    });
+    sort(edges.begin(), edges.end());
+    edges.erase(unique(edges.begin(), edges.end()), edges.end());
+    return edges;
+}
+
+bool diff_graphs(const HandleGraph* graph_1,
+                 const HandleGraph* graph_2,
+                 const GraphDiffCallbacks& callbacks,
+                 const ExecutionOptions& execution) {
+    
+    if (graph_1->get_node_count() == 0 && graph_2->get_node_count() == 0) {
+        return true;
+    }
+    
+    // Work out what IDs we need to look at
+    nid_t min_id = numeric_limits<nid_t>::max();
+    nid_t max_id = numeric_limits<nid_t>::min();
+    for (auto graph : {graph_1, graph_2}) {
+        if (graph->get_node_count() != 0) {
+            min_id = min(min_id, graph->min_node_id());
+            max_id = max(max_id, graph->max_node_id());
+        }
+    }
+    size_t width = max_id - min_id + 1;
+    size_t total_nodes = graph_1->get_node_count() + graph_2->get_node_count();
+    
+    // If the IDs are very sparse, it's cheaper to list them than to probe
+    // the whole range. The list holds every ID in either graph.
+    vector<nid_t> sparse_ids;
+    bool sparse = width / 4 > total_nodes;
+    if (sparse) {
+        sparse_ids.reserve(total_nodes);
+        for (auto graph : {graph_1, graph_2}) {
+            graph->for_each_handle([&](const handle_t& handle) {
+                sparse_ids.push_back(graph->get_id(handle));
+            });
+        }
+        sort(sparse_ids.begin(), sparse_ids.end());
+        sparse_ids.erase(unique(sparse_ids.begin(), sparse_ids.end()), sparse_ids.end());
+    }
+    size_t candidate_count = sparse ? sparse_ids.size() : width;
+    
+    /// A difference to report: which callback, and what to pass
+    enum DifferenceType {NODE_REMOVED, NODE_ADDED, NODE_CHANGED, EDGE_REMOVED, EDGE_ADDED};
+    struct Difference {
+        DifferenceType type;
+        nid_t node_id;
+        pair<packed_side_t, packed_side_t> edge;
+    };
+    
+    // Report blocks in order, holding on to the ones that finish early.
+    mutex report_mutex;
+    size_t next_block = 0;
+    map<size_t, vector<Difference>> waiting_blocks;
+    bool equivalent = true;
+    auto report = [&](const vector<Difference>& differences) {
+        for (auto& difference : differences) {
+            equivalent = false;
+            switch (difference.type) {
+            case NODE_REMOVED:
+                if (callbacks.node_removed) callbacks.node_removed(difference.node_id);
+                break;
+            case NODE_ADDED:
+                if (callbacks.node_added) callbacks.node_added(difference.node_id);
+                break;
+            case NODE_CHANGED:
+                if (callbacks.node_changed) callbacks.node_changed(difference.node_id);
+                break;
+            case EDGE_REMOVED:
+                if (callbacks.edge_removed) {
+                    callbacks.edge_removed(edge_t(unpack_side(graph_1, difference.edge.first),
+                                                  unpack_side(graph_1, difference.edge.second)));
+                }
+                break;
+            case EDGE_ADDED:
+                if (callbacks.edge_added) {
+                    callbacks.edge_added(edge_t(unpack_side(graph_2, difference.edge.first),
+                                                unpack_side(graph_2, difference.edge.second)));
+                }
+                break;
+            }
+        }
+    };
+    
+    auto find_differences = [&](size_t block) {
+        vector<Difference> differences;
+        size_t block_end = min(candidate_count, (block + 1) * NODE_BLOCK_SIZE);
+        for (size_t i = block * NODE_BLOCK_SIZE; i < block_end; i++) {
+            nid_t node_id = sparse ? sparse_ids[i] : min_id + i;
+            bool in_1 = graph_1->has_node(node_id);
+            bool in_2 = graph_2->has_node(node_id);
+            if (!in_1 && !in_2) {
+                continue;
+            }
+            
+            vector<pair<packed_side_t, packed_side_t>> edges_1, edges_2;
+            if (in_1 && in_2) {
+                handle_t handle_1 = graph_1->get_handle(node_id);
+                handle_t handle_2 = graph_2->get_handle(node_id);
+                if (graph_1->get_length(handle_1) != graph_2->get_length(handle_2) ||
+                    graph_1->get_sequence(handle_1) != graph_2->get_sequence(handle_2)) {
+                    differences.push_back({NODE_CHANGED, node_id, {}});
+                }
+                edges_1 = get_owned_edges(graph_1, handle_1);
+                edges_2 = get_owned_edges(graph_2, handle_2);
+            } else if (in_1) {
+                differences.push_back({NODE_REMOVED, node_id, {}});
+                edges_1 = get_owned_edges(graph_1, graph_1->get_handle(node_id));
+            } else {
+                differences.push_back({NODE_ADDED, node_id, {}});
+                edges_2 = get_owned_edges(graph_2, graph_2->get_handle(node_id));
+            }
+            
+            // Merge join the edges
+            auto it_1 = edges_1.begin();
+            auto it_2 = edges_2.begin();
+            while (it_1 != edges_1.end() || it_2 != edges_2.end()) {
+                if (it_2 == edges_2.end() || (it_1 != edges_1.end() && *it_1 < *it_2)) {
+                    differences.push_back({EDGE_REMOVED, node_id, *it_1++});
+                } else if (it_1 == edges_1.end() || *it_2 < *it_1) {
+                    differences.push_back({EDGE_ADDED, node_id, *it_2++});
+                } else {
+                    ++it_1;
+                    ++it_2;
+                }
+            }
+        }
+        return differences;
+    };
+    
+    // Hand out blocks in order, and don't start one too far past the first
+    // block not yet reported, so the blocks waiting to be reported stay
+    // bounded even if one block is slow. The block a worker waits for is
+    // always already being worked on, so workers can't wait on each other
+    // forever, however the executor schedules them.
+    size_t block_count = (candidate_count + NODE_BLOCK_SIZE - 1) / NODE_BLOCK_SIZE;
+    size_t worker_count = min(block_count, max<size_t>(execution.get_thread_count(), 1));
+    size_t max_blocks_ahead = worker_count * MAX_BLOCKS_AHEAD_PER_THREAD;
+    condition_variable block_reported;
+    size_t next_unstarted = 0;
+    bool failed = false;
+    execution.parallel_for(worker_count, [&](size_t) {
+        while (true) {
+            size_t block;
+            {
+                unique_lock<mutex> lock(report_mutex);
+                block_reported.wait(lock, [&]() {
+                    return failed || next_unstarted >= block_count || next_unstarted < next_block + max_blocks_ahead;
+                });
+                if (failed || next_unstarted >= block_count) {
+                    return;
+                }
+                block = next_unstarted++;
+            }
+            
+            try {
+                vector<Difference> differences = find_differences(block);
+                
+                lock_guard<mutex> lock(report_mutex);
+                if (block != next_block) {
+                    waiting_blocks[block] = move(differences);
+                    continue;
+                }
+                report(differences);
+                next_block++;
+                for (auto found = waiting_blocks.find(next_block); found != waiting_blocks.end(); found = waiting_blocks.find(next_block)) {
+                    report(found->second);
+                    waiting_blocks.erase(found);
+                    next_block++;
+                }
+                block_reported.notify_all();
+            } catch (...) {
+                // Don't leave other workers waiting on a block that will
+                // never be reported.
+                lock_guard<mutex> lock(report_mutex);
+                failed = true;
+                block_reported.notify_all();
+                throw;
+            }
+        }
+    });
+    
+    return equivalent;
+}
+
+/// Find the steps where two paths start to differ, starting from their first
+/// steps, and the number of steps they have in common.
+static size_t common_prefix(const PathHandleGraph* graph_1, const path_handle_t& path_1, step_handle_t& step_1,
+                            const PathHandleGraph* graph_2, const path_handle_t& path_2, step_handle_t& step_2) {
+    step_1 = graph_1->path_begin(path_1);
+    step_2 = graph_2->path_begin(path_2);
+    vector<handle_t> block_1(STEP_BLOCK_SIZE), block_2(STEP_BLOCK_SIZE);
+    size_t common = 0;
+    while (true) {
+        step_handle_t block_start_1 = step_1;
+        step_handle_t block_start_2 = step_2;
+        size_t count_1 = graph_1->get_step_handles(path_1, step_1, block_1.data(), STEP_BLOCK_SIZE);
+        size_t count_2 = graph_2->get_step_handles(path_2, step_2, block_2.data(), STEP_BLOCK_SIZE);
+        size_t count = min(count_1, count_2);
+        size_t matching = 0;
+        while (matching < count && pack_side(graph_1, block_1[matching]) == pack_side(graph_2, block_2[matching])) {
+            matching++;
+        }
+        common += matching;
+        if (matching == STEP_BLOCK_SIZE) {
+            continue;
+        }
+        // Find the first differing steps
+        step_1 = block_start_1;
+        step_2 = block_start_2;
+        for (size_t i = 0; i < matching; i++) {
+            step_1 = graph_1->get_next_step(step_1);
+            step_2 = graph_2->get_next_step(step_2);
+        }
+        if (matching == count_1) {
+            step_1 = graph_1->path_end(path_1);
+        }
+        if (matching == count_2) {
+            step_2 = graph_2->path_end(path_2);
+        }
+        return common;
+    }
+}
+
+bool diff_graphs_with_paths(const PathHandleGraph* graph_1,
+                            const PathHandleGraph* graph_2,
+                            const GraphDiffCallbacks& callbacks,
+                            const ExecutionOptions& execution) {
+    
+    bool equivalent = diff_graphs(graph_1, graph_2, callbacks, execution);
+    
+    // Match up paths by name
+    map<string, pair<const path_handle_t*, const path_handle_t*>> paths_by_name;
+    vector<path_handle_t> paths_1, paths_2;
+    for (auto& sense : {PathSense::REFERENCE, PathSense::GENERIC, PathSense::HAPLOTYPE}) {
+        graph_1->for_each_path_of_sense(sense, [&](const path_handle_t& path) {
+            paths_1.push_back(path);
+        });
+        graph_2->for_each_path_of_sense(sense, [&](const path_handle_t& path) {
+            paths_2.push_back(path);
+        });
+    }
+    for (auto& path : paths_1) {
+        paths_by_name[graph_1->get_path_name(path)].first = &path;
+    }
+    for (auto& path : paths_2) {
+        paths_by_name[graph_2->get_path_name(path)].second = &path;
+    }
+    vector<pair<const path_handle_t*, const path_handle_t*>> pairs;
+    pairs.reserve(paths_by_name.size());
+    for (auto& entry : paths_by_name) {
+        pairs.push_back(entry.second);
+    }
+    paths_by_name.clear();
+    
+    /// The differing ranges of a pair of paths
+    struct PathDifference {
+        bool differs = false;
+        step_handle_t begin_1, end_1, begin_2, end_2;
+    };
+    vector<PathDifference> path_differences(pairs.size());
+    
+    execution.parallel_for(pairs.size(), [&](size_t i) {
+        if (!pairs[i].first || !pairs[i].second) {
+            // Added or removed
+            return;
+        }
+        const path_handle_t& path_1 = *pairs[i].first;
+        const path_handle_t& path_2 = *pairs[i].second;
+        auto& difference = path_differences[i];
+        
+        size_t length_1 = graph_1->get_step_count(path_1);
+        size_t length_2 = graph_2->get_step_count(path_2);
+        if (graph_1->get_is_circular(path_1) != graph_2->get_is_circular(path_2)) {
+            // The whole path is different
+            difference.differs = true;
+            difference.begin_1 = graph_1->path_begin(path_1);
+            difference.end_1 = graph_1->path_end(path_1);
+            difference.begin_2 = graph_2->path_begin(path_2);
+            difference.end_2 = graph_2->path_end(path_2);
+            return;
+        }
+        
+        size_t prefix = common_prefix(graph_1, path_1, difference.begin_1, graph_2, path_2, difference.begin_2);
+        if (prefix == length_1 && prefix == length_2) {
+            // Same path
+            return;
+        }
+        difference.differs = true;
+        
+        // Trim off the common suffix, without going into the prefix
+        difference.end_1 = graph_1->path_end(path_1);
+        difference.end_2 = graph_2->path_end(path_2);
+        size_t max_suffix = min(length_1, length_2) - prefix;
+        for (size_t suffix = 0; suffix < max_suffix; suffix++) {
+            step_handle_t prev_1 = suffix == 0 ? graph_1->path_back(path_1) : graph_1->get_previous_step(difference.end_1);
+            step_handle_t prev_2 = suffix == 0 ? graph_2->path_back(path_2) : graph_2->get_previous_step(difference.end_2);
+            if (pack_side(graph_1, graph_1->get_handle_of_step(prev_1)) != pack_side(graph_2, graph_2->get_handle_of_step(prev_2))) {
+                break;
+            }
+            difference.end_1 = prev_1;
+            difference.end_2 = prev_2;
+        }
+    });
+    
+    for (size_t i = 0; i < pairs.size(); i++) {
+        if (!pairs[i].second) {
+            equivalent = false;
+            if (callbacks.path_removed) {
+                callbacks.path_removed(*pairs[i].first);
+            }
+        } else if (!pairs[i].first) {
+            equivalent = false;
+            if (callbacks.path_added) {
+                callbacks.path_added(*pairs[i].second);
+            }
+        } else if (path_differences[i].differs) {
+            equivalent = false;
+            auto& difference = path_differences[i];
+            if (callbacks.path_changed) {
+                callbacks.path_changed(*pairs[i].first, difference.begin_1, difference.end_1,
+                                       *pairs[i].second, difference.begin_2, difference.end_2);
+            }
+        }
+    }
+    
+    return equivalent;
+}
+
+}
+}
@@ -2,6 +2,8 @@
 
 #include "handlegraph/util.hpp"
 
+#include <algorithm>
+
 /** \file handle_graphs.cpp
  * Implement handle graph methods.
  */
@@ -94,6 +96,111 @@ std::string HandleGraph::get_subsequence(const handle_t& handle, size_t index, s
     return get_sequence(handle).substr(index, size);
 }
 
+size_t HandleGraph::copy_sequence(const handle_t& handle, char* dest) const {
+    std::string sequence = get_sequence(handle);
+    std::copy(sequence.begin(), sequence.end(), dest);
+    return sequence.size();
+}
+
+bool HandleGraph::has_efficient_cursors() const {
+    return false;
+}
+
+size_t HandleGraph::get_next_handles(uint64_t& cursor, handle_t* buffer, size_t max_handles) const {
+    uint64_t seen = 0;
+    size_t count = 0;
+    if (max_handles != 0) {
+        for_each_handle([&](const handle_t& handle) {
+            if (seen++ >= cursor) {
+                buffer[count++] = handle;
+            }
+            return count < max_handles;
+        });
+    }
+    cursor += count;
+    return count;
+}
+
+size_t HandleGraph::get_next_neighbors(const handle_t& handle, bool go_left, uint64_t& cursor,
+                                       handle_t* buffer, size_t max_handles) const {
+    uint64_t seen = 0;
+    size_t count = 0;
+    if (max_handles != 0) {
+        follow_edges(handle, go_left, [&](const handle_t& next) {
+            if (seen++ >= cursor) {
+                buffer[count++] = next;
+            }
+            return count < max_handles;
+        });
+    }
+    cursor += count;
+    return count;
+}
+
+Cursor<handle_t> HandleGraph::scan_handles() const {
+    if (has_efficient_cursors()) {
+        uint64_t cursor = 0;
+        return Cursor<handle_t>([this, cursor](handle_t* buffer, size_t max_handles) mutable {
+            return get_next_handles(cursor, buffer, max_handles);
+        });
+    }
+    std::vector<handle_t> handles;
+    handles.reserve(get_node_count());
+    for_each_handle([&](const handle_t& handle) {
+        handles.push_back(handle);
+    });
+    return Cursor<handle_t>(std::move(handles));
+}
+
+Cursor<handle_t> HandleGraph::scan_neighbors(const handle_t& handle, bool go_left) const {
+    if (has_efficient_cursors()) {
+        uint64_t cursor = 0;
+        return Cursor<handle_t>([this, handle, go_left, cursor](handle_t* buffer, size_t max_handles) mutable {
+            return get_next_neighbors(handle, go_left, cursor, buffer, max_handles);
+        });
+    }
+    std::vector<handle_t> neighbors;
+    follow_edges(handle, go_left, [&](const handle_t& next) {
+        neighbors.push_back(next);
+    });
+    return Cursor<handle_t>(std::move(neighbors));
+}
+
+Cursor<edge_t> HandleGraph::scan_edges() const {
+    // Collect each node's edges when we reach it, filtered the same way as
+    // for_each_edge() does.
+    Cursor<handle_t> handles = scan_handles();
+    std::vector<edge_t> pending;
+    size_t used = 0;
+    return Cursor<edge_t>([this, handles, pending, used](edge_t* buffer, size_t max_edges) mutable {
+        size_t count = 0;
+        while (count < max_edges) {
+            if (used < pending.size()) {
+                buffer[count++] = pending[used++];
+                continue;
+            }
+            if (handles.done()) {
+                break;
+            }
+            handle_t handle = handles.next();
+            pending.clear();
+            used = 0;
+            follow_edges(handle, false, [&](const handle_t& next) {
+                if (get_id(handle) <= get_id(next)) {
+                    pending.push_back(edge_handle(handle, next));
+                }
+            });
+            follow_edges(handle, true, [&](const handle_t& prev) {
+                if (get_id(handle) < get_id(prev) ||
+                    (get_id(handle) == get_id(prev) && get_is_reverse(prev))) {
+                    pending.push_back(edge_handle(prev, handle));
+                }
+            });
+        }
+        return count;
+    });
+}
+
 }
 
 
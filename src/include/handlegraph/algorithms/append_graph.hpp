@@ -4,7 +4,8 @@
 /**
  * \file append_graph.hpp
  *
- * Defines algorithms for appending handle graphs
+ * Defines algorithms for appending handle graphs. To present several graphs
+ * as one without copying them, see UnionOverlay.
  */
 
 #include "handlegraph/mutable_path_mutable_handle_graph.hpp"
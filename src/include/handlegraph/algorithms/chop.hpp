@@ -32,6 +32,13 @@ void chop(MutablePathDeletableHandleGraph& graph, size_t max_node_length);
  */
 void chop(MutablePathDeletableHandleGraph& graph, size_t max_node_length, const std::function<void(nid_t, size_t, size_t, handle_t)>& record_change);
 
+/**
+ * Return true if nodes share all paths and the mappings they share in these
+ * paths are adjacent, in the specified relative order and orientation. Such
+ * nodes can be glued together by unchop() without breaking any paths.
+ */
+bool nodes_are_perfect_path_neighbors(const PathHandleGraph& graph, handle_t left_handle, handle_t right_handle);
+
 /**
  * Unchop by gluing abutting handles with just a single edge between them and
  * compatible path steps together. Broadly preserves relative ordering of
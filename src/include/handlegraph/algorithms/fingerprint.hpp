@@ -0,0 +1,116 @@
+#ifndef HANDLEGRAPH_ALGORITHMS_FINGERPRINT_HPP_INCLUDED
+#define HANDLEGRAPH_ALGORITHMS_FINGERPRINT_HPP_INCLUDED
+
+/**
+ * \file fingerprint.hpp
+ *
+ * Defines an order-independent fingerprint of a graph's contents, for
+ * checking whether two graphs are equivalent without walking them together.
+ */
+
+#include "handlegraph/path_handle_graph.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <array>
+#include <vector>
+#include <string>
+
+namespace handlegraph {
+namespace algorithms {
+
+/// A 256-bit digest, as 4 64-bit lanes.
+using fingerprint_t = std::array<uint64_t, 4>;
+
+/// Default number of buckets that fingerprints are broken into.
+extern const size_t DEFAULT_FINGERPRINT_BUCKET_COUNT;
+
+/**
+ * A fingerprint of a graph. Each node, edge, and path step is hashed on its
+ * own, and the hashes are added up lane by lane, so the fingerprint does not
+ * depend on the order in which things are stored or visited, or on handle
+ * values. Node IDs, sequences, edges, path names, circularity, and the order
+ * of steps along paths all contribute.
+ *
+ * Sums are also kept for buckets of nodes (with the edges for which they have
+ * the lowest ID), and of paths, by a hash of the node ID or path name, so
+ * that a mismatch can be narrowed down.
+ */
+struct GraphFingerprint {
+    /// Digest of everything
+    fingerprint_t digest = {{0, 0, 0, 0}};
+    /// Digest of just the nodes
+    fingerprint_t node_digest = {{0, 0, 0, 0}};
+    /// Digest of just the edges
+    fingerprint_t edge_digest = {{0, 0, 0, 0}};
+    /// Digest of just the paths
+    fingerprint_t path_digest = {{0, 0, 0, 0}};
+    /// Digests of buckets of nodes and their edges
+    std::vector<fingerprint_t> node_buckets;
+    /// Digests of buckets of paths
+    std::vector<fingerprint_t> path_buckets;
+    
+    /// Return true if the digests are the same.
+    bool operator==(const GraphFingerprint& other) const;
+    /// Return true if the digests are different.
+    bool operator!=(const GraphFingerprint& other) const;
+    
+    /// Get the digest as 64 hex digits.
+    std::string to_string() const;
+};
+
+/// The buckets where two fingerprints differ.
+struct FingerprintDifference {
+    std::vector<size_t> node_buckets;
+    std::vector<size_t> path_buckets;
+    
+    /// Return true if there are no differences.
+    bool empty() const;
+};
+
+/// Compute the fingerprint of the nodes and edges of a graph, in parallel as
+/// the execution options say.
+GraphFingerprint compute_fingerprint(const HandleGraph* graph,
+                                     const ExecutionOptions& execution = ExecutionOptions(),
+                                     size_t bucket_count = DEFAULT_FINGERPRINT_BUCKET_COUNT);
+
+/// Compute the fingerprint of the nodes, edges, and paths of all senses in a
+/// graph, in parallel as the execution options say.
+GraphFingerprint compute_fingerprint_with_paths(const PathHandleGraph* graph,
+                                                const ExecutionOptions& execution = ExecutionOptions(),
+                                                size_t bucket_count = DEFAULT_FINGERPRINT_BUCKET_COUNT);
+
+/// Find the buckets where two fingerprints, computed with the same number of
+/// buckets, differ. Throws std::runtime_error if the bucket counts differ.
+FingerprintDifference compare_fingerprints(const GraphFingerprint& fingerprint_1,
+                                           const GraphFingerprint& fingerprint_2);
+
+/// Get the bucket a node is fingerprinted in.
+size_t get_fingerprint_bucket(const nid_t& node_id, size_t bucket_count);
+
+/// Get the bucket a path is fingerprinted in.
+size_t get_fingerprint_bucket(const std::string& path_name, size_t bucket_count);
+
+/// Given the differences between fingerprints of two graphs, find the IDs of
+/// the nodes in the differing buckets that are missing from one graph, or
+/// have a different sequence or different edges to higher IDs. Only the nodes
+/// in those buckets are rehashed. Returns IDs in sorted order.
+std::vector<nid_t> find_differing_nodes(const HandleGraph* graph_1,
+                                        const HandleGraph* graph_2,
+                                        const FingerprintDifference& difference,
+                                        size_t bucket_count = DEFAULT_FINGERPRINT_BUCKET_COUNT,
+                                        const ExecutionOptions& execution = ExecutionOptions());
+
+/// Given the differences between fingerprints of two graphs, find the names
+/// of the paths in the differing buckets that are missing from one graph or
+/// differ. Only the paths in those buckets are rehashed. Returns names in
+/// sorted order.
+std::vector<std::string> find_differing_paths(const PathHandleGraph* graph_1,
+                                              const PathHandleGraph* graph_2,
+                                              const FingerprintDifference& difference,
+                                              size_t bucket_count = DEFAULT_FINGERPRINT_BUCKET_COUNT,
+                                              const ExecutionOptions& execution = ExecutionOptions());
+
+}
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef HANDLEGRAPH_ALGORITHMS_FOR_EACH_PATH_RANGE_HPP_INCLUDED
+#define HANDLEGRAPH_ALGORITHMS_FOR_EACH_PATH_RANGE_HPP_INCLUDED
+
+/**
+ * \file for_each_path_range.hpp
+ *
+ * Defines a parallel scheduler for processing the steps of many paths of
+ * very different lengths.
+ */
+
+#include "handlegraph/path_handle_graph.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <vector>
+
+namespace handlegraph {
+namespace algorithms {
+
+/// Default number of bases (or steps) in each range handed out by
+/// for_each_path_range_parallel().
+extern const size_t DEFAULT_PATH_RANGE_LENGTH;
+
+/// Call the iteratee, in parallel, on consecutive runs of steps covering all
+/// of the given paths. The iteratee receives the path, the first step of the
+/// run, and the handles of the run's steps in path order. Each run holds at
+/// most range_length steps.
+///
+/// If the graph is a PathPositionHandleGraph, long paths are cut at about
+/// every range_length bases using get_step_at_position(), and the pieces are
+/// processed independently. Otherwise each path is processed whole by one
+/// thread, and its runs are delivered in order. Either way, the biggest work
+/// is scheduled first, and threads take more work as they become free.
+///
+/// Runs in parallel as the execution options say.
+void for_each_path_range_parallel(const PathHandleGraph* graph,
+                                  const std::vector<path_handle_t>& paths,
+                                  const std::function<void(const path_handle_t&, const step_handle_t&, const handle_t*, size_t)>& iteratee,
+                                  size_t range_length = DEFAULT_PATH_RANGE_LENGTH,
+                                  const ExecutionOptions& execution = ExecutionOptions());
+
+/// Call the iteratee, in parallel, on consecutive runs of steps covering all
+/// paths of all senses in the graph. See the version taking a vector of
+/// paths.
+void for_each_path_range_parallel(const PathHandleGraph* graph,
+                                  const std::function<void(const path_handle_t&, const step_handle_t&, const handle_t*, size_t)>& iteratee,
+                                  size_t range_length = DEFAULT_PATH_RANGE_LENGTH,
+                                  const ExecutionOptions& execution = ExecutionOptions());
+
+}
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef HANDLEGRAPH_ALGORITHMS_FOR_EACH_RANK_RANGE_HPP_INCLUDED
+#define HANDLEGRAPH_ALGORITHMS_FOR_EACH_RANK_RANGE_HPP_INCLUDED
+
+/**
+ * \file for_each_rank_range.hpp
+ *
+ * Defines a parallel driver over fixed blocks of node ranks, for work that
+ * needs to be split up and put back together the same way every time.
+ */
+
+#include "handlegraph/handle_graph.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <type_traits>
+
+namespace handlegraph {
+namespace algorithms {
+
+/// Default number of node ranks in each block handed out by
+/// for_each_rank_range_parallel().
+extern const size_t DEFAULT_RANK_BLOCK_SIZE;
+
+/// Get the range of node ranks [first, second) that is the given part when
+/// the graph's nodes are split into part_count nearly equal contiguous parts,
+/// as when dividing a graph between machines. Throws std::runtime_error if
+/// part is not less than part_count.
+std::pair<size_t, size_t> get_rank_partition(const RankedHandleGraph* graph, size_t part, size_t part_count);
+
+/// Get the number of blocks that for_each_rank_range_parallel() splits the
+/// node ranks [begin_rank, end_rank) into.
+size_t get_rank_block_count(size_t begin_rank, size_t end_rank, size_t block_size = DEFAULT_RANK_BLOCK_SIZE);
+
+/// Call the iteratee, in parallel, on contiguous blocks of the node ranks
+/// [begin_rank, end_rank). Ranks start at 1, and ranks past the last node
+/// are ignored. The iteratee receives the block's number, counting from 0,
+/// and the block's own range of ranks, and can visit its nodes in order with
+/// for_each_handle_in_range(). Block k starts at begin_rank + k * block_size,
+/// so the blocks are the same no matter how many threads run them.
+///
+/// Runs in parallel as the execution options say.
+void for_each_rank_range_parallel(const RankedHandleGraph* graph,
+                                  size_t begin_rank, size_t end_rank,
+                                  const std::function<void(size_t, size_t, size_t)>& iteratee,
+                                  size_t block_size = DEFAULT_RANK_BLOCK_SIZE,
+                                  const ExecutionOptions& execution = ExecutionOptions());
+
+/// Compute a result for each block of the node ranks [begin_rank, end_rank),
+/// in parallel as in for_each_rank_range_parallel(), and fold them together
+/// in block order. map is called with a block's range of ranks, and combine
+/// is called with the running total and the next block's result, which it
+/// may move from. For example, appending vectors concatenates the blocks'
+/// results in rank order. Returns a default-constructed result if there are
+/// no ranks. All the blocks' results are held until they are combined.
+template<typename Map, typename Combine>
+auto reduce_rank_ranges(const RankedHandleGraph* graph,
+                        size_t begin_rank, size_t end_rank,
+                        const Map& map, const Combine& combine,
+                        size_t block_size = DEFAULT_RANK_BLOCK_SIZE,
+                        const ExecutionOptions& execution = ExecutionOptions())
+    -> typename std::decay<decltype(map(begin_rank, end_rank))>::type;
+
+////////////////////////////////////////////////////////////////////////////
+// Template Implementations
+////////////////////////////////////////////////////////////////////////////
+
+template<typename Map, typename Combine>
+auto reduce_rank_ranges(const RankedHandleGraph* graph,
+                        size_t begin_rank, size_t end_rank,
+                        const Map& map, const Combine& combine,
+                        size_t block_size,
+                        const ExecutionOptions& execution)
+    -> typename std::decay<decltype(map(begin_rank, end_rank))>::type {
+
+    using Result = typename std::decay<decltype(map(begin_rank, end_rank))>::type;
+
+    end_rank = std::min(end_rank, graph->get_node_count() + 1);
+    std::vector<Result> results(get_rank_block_count(begin_rank, end_rank, block_size));
+    for_each_rank_range_parallel(graph, begin_rank, end_rank, [&](size_t block, size_t block_begin, size_t block_end) {
+        results[block] = map(block_begin, block_end);
+    }, block_size, execution);
+
+    if (results.empty()) {
+        return Result();
+    }
+    Result total = std::move(results.front());
+    for (size_t i = 1; i < results.size(); i++) {
+        combine(total, std::move(results[i]));
+    }
+    return total;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef HANDLEGRAPH_ALGORITHMS_GRAPH_DIFF_HPP_INCLUDED
+#define HANDLEGRAPH_ALGORITHMS_GRAPH_DIFF_HPP_INCLUDED
+
+/**
+ * \file graph_diff.hpp
+ *
+ * Defines an algorithm for finding all the differences between two graphs.
+ */
+
+#include "handlegraph/path_handle_graph.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <functional>
+
+namespace handlegraph {
+namespace algorithms {
+
+/**
+ * Functions to call for each difference found by diff_graphs(). Any can be
+ * left empty. Things only in the first graph are removed, and things only in
+ * the second graph are added. Handles passed are from the graph the thing is
+ * in, or from the first graph for changes.
+ */
+struct GraphDiffCallbacks {
+    std::function<void(const nid_t&)> node_removed;
+    std::function<void(const nid_t&)> node_added;
+    /// Called for a node in both graphs with different sequences
+    std::function<void(const nid_t&)> node_changed;
+    std::function<void(const edge_t&)> edge_removed;
+    std::function<void(const edge_t&)> edge_added;
+    std::function<void(const path_handle_t&)> path_removed;
+    std::function<void(const path_handle_t&)> path_added;
+    /// Called for paths with the same name in both graphs but different
+    /// steps, with the path and the range of differing steps in the first
+    /// graph, and then in the second graph. Ranges are past-the-end, and
+    /// leave out the longest common prefix and then suffix of the steps.
+    /// Each changed path is reported once, as a single range, so a path
+    /// with two small edits near its ends is reported as changed almost end
+    /// to end; matching steps between separate edits are not found.
+    std::function<void(const path_handle_t&, const step_handle_t&, const step_handle_t&,
+                       const path_handle_t&, const step_handle_t&, const step_handle_t&)> path_changed;
+};
+
+/// Find all the differences in nodes, sequences, and edges between two
+/// graphs, in parallel as the execution options say, and report them through
+/// the callbacks. Nodes are matched up by ID, and edges are compared node by
+/// node, in blocks of IDs. Node and edge differences are reported in order of
+/// the lowest node ID involved. Callbacks are called by one thread at a time.
+/// Returns true if the graphs are equivalent.
+///
+/// Only a few blocks per thread may be started past the first block not yet
+/// reported, so only the differences found in those blocks are ever held
+/// waiting to be reported. If the node IDs are very sparse, with the range of
+/// IDs more than 4 times the total number of nodes in both graphs, every ID
+/// in either graph is listed and sorted first, which takes memory
+/// proportional to the total number of nodes.
+bool diff_graphs(const HandleGraph* graph_1,
+                 const HandleGraph* graph_2,
+                 const GraphDiffCallbacks& callbacks,
+                 const ExecutionOptions& execution = ExecutionOptions());
+
+/// Find all the differences in nodes, sequences, edges, and paths of all
+/// senses between two graphs. Paths are matched up by name, and reported in
+/// name order after the nodes and edges. See the version without paths.
+bool diff_graphs_with_paths(const PathHandleGraph* graph_1,
+                            const PathHandleGraph* graph_2,
+                            const GraphDiffCallbacks& callbacks,
+                            const ExecutionOptions& execution = ExecutionOptions());
+
+}
+}
+
+#endif
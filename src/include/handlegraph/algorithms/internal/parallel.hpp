@@ -0,0 +1,26 @@
+#ifndef HANDLEGRAPH_ALGORITHMS_INTERNAL_PARALLEL_HPP_INCLUDED
+#define HANDLEGRAPH_ALGORITHMS_INTERNAL_PARALLEL_HPP_INCLUDED
+
+#include <functional>
+#include <cstddef>
+
+namespace handlegraph {
+namespace algorithms {
+namespace internal {
+
+/// Get the number of threads to use when 0 is requested.
+size_t default_thread_count();
+
+/// Call body on every index in [0, count), using up to thread_count threads
+/// (or default_thread_count() if 0) from the shared WorkStealingExecutor.
+/// Threads that run out of indexes steal from the others, so tasks of very
+/// different sizes balance out. If any call throws, the remaining indexes are
+/// skipped and one of the exceptions is rethrown. Code that takes
+/// ExecutionOptions should use their parallel_for() instead.
+void parallel_for(size_t count, size_t thread_count, const std::function<void(size_t)>& body);
+
+}
+}
+}
+
+#endif
@@ -9,6 +9,7 @@
 
 #include "handlegraph/mutable_handle_graph.hpp"
 #include "handlegraph/algorithms/apply_orientations.hpp"
+#include "handlegraph/execution.hpp"
 
 #include <unordered_set>
 #include <vector>
@@ -27,8 +28,18 @@ bool is_single_stranded(const HandleGraph* graph);
 /// That is, if all of the reverse handles (or all of the forward handles) were swapped
 /// in orientation, the graph would contain no reversing edges. Returns an empty vector
 /// if there is no such combination of node orientations (also if graph has no nodes).
+/// An OrientationOverlay can present the result without modifying the graph.
 std::vector<handle_t> single_stranded_orientation(const HandleGraph* graph);
 
+/// Finds the same kind of orientation as single_stranded_orientation(), in
+/// parallel as the execution options say. Returns a
+/// dense vector with a flag for each node ID from the graph's min_node_id()
+/// through max_node_id() that is set if the node needs to be flipped, as can
+/// be passed to an OrientationOverlay. Returns an empty vector if there is no
+/// such combination of node orientations (also if graph has no nodes). Uses
+/// memory proportional to the range of node IDs.
+std::vector<bool> single_stranded_flips(const HandleGraph* graph, const ExecutionOptions& execution = ExecutionOptions());
+
 /// Finds a set of node orientations that can be applied so that there are no
 /// reversing edges (i.e. every edge connects a locally forward node traversal
 /// to another locally forward orientation). If no such combination of orientations
@@ -0,0 +1,69 @@
+#ifndef HANDLEGRAPH_ALGORITHMS_PATH_DEPTH_HPP_INCLUDED
+#define HANDLEGRAPH_ALGORITHMS_PATH_DEPTH_HPP_INCLUDED
+
+/**
+ * \file path_depth.hpp
+ *
+ * Defines an algorithm for counting how many path steps visit each node.
+ */
+
+#include "handlegraph/path_handle_graph.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <vector>
+#include <string>
+
+namespace handlegraph {
+namespace algorithms {
+
+/// How to break down the path depth of each node.
+enum class PathDepthGrouping {
+    /// Count all steps together
+    NONE,
+    /// Count steps separately for each PathSense. Groups are in the order of
+    /// the PathSense values.
+    BY_SENSE,
+    /// Count steps separately for each sample name, including
+    /// PathMetadata::NO_SAMPLE_NAME for paths without one.
+    BY_SAMPLE
+};
+
+/// How to traverse the graph when computing path depth.
+enum class PathDepthStrategy {
+    /// Pick whichever of the other strategies looks cheaper
+    AUTOMATIC,
+    /// Walk the paths, adding to shared atomic counters
+    PATH_MAJOR,
+    /// Visit each node and look at the steps on it
+    NODE_MAJOR
+};
+
+/// Dense per-node path depth tables, one per group.
+struct PathDepth {
+    /// The node ID at index 0 of each table
+    nid_t min_id = 0;
+    /// The name of each group
+    std::vector<std::string> group_names;
+    /// For each group, the number of steps on each node, indexed by node ID
+    /// minus min_id. IDs not in the graph have depth 0.
+    std::vector<std::vector<uint64_t>> depth;
+    
+    /// Get the depth of a node in a group, or 0 if it is out of range.
+    uint64_t get_depth(nid_t node_id, size_t group = 0) const;
+    
+    /// Get the depth of a node over all groups.
+    uint64_t get_total_depth(nid_t node_id) const;
+};
+
+/// Count the steps of paths of all senses on each node of the graph, in
+/// parallel as the execution options say, broken down by the given
+/// grouping.
+PathDepth compute_path_depth(const PathHandleGraph* graph,
+                             PathDepthGrouping grouping = PathDepthGrouping::NONE,
+                             const ExecutionOptions& execution = ExecutionOptions(),
+                             PathDepthStrategy strategy = PathDepthStrategy::AUTOMATIC);
+
+}
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef HANDLEGRAPH_ALGORITHMS_PATH_INTERVALS_HPP_INCLUDED
+#define HANDLEGRAPH_ALGORITHMS_PATH_INTERVALS_HPP_INCLUDED
+
+/**
+ * \file path_intervals.hpp
+ *
+ * Defines queries for the parts of paths that pass through a region of the
+ * graph, given as ranges of node IDs.
+ */
+
+#include "handlegraph/path_handle_graph.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <vector>
+
+namespace handlegraph {
+namespace algorithms {
+
+/// A maximal run of consecutive steps on a path that stays in a query region.
+struct PathInterval {
+    path_handle_t path;
+    /// The first step in the run
+    step_handle_t first;
+    /// The last step in the run, which is included
+    step_handle_t last;
+    /// The offset of the start of the first step on the path, if requested
+    size_t start_position = 0;
+    /// The offset past the end of the last step on the path, if requested.
+    /// This is not after start_position if the run wraps around the start of
+    /// a circular path.
+    size_t end_position = 0;
+};
+
+/**
+ * An index from node IDs to the path steps visiting them, for answering many
+ * path interval queries without asking the graph for the steps on each node.
+ * The index is invalidated if the graph's paths change.
+ */
+class PathIntervalIndex {
+public:
+    /// Index the steps of the paths visible to for_each_path_handle(), in
+    /// parallel as the execution options say.
+    PathIntervalIndex(const PathHandleGraph* graph, const ExecutionOptions& execution = ExecutionOptions());
+    
+    /// Execute a function on the first and last steps of each maximal run of
+    /// consecutive path steps that visit nodes in the given inclusive,
+    /// sorted, non-overlapping ID ranges. If it returns false, stop
+    /// iteration. Returns true if we finished and false if we stopped early.
+    bool for_each_path_interval(const std::vector<std::pair<nid_t, nid_t>>& id_ranges,
+                                const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const;
+    
+protected:
+    const PathHandleGraph* graph;
+    /// Node ID of each indexed step, sorted
+    std::vector<nid_t> step_ids;
+    /// Indexed steps, in the same order
+    std::vector<step_handle_t> steps;
+};
+
+/// Convert a collection of node IDs, in any order and possibly with
+/// duplicates, into inclusive, sorted, non-overlapping ID ranges.
+std::vector<std::pair<nid_t, nid_t>> node_ids_to_ranges(std::vector<nid_t> node_ids);
+
+/// Find the maximal runs of consecutive path steps that visit nodes in the
+/// given inclusive, sorted, non-overlapping ID ranges, sorted by path and
+/// then by position along the path. If an index is given, it is used instead
+/// of the graph's own query. If include_positions is set, the graph must be
+/// a PathPositionHandleGraph, and the positions of the runs are filled in;
+/// otherwise std::runtime_error is thrown. Without positions, runs on the
+/// same path are put in order by walking the steps between them, so the cost
+/// depends on how far apart the runs are rather than on the path's length.
+/// On a circular path, the order starts after one of the gaps between runs.
+std::vector<PathInterval> find_path_intervals(const PathHandleGraph* graph,
+                                              const std::vector<std::pair<nid_t, nid_t>>& id_ranges,
+                                              bool include_positions = false,
+                                              const PathIntervalIndex* index = nullptr);
+
+}
+}
+
+#endif
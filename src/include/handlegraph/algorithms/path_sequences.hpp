@@ -0,0 +1,74 @@
+#ifndef HANDLEGRAPH_ALGORITHMS_PATH_SEQUENCES_HPP_INCLUDED
+#define HANDLEGRAPH_ALGORITHMS_PATH_SEQUENCES_HPP_INCLUDED
+
+/**
+ * \file path_sequences.hpp
+ *
+ * Defines tools for spelling out the sequences of many paths at once, in
+ * parallel, into memory or into a FASTA file.
+ */
+
+#include "handlegraph/path_handle_graph.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <vector>
+#include <string>
+#include <unordered_set>
+
+namespace handlegraph {
+namespace algorithms {
+
+/// Get the length in bases of each of the given paths. Uses
+/// get_path_length() if the graph is a PathPositionHandleGraph, and otherwise
+/// adds up node lengths in parallel.
+std::vector<size_t> get_path_lengths(const PathHandleGraph* graph,
+                                     const std::vector<path_handle_t>& paths,
+                                     const ExecutionOptions& execution = ExecutionOptions());
+
+/// Spell out the sequences of the given distinct paths. For each path, in
+/// order and from the calling thread, get_buffer is called with the path and
+/// its length in bases, and must return a buffer with room for that many
+/// characters, or nullptr to skip the path. The buffers are then filled in
+/// parallel, with long paths split across threads where the graph supports
+/// path position queries. Runs as the execution options say.
+void extract_path_sequences(const PathHandleGraph* graph,
+                            const std::vector<path_handle_t>& paths,
+                            const std::function<char*(const path_handle_t&, size_t)>& get_buffer,
+                            const ExecutionOptions& execution = ExecutionOptions());
+
+/// Spell out the sequences of the paths matching the given filters, which are
+/// interpreted as in for_each_path_matching(). See the version taking a
+/// vector of paths.
+void extract_path_sequences(const PathHandleGraph* graph,
+                            const std::unordered_set<PathSense>* senses,
+                            const std::unordered_set<std::string>* samples,
+                            const std::unordered_set<std::string>* loci,
+                            const std::function<char*(const path_handle_t&, size_t)>& get_buffer,
+                            const ExecutionOptions& execution = ExecutionOptions());
+
+/// Write the given distinct paths as FASTA records to the given file
+/// descriptor, which must support pwrite(), starting at the beginning of the
+/// file. Sequence lines are wrapped at line_width bases, or not at all if 0.
+/// The records are laid out in advance and written in parallel, each piece
+/// directly at its final offset. Throws std::runtime_error if writing fails.
+void write_path_fasta(const PathHandleGraph* graph,
+                      const std::vector<path_handle_t>& paths,
+                      int fd,
+                      size_t line_width = 60,
+                      const ExecutionOptions& execution = ExecutionOptions());
+
+/// Write the paths matching the given filters, which are interpreted as in
+/// for_each_path_matching(), as FASTA records to the given file, replacing
+/// it. See the version taking a vector of paths.
+void write_path_fasta(const PathHandleGraph* graph,
+                      const std::unordered_set<PathSense>* senses,
+                      const std::unordered_set<std::string>* samples,
+                      const std::unordered_set<std::string>* loci,
+                      const std::string& filename,
+                      size_t line_width = 60,
+                      const ExecutionOptions& execution = ExecutionOptions());
+
+}
+}
+
+#endif
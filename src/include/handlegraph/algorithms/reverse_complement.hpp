@@ -15,7 +15,8 @@ namespace algorithms {
 /// Fills a MutableHandleGraph 'into' with a graph that has the same sequence and path
 /// space as 'source', but the forward strand of every node is flipped to the reverse
 /// strand. Reports an error and exits if 'into' is not empty. Node IDs will match between
-/// the two graphs.
+/// the two graphs. To get the same graph as a view without copying, use a
+/// ReverseComplementOverlay.
 void reverse_complement_graph(const HandleGraph* source,
                               MutableHandleGraph* into);
 
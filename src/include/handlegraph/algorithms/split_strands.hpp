@@ -19,7 +19,8 @@ namespace algorithms {
 /// accomplished by creating a new node for each node in the source graph with the reverse
 /// complement sequence. Returns a map that translates forward-oriented handles from 'into' to
 /// the corresponding handle in 'source'. Reports an error and exits if 'into' is not
-/// empty.
+/// empty. To get the same graph as a view without copying, use a
+/// StrandSplitOverlay.
 std::unordered_map<handle_t, handle_t> split_strands(const HandleGraph* source,
                                                      MutableHandleGraph* into);
 
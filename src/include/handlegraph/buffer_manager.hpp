@@ -0,0 +1,151 @@
+#ifndef HANDLEGRAPH_BUFFER_MANAGER_HPP_INCLUDED
+#define HANDLEGRAPH_BUFFER_MANAGER_HPP_INCLUDED
+
+/** \file
+ * Defines a page cache for reading files too big to hold in memory.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * Reads byte ranges from a file through a cache of fixed-size pages, which
+ * holds at most a given number of bytes and evicts the least recently used
+ * pages first. Safe to use from many threads at once.
+ *
+ * A background thread reads pages before they are needed. Pages can be
+ * requested explicitly with prefetch(), and when a page that was read ahead
+ * is first used, the pages after it are queued too, so scans through the file
+ * keep the disk busy without being asked.
+ *
+ * The file must not change while the manager exists.
+ */
+class BufferManager {
+public:
+
+    /// Bytes in a page, if not specified.
+    static const size_t DEFAULT_PAGE_SIZE;
+
+    /// Bytes of pages to keep in memory, if not specified.
+    static const size_t DEFAULT_MEMORY_BUDGET;
+
+    /// Number of pages to read ahead of a scan, if not specified.
+    static const size_t DEFAULT_READ_AHEAD_PAGES;
+
+    /// Read from the given open file descriptor, which is not closed. Uses up
+    /// to about memory_budget bytes for pages, and reads up to
+    /// read_ahead_pages ahead of scans, or none if 0.
+    BufferManager(int fd, size_t memory_budget = DEFAULT_MEMORY_BUDGET,
+                  size_t page_size = DEFAULT_PAGE_SIZE,
+                  size_t read_ahead_pages = DEFAULT_READ_AHEAD_PAGES);
+
+    /// Stop reading ahead and release the pages.
+    ~BufferManager();
+
+    BufferManager(const BufferManager& other) = delete;
+    BufferManager& operator=(const BufferManager& other) = delete;
+
+    /// Copy length bytes starting at the given offset in the file to dest.
+    /// Throws if the range is not all in the file or the file can't be read.
+    void read(uint64_t offset, size_t length, void* dest) const;
+
+    /// Hint that the given range of the file will be read soon, and queue
+    /// its pages to be read in the background.
+    void prefetch(uint64_t offset, size_t length) const;
+
+    /// Get the length of the file.
+    uint64_t get_file_size() const;
+
+    /// Get the number of bytes in a page.
+    size_t get_page_size() const;
+
+    /// Get the number of page lookups that found the page in memory.
+    size_t get_page_hits() const;
+
+    /// Get the number of page lookups that had to wait for a read.
+    size_t get_page_misses() const;
+
+    /// Get the number of pages read from the file, including reads ahead.
+    size_t get_pages_read() const;
+
+protected:
+
+    /// A page's worth of the file. Its data doesn't change once it is ready.
+    struct Page {
+        std::vector<char> data;
+        /// True once the data has been read
+        bool ready = false;
+        /// True if reading the data failed
+        bool failed = false;
+        /// True if the page was read ahead and hasn't been used yet
+        bool read_ahead = false;
+    };
+
+    /// A page held in memory, and its place in the recency list
+    struct Frame {
+        std::shared_ptr<Page> page;
+        std::list<uint64_t>::iterator recency;
+    };
+
+    /// Get the given page, reading it if necessary. If for_read_ahead is
+    /// false, counts as a use of the page.
+    std::shared_ptr<Page> get_page(uint64_t number, bool for_read_ahead) const;
+
+    /// Fill in a new page from the file and mark it ready or failed. If
+    /// reading fails and rethrow is set, throws the error.
+    void load_page(uint64_t number, Page& page, bool rethrow) const;
+
+    /// Queue the given pages to be read ahead, if they aren't in memory. Must
+    /// hold the mutex.
+    void enqueue(uint64_t first, uint64_t past_last) const;
+
+    /// Body of the background thread.
+    void read_ahead_loop();
+
+    /// File to read from
+    int fd;
+    /// Length of the file
+    uint64_t file_size;
+    /// Bytes in each page
+    size_t page_size;
+    /// Number of pages to keep in memory
+    size_t page_budget;
+    /// Number of pages to read ahead of a scan
+    size_t read_ahead_pages;
+
+    /// Protects everything below
+    mutable std::mutex mutex;
+    /// Notified when a page is done being read
+    mutable std::condition_variable page_loaded;
+    /// Notified when pages are queued or we are stopping
+    mutable std::condition_variable queue_changed;
+    /// Pages in memory, or being read
+    mutable std::unordered_map<uint64_t, Frame> frames;
+    /// Page numbers in memory, most recently used first
+    mutable std::list<uint64_t> recency;
+    /// Page numbers to read ahead
+    mutable std::deque<uint64_t> queue;
+    /// True when the background thread should finish
+    bool stopping = false;
+
+    mutable std::atomic<size_t> hits;
+    mutable std::atomic<size_t> misses;
+    mutable std::atomic<size_t> pages_read;
+
+    /// Background thread reading ahead
+    std::thread reader;
+};
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef HANDLEGRAPH_COMPRESSED_PATH_HPP_INCLUDED
+#define HANDLEGRAPH_COMPRESSED_PATH_HPP_INCLUDED
+
+/** \file 
+ * Defines a compressed storage component for the handles visited by a path,
+ * for use by path handle graph implementations.
+ */
+
+#include "handlegraph/types.hpp"
+
+#include <vector>
+#include <iostream>
+
+namespace handlegraph {
+
+/**
+ * A compressed sequence of handles, as visited by a path. Handles are
+ * treated as integers and stored as runs of equal differences between
+ * successive handles, with each run written as a varint run length and a
+ * zigzag varint difference. Walking along consecutively numbered nodes, as
+ * most paths do for most of their length, costs a couple of bytes per run
+ * instead of 8 bytes per step.
+ *
+ * A checkpoint is kept at the start of a run about every CHECKPOINT_INTERVAL
+ * steps, so looking up step k takes a binary search and a bounded scan.
+ *
+ * Appending is amortized O(1); other edits re-encode everything after the
+ * edit.
+ *
+ * Steps are addressed by rank. The make_step(), get_path(), and get_rank()
+ * helpers pack and unpack step handles in the usual [path handle, rank]
+ * layout, so an implementation can hand these out directly. Such step
+ * handles are invalidated by edits before them.
+ */
+class CompressedPath {
+public:
+    
+    /// Make an empty path.
+    CompressedPath() = default;
+    
+    /// Make a path holding the given handles.
+    CompressedPath(const std::vector<handle_t>& handles);
+    
+    /// Approximate number of steps between checkpoints.
+    static const size_t CHECKPOINT_INTERVAL;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Access
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Get the number of steps.
+    size_t size() const;
+    
+    /// Return true if there are no steps.
+    bool empty() const;
+    
+    /// Get the handle at the given rank, which must be less than size().
+    handle_t get_handle(size_t rank) const;
+    
+    /// Decode up to max_count handles, starting at the given rank, into the
+    /// buffer. Returns the number of handles decoded, which is only less than
+    /// max_count at the end of the path.
+    size_t decode(size_t rank, handle_t* buffer, size_t max_count) const;
+    
+    /// Decode all the handles.
+    std::vector<handle_t> decode() const;
+    
+    /// Get the number of bytes used, including checkpoints.
+    size_t get_memory_usage() const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Editing
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Add a handle to the end.
+    void push_back(const handle_t& handle);
+    
+    /// Drop all handles at or after the given rank.
+    void truncate(size_t new_size);
+    
+    /// Replace the handles at ranks [begin, end) with the given handles.
+    void rewrite(size_t begin, size_t end, const std::vector<handle_t>& replacement);
+    
+    /// Remove all handles.
+    void clear();
+    
+    /// Release any extra reserved memory.
+    void shrink_to_fit();
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Serialization
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Write the path to a stream. Checkpoints are not written.
+    void serialize(std::ostream& out) const;
+    
+    /// Replace the path with one read from a stream. Throws
+    /// std::runtime_error if the data is truncated or malformed.
+    void deserialize(std::istream& in);
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Step handle layout
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Make a step handle for the step at the given rank on the given path.
+    static step_handle_t make_step(const path_handle_t& path, size_t rank);
+    
+    /// Get the path a step handle made by make_step() is on.
+    static path_handle_t get_path(const step_handle_t& step);
+    
+    /// Get the rank of a step handle made by make_step().
+    static size_t get_rank(const step_handle_t& step);
+    
+protected:
+    
+    /// A place to start decoding.
+    struct Checkpoint {
+        /// Rank of the first step of the run starting here
+        size_t rank;
+        /// Byte offset of the run
+        size_t offset;
+        /// Handle value before the run, or 0 at the start
+        uint64_t value;
+    };
+    
+    /// Find the run containing the given rank, which must be less than
+    /// size(). Fills in the start of the run, the number of steps in it, and
+    /// its difference.
+    void find_run(size_t rank, Checkpoint& run, uint64_t& run_length, uint64_t& delta) const;
+    
+    /// Read a run at the given offset, and advance the offset past it.
+    void read_run(size_t& offset, uint64_t& run_length, uint64_t& delta) const;
+    
+    /// Write a run at the end of the encoded data.
+    void write_run(uint64_t run_length, uint64_t delta);
+    
+    /// Encoded runs
+    std::vector<uint8_t> bytes;
+    /// Checkpoints, in rank order, always including one for the first run
+    std::vector<Checkpoint> checkpoints;
+    /// Number of steps
+    size_t step_count = 0;
+    
+    /// Value of the last handle
+    uint64_t last_value = 0;
+    /// Byte offset of the last run
+    size_t last_run_offset = 0;
+    /// Length of the last run, or 0 if it can't be extended
+    uint64_t last_run_length = 0;
+    /// Difference in the last run
+    uint64_t last_delta = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef HANDLEGRAPH_CURSOR_HPP_INCLUDED
+#define HANDLEGRAPH_CURSOR_HPP_INCLUDED
+
+/** \file
+ * Defines a pull iterator over items that a graph hands out in blocks.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * A pull iterator over a sequence of items, such as the handles in a graph,
+ * which are fetched a block at a time. It can be advanced by hand, to zip
+ * several sequences together, merge-join them, or stop early, or used in a
+ * range-based for loop like:
+ *
+ * for (handle_t handle : graph->scan_handles()) { }
+ *
+ * A cursor only makes one pass; begin() continues from wherever it is.
+ * Copying a cursor makes an independent one at the same place. Cursors from
+ * a graph must not outlive the graph, and are invalidated by modifying it.
+ */
+template<typename Item>
+class Cursor {
+public:
+
+    /// Number of items fetched at a time, if not specified.
+    static const size_t DEFAULT_BLOCK_SIZE = 256;
+
+    /// Function that writes up to max_items of the next items into the
+    /// buffer and returns how many it wrote, or 0 when there are no more.
+    using fetcher_t = std::function<size_t(Item* buffer, size_t max_items)>;
+
+    /// Make a cursor over the items produced by the given function.
+    Cursor(const fetcher_t& fetch, size_t block_size = DEFAULT_BLOCK_SIZE);
+
+    /// Make a cursor over the given items.
+    Cursor(std::vector<Item>&& items);
+
+    /// Return true if there are no more items.
+    bool done();
+
+    /// Get the next item, without moving past it. Must not be done().
+    const Item& peek();
+
+    /// Get the next item and move past it. Must not be done().
+    Item next();
+
+    /**
+     * Input iterator over what is left of a cursor
+     */
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Item;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Item*;
+        using reference = const Item&;
+
+        iterator& operator++();
+        const Item& operator*() const;
+        const Item* operator->() const;
+        bool operator==(const iterator& other) const;
+        bool operator!=(const iterator& other) const;
+
+    private:
+        iterator(Cursor* cursor);
+
+        /// Returns true if this is the end iterator or its cursor is done
+        bool at_end() const;
+
+        /// The cursor we advance, or null for the end iterator
+        Cursor* cursor;
+
+        friend class Cursor;
+    };
+
+    /// Get an iterator at the cursor's next item.
+    iterator begin();
+
+    /// Get an iterator past the cursor's last item.
+    iterator end();
+
+private:
+
+    /// Where more items come from, or empty if there are no more
+    fetcher_t fetch;
+    /// Number of items to fetch at a time
+    size_t block_size;
+    /// Items fetched but not yet used up
+    std::vector<Item> buffer;
+    /// Index of the next item in the buffer
+    size_t index = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Template Implementations
+////////////////////////////////////////////////////////////////////////////
+
+template<typename Item>
+Cursor<Item>::Cursor(const fetcher_t& fetch, size_t block_size) : fetch(fetch), block_size(block_size == 0 ? 1 : block_size) {
+    // Nothing to do
+}
+
+template<typename Item>
+Cursor<Item>::Cursor(std::vector<Item>&& items) : block_size(DEFAULT_BLOCK_SIZE), buffer(std::move(items)) {
+    // Nothing to do
+}
+
+template<typename Item>
+bool Cursor<Item>::done() {
+    if (index == buffer.size() && fetch) {
+        buffer.resize(block_size);
+        buffer.resize(fetch(buffer.data(), block_size));
+        index = 0;
+        if (buffer.empty()) {
+            // Don't ask again
+            fetch = nullptr;
+        }
+    }
+    return index == buffer.size();
+}
+
+template<typename Item>
+const Item& Cursor<Item>::peek() {
+    done();
+    return buffer[index];
+}
+
+template<typename Item>
+Item Cursor<Item>::next() {
+    done();
+    return buffer[index++];
+}
+
+template<typename Item>
+typename Cursor<Item>::iterator Cursor<Item>::begin() {
+    return iterator(this);
+}
+
+template<typename Item>
+typename Cursor<Item>::iterator Cursor<Item>::end() {
+    return iterator(nullptr);
+}
+
+template<typename Item>
+Cursor<Item>::iterator::iterator(Cursor* cursor) : cursor(cursor) {
+    // Nothing to do
+}
+
+template<typename Item>
+typename Cursor<Item>::iterator& Cursor<Item>::iterator::operator++() {
+    cursor->next();
+    return *this;
+}
+
+template<typename Item>
+const Item& Cursor<Item>::iterator::operator*() const {
+    return cursor->peek();
+}
+
+template<typename Item>
+const Item* Cursor<Item>::iterator::operator->() const {
+    return &cursor->peek();
+}
+
+template<typename Item>
+bool Cursor<Item>::iterator::at_end() const {
+    return cursor == nullptr || cursor->done();
+}
+
+template<typename Item>
+bool Cursor<Item>::iterator::operator==(const iterator& other) const {
+    if (at_end() || other.at_end()) {
+        return at_end() && other.at_end();
+    }
+    return cursor == other.cursor;
+}
+
+template<typename Item>
+bool Cursor<Item>::iterator::operator!=(const iterator& other) const {
+    return !(*this == other);
+}
+
+}
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef HANDLEGRAPH_DISK_GRAPH_HPP_INCLUDED
+#define HANDLEGRAPH_DISK_GRAPH_HPP_INCLUDED
+
+/** \file
+ * Defines a read-only graph that stays on disk, for graphs too big for memory.
+ */
+
+#include "handlegraph/path_position_handle_graph.hpp"
+#include "handlegraph/buffer_manager.hpp"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * A read-only PathPositionHandleGraph that reads what it needs from a file
+ * through a BufferManager, so only a budgeted amount of it is ever in memory.
+ * Only the path names and a few numbers per path stay resident.
+ *
+ * The file is written by build(), and holds, in this order:
+ *
+ *  - A header of counts and section offsets.
+ *  - A node table with the offset of each ID's node record, or 0 for
+ *    missing IDs.
+ *  - The steps on each node, in node ID order.
+ *  - The handles visited by each path, in path order.
+ *  - The position of each of those steps along its path.
+ *  - The node records, in node ID order, each holding the node's length,
+ *    degrees, step count, and first step, then its edges and sequence.
+ *  - A path directory of names, metadata, lengths, and step ranges.
+ *
+ * Nodes that are close in ID are close on disk, so a scan in ID order, or
+ * over a path's steps, reads the file nearly sequentially, and the buffer
+ * manager reads ahead of it.
+ *
+ * Handles are node IDs and orientations packed with number_bool_packing.
+ * Step handles hold a path's index and the step's rank along it.
+ *
+ * Paths of every sense are stored, with their metadata. As the
+ * PathHandleGraph interface asks, haplotype paths and their steps are only
+ * visible through for_each_path_matching() and for_each_step_of_sense(), and
+ * are left out of get_path_count(). get_step_count() on a handle, and
+ * get_next_steps_on_handle(), count and read the steps of all paths.
+ */
+class DiskGraph : public PathPositionHandleGraph {
+public:
+
+    /// Number at the start of the file
+    static const uint32_t MAGIC_NUMBER;
+
+    /// Version of the file layout
+    static const uint32_t FORMAT_VERSION;
+
+    /// Bytes of node steps to gather at a time while building, if not
+    /// specified.
+    static const size_t DEFAULT_BUILD_MEMORY;
+
+    /// Write the given graph, and its paths if it is a PathHandleGraph, to
+    /// the named file. Node IDs must not be negative. Memory use is
+    /// proportional to the number of paths, plus about build_memory bytes
+    /// for inverting the paths into lists of steps on each node. The steps
+    /// are inverted in one pass over the paths, through a temporary spill
+    /// file next to the output that takes 24 bytes per step.
+    static void build(const HandleGraph* graph, const std::string& filename,
+                      size_t build_memory = DEFAULT_BUILD_MEMORY);
+
+    /// Open a graph written by build(), keeping up to about memory_budget
+    /// bytes of it in memory. Throws if the file can't be read or is not a
+    /// graph of this version.
+    DiskGraph(const std::string& filename,
+              size_t memory_budget = BufferManager::DEFAULT_MEMORY_BUDGET,
+              size_t page_size = BufferManager::DEFAULT_PAGE_SIZE,
+              size_t read_ahead_pages = BufferManager::DEFAULT_READ_AHEAD_PAGES);
+
+    /// Close the file.
+    virtual ~DiskGraph();
+
+    DiskGraph(const DiskGraph& other) = delete;
+    DiskGraph& operator=(const DiskGraph& other) = delete;
+
+    /// Get the buffer manager, to see how the cache is doing.
+    const BufferManager& get_buffer_manager() const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // HandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Method to check if a node exists by ID
+    bool has_node(nid_t node_id) const;
+
+    /// Look up the handle for the node with the given ID in the given orientation
+    handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+
+    /// Get the ID from a handle
+    nid_t get_id(const handle_t& handle) const;
+
+    /// Get the orientation of a handle
+    bool get_is_reverse(const handle_t& handle) const;
+
+    /// Invert the orientation of a handle (potentially without getting its ID)
+    handle_t flip(const handle_t& handle) const;
+
+    /// Get the length of a node
+    size_t get_length(const handle_t& handle) const;
+
+    /// Get the sequence of a node, presented in the handle's local forward
+    /// orientation.
+    std::string get_sequence(const handle_t& handle) const;
+
+    /// Return the number of nodes in the graph
+    size_t get_node_count() const;
+
+    /// Return the smallest ID in the graph, or some smaller number if the
+    /// smallest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t min_node_id() const;
+
+    /// Return the largest ID in the graph, or some larger number if the
+    /// largest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t max_node_id() const;
+
+    /// Get the number of edges on the right (go_left = false) or left (go_left
+    /// = true) side of the given handle.
+    size_t get_degree(const handle_t& handle, bool go_left) const;
+
+    /// Return the total number of edges in the graph.
+    size_t get_edge_count() const;
+
+    /// Return the total length of all nodes in the graph, in bp.
+    size_t get_total_length() const;
+
+    /// Returns one base of a handle's sequence, in the orientation of the
+    /// handle.
+    char get_base(const handle_t& handle, size_t index) const;
+
+    /// Returns a substring of a handle's sequence, in the orientation of the
+    /// handle. Only the needed bases are read.
+    std::string get_subsequence(const handle_t& handle, size_t index, size_t size) const;
+
+    /// Returns true, since cursors are positions in the file.
+    bool has_efficient_cursors() const;
+
+    /// Read the next handles from the node table.
+    size_t get_next_handles(uint64_t& cursor, handle_t* buffer, size_t max_handles) const;
+
+    /// Read the next handles from a node's edges.
+    size_t get_next_neighbors(const handle_t& handle, bool go_left, uint64_t& cursor,
+                              handle_t* buffer, size_t max_handles) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // PathHandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Returns the number of paths stored in the graph
+    size_t get_path_count() const;
+
+    /// Determine if a path name exists and is legal to get a path handle for.
+    bool has_path(const std::string& path_name) const;
+
+    /// Look up the path handle for the given path name.
+    path_handle_t get_path_handle(const std::string& path_name) const;
+
+    /// Look up the name of a path from a handle to it
+    std::string get_path_name(const path_handle_t& path_handle) const;
+
+    /// Look up whether a path is circular
+    bool get_is_circular(const path_handle_t& path_handle) const;
+
+    /// Returns the number of node steps in the path
+    size_t get_step_count(const path_handle_t& path_handle) const;
+
+    /// Returns the number of node steps on a handle, on paths of any sense
+    size_t get_step_count(const handle_t& handle) const;
+
+    /// Get a node handle (node ID and orientation) from a handle to a step on a path
+    handle_t get_handle_of_step(const step_handle_t& step_handle) const;
+
+    /// Returns a handle to the path that an step is on
+    path_handle_t get_path_handle_of_step(const step_handle_t& step_handle) const;
+
+    /// Get a handle to the first step, which will be an arbitrary step in a circular path
+    /// that we consider "first" based on our construction of the path. If the path is empty,
+    /// then the implementation must return the same value as path_end().
+    step_handle_t path_begin(const path_handle_t& path_handle) const;
+
+    /// Get a handle to a fictitious position past the end of a path. This position is
+    /// returned by get_next_step for the final step in a path in a non-circular path.
+    /// Note: get_next_step will *NEVER* return this value for a circular path.
+    step_handle_t path_end(const path_handle_t& path_handle) const;
+
+    /// Get a handle to the last step, which will be an arbitrary step in a circular path that
+    /// we consider "last" based on our construction of the path. If the path is empty
+    /// then the implementation must return the same value as path_front_end().
+    step_handle_t path_back(const path_handle_t& path_handle) const;
+
+    /// Get a handle to a fictitious position before the beginning of a path. This position is
+    /// return by get_previous_step for the first step in a path in a non-circular path.
+    /// Note: get_previous_step will *NEVER* return this value for a circular path.
+    step_handle_t path_front_end(const path_handle_t& path_handle) const;
+
+    /// Returns true if the step is not the last step in a non-circular path.
+    bool has_next_step(const step_handle_t& step_handle) const;
+
+    /// Returns true if the step is not the first step in a non-circular path.
+    bool has_previous_step(const step_handle_t& step_handle) const;
+
+    /// Returns a handle to the next step on the path. If the given step is the final step
+    /// of a non-circular path, returns the past-the-last step that is also returned by
+    /// path_end. In a circular path, the "last" step will loop around to the "first" (i.e.
+    /// the one returned by path_begin).
+    step_handle_t get_next_step(const step_handle_t& step_handle) const;
+
+    /// Returns a handle to the previous step on the path. If the given step is the first
+    /// step of a non-circular path, this method has undefined behavior. In a circular path,
+    /// it will loop around from the "first" step (i.e. the one returned by path_begin) to
+    /// the "last" step.
+    step_handle_t get_previous_step(const step_handle_t& step_handle) const;
+
+    /// Read the handles of up to max_steps consecutive steps straight from
+    /// the path's stored handles.
+    size_t get_step_handles(const path_handle_t& path, step_handle_t& step,
+                            handle_t* buffer, size_t max_steps) const;
+
+    /// Read the next steps from a node's steps.
+    size_t get_next_steps_on_handle(const handle_t& handle, uint64_t& cursor,
+                                    step_handle_t* buffer, size_t max_steps) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // PathMetadata interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// What is the given path meant to be representing?
+    PathSense get_sense(const path_handle_t& handle) const;
+
+    /// Get the name of the sample or assembly associated with the
+    /// path-or-thread, or NO_SAMPLE_NAME if it does not belong to one.
+    std::string get_sample_name(const path_handle_t& handle) const;
+
+    /// Get the name of the contig or gene associated with the path-or-thread,
+    /// or NO_LOCUS_NAME if it does not belong to one.
+    std::string get_locus_name(const path_handle_t& handle) const;
+
+    /// Get the haplotype number (0 or 1, for diploid) of the path-or-thread,
+    /// or NO_HAPLOTYPE if it does not belong to one.
+    size_t get_haplotype(const path_handle_t& handle) const;
+
+    /// Get the phase block number (contiguously phased region of a sample,
+    /// contig, and haplotype) of the path-or-thread, or NO_PHASE_BLOCK if it
+    /// does not belong to one.
+    size_t get_phase_block(const path_handle_t& handle) const;
+
+    /// Get the bounds of the path-or-thread that are actually represented
+    /// here. Should be NO_SUBRANGE if the entirety is represented here, and
+    /// 0-based inclusive start and exclusive end positions of the stored
+    /// region on the full path-or-thread if a subregion is stored.
+    subrange_t get_subrange(const path_handle_t& handle) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // PathPositionHandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Returns the length of a path measured in bases of sequence.
+    size_t get_path_length(const path_handle_t& path_handle) const;
+
+    /// Returns the position along the path of the beginning of this step measured in
+    /// bases of sequence. In a circular path, positions start at the step returned by
+    /// path_begin().
+    size_t get_position_of_step(const step_handle_t& step) const;
+
+    /// Returns the step at this position, measured in bases of sequence starting at
+    /// the step returned by path_begin(). If the position is past the end of the
+    /// path, returns path_end().
+    step_handle_t get_step_at_position(const path_handle_t& path, const size_t& position) const;
+
+protected:
+
+    /// Loop over all the nodes in the graph in their local forward
+    /// orientations, in ID order. In parallel, blocks of the node table are
+    /// handed out to threads.
+    bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+
+    /// Loop over all the handles to next/previous (right/left) nodes.
+    bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+
+    /// Execute a function on each path in the graph, except haplotypes.
+    bool for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const;
+
+    /// Execute a function on each path with a sense, sample, and locus in the
+    /// given sets, or of any sense, sample, or locus where a set is null.
+    bool for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                     const std::unordered_set<std::string>* samples,
+                                     const std::unordered_set<std::string>* loci,
+                                     const std::function<bool(const path_handle_t&)>& iteratee) const;
+
+    /// Execute a function on each step of a handle in any path, except
+    /// haplotypes.
+    bool for_each_step_on_handle_impl(const handle_t& handle,
+                                      const std::function<bool(const step_handle_t&)>& iteratee) const;
+
+    /// Execute a function on each step of a handle on a path of the given
+    /// sense.
+    bool for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                     const std::function<bool(const step_handle_t&)>& iteratee) const;
+
+    /// Execute a function on each stored step of a handle, on paths of any
+    /// sense.
+    bool for_each_stored_step(const handle_t& handle,
+                              const std::function<bool(const step_handle_t&)>& iteratee) const;
+
+    /// What we keep in memory about a path
+    struct PathRecord {
+        std::string name;
+        PathSense sense;
+        std::string sample;
+        std::string locus;
+        size_t haplotype;
+        size_t phase_block;
+        subrange_t subrange;
+        bool is_circular;
+        size_t step_count;
+        size_t length;
+        /// Index of the path's first step among all paths' steps
+        size_t first_step;
+    };
+
+    /// The fixed part of a node record
+    struct NodeRecord {
+        uint64_t length;
+        uint64_t left_degree;
+        uint64_t right_degree;
+        uint64_t step_count;
+        /// Index of the node's first step among all nodes' steps
+        uint64_t first_step;
+    };
+
+    /// Counts and section offsets at the start of the file
+    struct Header {
+        uint32_t magic_number;
+        uint32_t format_version;
+        uint64_t node_count;
+        uint64_t edge_count;
+        uint64_t total_length;
+        int64_t min_id;
+        int64_t max_id;
+        uint64_t path_count;
+        uint64_t step_count;
+        uint64_t node_table_offset;
+        uint64_t node_steps_offset;
+        uint64_t path_handles_offset;
+        uint64_t path_positions_offset;
+        uint64_t node_records_offset;
+        uint64_t path_directory_offset;
+        uint64_t file_size;
+    };
+
+    /// Get the number of entries in the node table.
+    size_t get_table_size() const;
+
+    /// Get the offset of a node's record in the file, or 0 if it is missing.
+    uint64_t get_record_offset(nid_t node_id) const;
+
+    /// Read the fixed part of a node's record, which must exist.
+    NodeRecord get_record(nid_t node_id, uint64_t& offset) const;
+
+    /// Read a 64-bit number from the file.
+    uint64_t read_number(uint64_t offset) const;
+
+    /// Make a step handle.
+    static step_handle_t make_step(size_t path_index, int64_t rank);
+
+    /// File we read from
+    int fd = -1;
+    /// Page cache over the file
+    std::unique_ptr<BufferManager> buffers;
+    Header header;
+    std::vector<PathRecord> paths;
+    std::unordered_map<std::string, size_t> path_indexes;
+    /// Number of paths that aren't haplotypes
+    size_t visible_path_count = 0;
+};
+
+}
+
+#endif
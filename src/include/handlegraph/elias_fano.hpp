@@ -0,0 +1,85 @@
+#ifndef HANDLEGRAPH_ELIAS_FANO_HPP_INCLUDED
+#define HANDLEGRAPH_ELIAS_FANO_HPP_INCLUDED
+
+/** \file
+ * Defines a compressed storage component for sorted sequences of numbers,
+ * such as sparse node IDs, for use by graph implementations and overlays.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * A sorted sequence of numbers in Elias-Fano encoding. Each number is split
+ * into low bits, stored packed, and high bits, stored in unary in a bit
+ * vector, so n numbers less than u take about n * (2 + log2(u / n)) bits.
+ *
+ * A position is sampled about every SAMPLE_INTERVAL ones and zeros of the
+ * bit vector, so looking up the number at an index, or finding the first
+ * number at least some value, takes a bounded scan plus a binary search
+ * over numbers that share their high bits.
+ *
+ * The sequence is immutable once built, and safe to read from many threads.
+ */
+class EliasFanoSequence {
+public:
+
+    /// Make an empty sequence.
+    EliasFanoSequence() = default;
+
+    /// Make a sequence of the given numbers, which must be in non-decreasing
+    /// order.
+    EliasFanoSequence(const std::vector<uint64_t>& values);
+
+    /// Approximate number of ones, or zeros, in the high bits between
+    /// sampled positions.
+    static const size_t SAMPLE_INTERVAL;
+
+    /// Get the number of numbers.
+    size_t size() const;
+
+    /// Return true if there are no numbers.
+    bool empty() const;
+
+    /// Get the number at the given index, which must be less than size().
+    uint64_t get(size_t index) const;
+
+    /// Get the index of the first number that is at least the given value,
+    /// or size() if there is none.
+    size_t lower_bound(uint64_t value) const;
+
+    /// Get the number of bytes used, including samples.
+    size_t get_memory_usage() const;
+
+protected:
+
+    /// Get the position in the high bits of the one or zero with the given
+    /// index.
+    size_t select(bool ones, size_t index) const;
+
+    /// Get the low bits of the number at the given index.
+    uint64_t get_low(size_t index) const;
+
+    /// Number of numbers
+    size_t count = 0;
+    /// Number of low bits of each number that are stored packed
+    size_t low_width = 0;
+    /// Largest number
+    uint64_t last_value = 0;
+    /// Packed low bits, with a spare word at the end
+    std::vector<uint64_t> low_bits;
+    /// High bits, as a one for each number after as many zeros as its high
+    /// part
+    std::vector<uint64_t> high_bits;
+    /// Position in high_bits of every SAMPLE_INTERVAL-th one
+    std::vector<size_t> one_samples;
+    /// Position in high_bits of every SAMPLE_INTERVAL-th zero
+    std::vector<size_t> zero_samples;
+};
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef HANDLEGRAPH_EXECUTION_HPP_INCLUDED
+#define HANDLEGRAPH_EXECUTION_HPP_INCLUDED
+
+/** \file
+ * Defines how the library's algorithms run work in parallel, and a built-in
+ * thread pool to run it on.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * Interface for something that can run the iterations of a loop in parallel.
+ * Implement it to have the library's algorithms run on an existing OpenMP,
+ * TBB, or other thread pool.
+ */
+class Executor {
+public:
+
+    virtual ~Executor() = default;
+
+    /// Call body on every index in [0, count), using up to thread_count
+    /// threads, or as many as the executor has if 0, and return when all the
+    /// calls are done. Calls may happen in any order, and the body may itself
+    /// call parallel_for(). If any call throws, the remaining indexes may be
+    /// skipped, and one of the exceptions must be rethrown.
+    virtual void parallel_for(size_t count, size_t thread_count, const std::function<void(size_t)>& body) = 0;
+
+    /// Get the number of threads used when 0 is requested.
+    virtual size_t get_thread_count() const = 0;
+};
+
+/**
+ * A lightweight Executor with its own pool of threads. Each loop is split
+ * evenly between the threads working on it, and a thread that runs out of
+ * indexes steals half of what another has left, so uneven iterations still
+ * balance out. The calling thread always works on its own loop, so nested
+ * loops can't deadlock even when every pool thread is busy.
+ */
+class WorkStealingExecutor : public Executor {
+public:
+
+    /// Make a pool that runs loops on up to thread_count threads, counting
+    /// the calling thread, or one per core if 0.
+    WorkStealingExecutor(size_t thread_count = 0);
+
+    /// Stop the pool's threads. Must not be running any loops.
+    virtual ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor& other) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor& other) = delete;
+
+    /// Call body on every index in [0, count), on up to thread_count threads.
+    void parallel_for(size_t count, size_t thread_count, const std::function<void(size_t)>& body);
+
+    /// Get the number of threads loops run on when 0 is requested.
+    size_t get_thread_count() const;
+
+    /// Get the pool shared by everything that doesn't ask for a particular
+    /// executor, which has a thread per core and is started on first use.
+    static WorkStealingExecutor& get_default();
+
+protected:
+
+    /// A loop being run, and the indexes each thread on it has left to do
+    struct Job;
+
+    /// Work on a loop with the given slot, until there is nothing left to
+    /// take.
+    void participate(Job& job, size_t slot);
+
+    /// Body of the pool's threads.
+    void worker_loop();
+
+    /// Number of threads, counting the caller
+    size_t thread_count;
+    /// The pool's threads
+    std::vector<std::thread> workers;
+
+    /// Protects everything below
+    std::mutex mutex;
+    /// Notified when a loop is started or we are stopping
+    std::condition_variable job_started;
+    /// Notified when a pool thread stops working on a loop
+    std::condition_variable worker_left;
+    /// Loops that threads can join
+    std::vector<Job*> jobs;
+    /// True when the pool's threads should finish
+    bool stopping = false;
+};
+
+/**
+ * How an algorithm should run its parallel parts. Converts from a thread
+ * count, so passing a number of threads still works where these are taken.
+ */
+struct ExecutionOptions {
+
+    /// Maximum number of threads to use, or 0 for as many as the executor
+    /// has. With 1, everything runs on the calling thread.
+    size_t thread_count = 0;
+
+    /// Executor to run parallel loops on, or null for the shared
+    /// WorkStealingExecutor.
+    Executor* executor = nullptr;
+
+    /// Run with up to the given number of threads, or as many as the
+    /// executor has if 0, on the given executor, or the shared one if null.
+    ExecutionOptions(size_t thread_count = 0, Executor* executor = nullptr);
+
+    /// Get the executor to run on.
+    Executor& get_executor() const;
+
+    /// Get the most threads that a loop will run on.
+    size_t get_thread_count() const;
+
+    /// Call body on every index in [0, count), as these options say. If any
+    /// call throws, the remaining indexes may be skipped, and one of the
+    /// exceptions is rethrown.
+    void parallel_for(size_t count, const std::function<void(size_t)>& body) const;
+};
+
+}
+
+#endif
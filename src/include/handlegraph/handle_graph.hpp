@@ -7,6 +7,7 @@
  
 #include "handlegraph/types.hpp"
 #include "handlegraph/iteratee.hpp"
+#include "handlegraph/cursor.hpp"
 
 #include <functional>
 #include <string>
@@ -128,6 +129,39 @@ public:
     /// By default O(n) in the size of the handle's sequence, but can be overriden.
     virtual std::string get_subsequence(const handle_t& handle, size_t index, size_t size) const;
     
+    /// Writes a handle's sequence, in the orientation of the handle, into the
+    /// given buffer, which must have room for get_length() characters. Returns
+    /// the number of characters written. Implementations that store sequence
+    /// contiguously can override this to avoid building a string for each
+    /// node. By default allocates a string with get_sequence().
+    virtual size_t copy_sequence(const handle_t& handle, char* dest) const;
+    
+    /// Returns true if get_next_handles() and get_next_neighbors() (and
+    /// get_next_steps_on_handle() in a PathHandleGraph) can pick up where
+    /// they left off cheaply, so pull iterators can fetch a block at a time.
+    /// Otherwise pull iterators collect everything up front with the
+    /// iteratee methods. Returns false unless overridden.
+    virtual bool has_efficient_cursors() const;
+    
+    /// Write up to max_handles handles into the buffer, continuing the order
+    /// of for_each_handle() from the given cursor, and advance the cursor
+    /// past them. A cursor starts at 0, and is otherwise only meaningful to
+    /// the implementation. Returns the number of handles written, which is 0
+    /// at the end. The default implementation counts its way through
+    /// for_each_handle() every time, so implementations that override
+    /// has_efficient_cursors() must override this too.
+    virtual size_t get_next_handles(uint64_t& cursor, handle_t* buffer, size_t max_handles) const;
+    
+    /// Write up to max_handles of the handles reached by edges on the right
+    /// (go_left = false) or left (go_left = true) side of the given handle
+    /// into the buffer, continuing the order of follow_edges() from the given
+    /// cursor, and advance the cursor past them. A cursor starts at 0.
+    /// Returns the number of handles written, which is 0 at the end. The
+    /// default implementation counts its way through follow_edges() every
+    /// time.
+    virtual size_t get_next_neighbors(const handle_t& handle, bool go_left, uint64_t& cursor,
+                                      handle_t* buffer, size_t max_handles) const;
+    
     ////////////////////////////////////////////////////////////////////////////
     // Concrete utility methods
     ////////////////////////////////////////////////////////////////////////////
@@ -151,6 +185,19 @@ public:
     template<typename Iteratee>
     bool for_each_edge(const Iteratee& iteratee, bool parallel = false) const;
     
+    /// Get a pull iterator over the nodes in their local forward orientations,
+    /// in the same order as for_each_handle().
+    Cursor<handle_t> scan_handles() const;
+    
+    /// Get a pull iterator over the handles reached by edges on the right
+    /// (go_left = false) or left (go_left = true) side of the given handle, in
+    /// the same order as follow_edges().
+    Cursor<handle_t> scan_neighbors(const handle_t& handle, bool go_left) const;
+    
+    /// Get a pull iterator over the edges in their canonical orientation, in
+    /// the same order as for_each_edge().
+    Cursor<edge_t> scan_edges() const;
+    
     ////////////////////////////////////////////////////////////////////////////
     // Backing protected virtual methods that need to be implemented
     ////////////////////////////////////////////////////////////////////////////
@@ -197,6 +244,24 @@ public:
 
     /// Return the handle with a given rank.
     virtual handle_t rank_to_handle(const size_t& rank) const;
+    
+    /// Loop over the nodes with node ranks in [begin_rank, end_rank), in
+    /// their local forward orientations, in rank order. Ranks must be between
+    /// 1 and get_node_count() + 1. If the iteratee returns bool, and it
+    /// returns false, stop iteration. Return true if the iteration completed
+    /// and false if it stopped early.
+    template<typename Iteratee>
+    bool for_each_handle_in_range(size_t begin_rank, size_t end_rank, const Iteratee& iteratee) const;
+    
+protected:
+    
+    /// Loop over the nodes with node ranks in [begin_rank, end_rank) in rank
+    /// order. Passes them to a callback which returns false to stop iterating
+    /// and true to continue. Returns true if we finished and false if we
+    /// stopped early. The default implementation looks up each rank with
+    /// rank_to_id().
+    virtual bool for_each_handle_in_range_impl(size_t begin_rank, size_t end_rank,
+                                               const std::function<bool(const handle_t&)>& iteratee) const;
 
 };
 
@@ -235,6 +300,11 @@ bool HandleGraph::for_each_handle(const Iteratee& iteratee, bool parallel) const
     return for_each_handle_impl(BoolReturningWrapper<Iteratee>::wrap(iteratee), parallel);
 }
 
+template<typename Iteratee>
+bool RankedHandleGraph::for_each_handle_in_range(size_t begin_rank, size_t end_rank, const Iteratee& iteratee) const {
+    return for_each_handle_in_range_impl(begin_rank, end_rank, BoolReturningWrapper<Iteratee>::wrap(iteratee));
+}
+
 template<typename Iteratee>
 bool HandleGraph::for_each_edge(const Iteratee& iteratee, bool parallel) const {
     auto wrapped_iteratee = BoolReturningWrapper<Iteratee>::wrap(iteratee);
@@ -10,6 +10,17 @@
 
 namespace handlegraph {
 
+/**
+ * One rewrite for MutablePathHandleGraph::rewrite_segments(): the steps from
+ * segment_begin up to but not including segment_end are replaced by visits to
+ * new_segment.
+ */
+struct PathSegmentRewrite {
+    step_handle_t segment_begin;
+    step_handle_t segment_end;
+    std::vector<handle_t> new_segment;
+};
+
 /**
  * This is the interface for a handle graph with embedded paths where the paths can be modified.
  * Note that if the *graph* can also be modified, the implementation will also
@@ -29,6 +40,8 @@ public:
     
     /**
      * Destroy the given set of paths. Invalidates handles to all the paths and their steps.
+     * By default, destroys them one at a time, inside a path edit batch if
+     * wants_path_edit_batch() is true.
      */
     virtual void destroy_paths(const std::vector<path_handle_t>& paths);
 
@@ -91,6 +104,16 @@ public:
                                                                     const step_handle_t& segment_end,
                                                                     const std::vector<handle_t>& new_segment) = 0;
     
+    /**
+     * Rewrite many segments of paths at once, as if by rewrite_segment().
+     * Segments must not overlap, and each rewrite's step handles must still
+     * be valid after the rewrites before it are done, which is always true
+     * for rewrites on different paths. Returns the range of each new
+     * segment, as of when it was written. By default, does the rewrites one
+     * at a time, inside a path edit batch if wants_path_edit_batch() is true.
+     */
+    virtual std::vector<std::pair<step_handle_t, step_handle_t>> rewrite_segments(const std::vector<PathSegmentRewrite>& rewrites);
+    
     /**
      * Make a path circular or non-circular. If the path is becoming circular, the
      * last step is joined to the first step. If the path is becoming linear, the
@@ -98,6 +121,35 @@ public:
      * to the method path_begin.
      */
     virtual void set_circularity(const path_handle_t& path, bool circular) = 0;
+    
+protected:
+    
+    /**
+     * Return true if begin_path_edit_batch() and end_path_edit_batch() do
+     * anything. Finding the nodes affected by a batch takes a pass over all
+     * the steps involved, so the default batch operations only do it, and
+     * only call those methods, for implementations that return true. By
+     * default, returns false.
+     */
+    virtual bool wants_path_edit_batch() const;
+    
+    /**
+     * Called before a batch of path edits, such as from destroy_paths() or
+     * rewrite_segments() when wants_path_edit_batch() is true, with the
+     * sorted, distinct IDs of all nodes whose steps may change.
+     * Implementations that keep an index of the steps on each node can stop
+     * maintaining it for those nodes until the batch ends. By default, does
+     * nothing, since only the implementation can see its index.
+     */
+    virtual void begin_path_edit_batch(const std::vector<nid_t>& affected_nodes);
+    
+    /**
+     * Called after a batch of path edits, with the same nodes passed to
+     * begin_path_edit_batch(). Implementations that stopped maintaining their
+     * index of the steps on each node can rebuild it for these nodes, once.
+     * By default, does nothing and rebuilds nothing.
+     */
+    virtual void end_path_edit_batch(const std::vector<nid_t>& affected_nodes);
 };
 
 
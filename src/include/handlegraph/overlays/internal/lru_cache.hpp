@@ -0,0 +1,153 @@
+#ifndef HANDLEGRAPH_OVERLAYS_INTERNAL_LRU_CACHE_HPP_INCLUDED
+#define HANDLEGRAPH_OVERLAYS_INTERNAL_LRU_CACHE_HPP_INCLUDED
+
+/** \file
+ * Defines a thread-safe least-recently-used cache with a byte budget, for
+ * overlays that cache what they read from their underlying graphs.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace handlegraph {
+namespace internal {
+
+/**
+ * A cache from keys to values that evicts the least recently used entries to
+ * stay within a budget of bytes. Entries are divided among shards by hash,
+ * each with its own lock and its own share of the budget, so threads working
+ * on different entries mostly don't wait on each other.
+ */
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLRUCache {
+public:
+
+    /// Make a cache that uses up to about byte_budget bytes, split over the
+    /// given number of shards.
+    ShardedLRUCache(size_t byte_budget, size_t shard_count) :
+        shards(std::max<size_t>(shard_count, 1)), hits(0), misses(0) {
+        for (auto& shard : shards) {
+            shard.budget = byte_budget / shards.size();
+        }
+    }
+
+    /// Copy the value for the given key into value and return true if it is
+    /// cached, and return false otherwise.
+    bool get(const Key& key, Value& value) const {
+        Shard& shard = get_shard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            misses++;
+            return false;
+        }
+        // Make it the most recently used
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        value = found->second->value;
+        hits++;
+        return true;
+    }
+
+    /// Cache the given value, which takes up the given number of bytes, for
+    /// the given key, evicting other entries as needed. Values too big for a
+    /// shard's budget are not cached.
+    void put(const Key& key, const Value& value, size_t bytes) const {
+        Shard& shard = get_shard(key);
+        if (bytes > shard.budget) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+            // Someone else got it first
+            shard.used -= found->second->bytes;
+            shard.entries.erase(found->second);
+            shard.index.erase(found);
+        }
+        shard.entries.push_front(Entry{key, value, bytes});
+        shard.index[key] = shard.entries.begin();
+        shard.used += bytes;
+        while (shard.used > shard.budget) {
+            Entry& oldest = shard.entries.back();
+            shard.used -= oldest.bytes;
+            shard.index.erase(oldest.key);
+            shard.entries.pop_back();
+        }
+    }
+
+    /// Drop everything.
+    void clear() const {
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.entries.clear();
+            shard.index.clear();
+            shard.used = 0;
+        }
+    }
+
+    /// Get the number of bytes currently cached.
+    size_t get_bytes_used() const {
+        size_t used = 0;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            used += shard.used;
+        }
+        return used;
+    }
+
+    /// Get the number of successful lookups.
+    size_t get_hits() const {
+        return hits.load();
+    }
+
+    /// Get the number of failed lookups.
+    size_t get_misses() const {
+        return misses.load();
+    }
+
+    /// Set the lookup counts back to 0.
+    void reset_statistics() const {
+        hits.store(0);
+        misses.store(0);
+    }
+
+protected:
+
+    /// A cached value
+    struct Entry {
+        Key key;
+        Value value;
+        size_t bytes;
+    };
+
+    /// A part of the cache with its own lock
+    struct Shard {
+        std::mutex mutex;
+        /// Entries, most recently used first
+        std::list<Entry> entries;
+        std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+        size_t used = 0;
+        size_t budget = 0;
+    };
+
+    /// Get the shard a key belongs in
+    inline Shard& get_shard(const Key& key) const {
+        // Mix the hash, since some hashes are just the key
+        size_t hash = Hash()(key) * 0x9e3779b97f4a7c15ULL;
+        return shards[(hash >> 32) % shards.size()];
+    }
+
+    mutable std::vector<Shard> shards;
+    mutable std::atomic<size_t> hits;
+    mutable std::atomic<size_t> misses;
+};
+
+}
+}
+
+#endif
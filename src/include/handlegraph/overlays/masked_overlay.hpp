@@ -0,0 +1,188 @@
+#ifndef HANDLEGRAPH_OVERLAYS_MASKED_OVERLAY_HPP_INCLUDED
+#define HANDLEGRAPH_OVERLAYS_MASKED_OVERLAY_HPP_INCLUDED
+
+/** \file
+ * Defines an overlay that hides some edges and nodes of a graph, without
+ * copying it.
+ */
+
+#include "handlegraph/expanding_overlay_graph.hpp"
+
+#include <unordered_set>
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * A view of a graph with some edges and nodes masked out, as if they had been
+ * destroyed. Masking a node also masks its edges. Overlay handles are
+ * underlying handles.
+ *
+ * Masked nodes are kept as a bit per node ID. If the underlying graph is a
+ * VectorizableHandleGraph, masked edges are kept as a bit per edge_index(),
+ * and otherwise in a hash set.
+ *
+ * Masks must not be changed while the overlay is being read from other
+ * threads.
+ */
+class MaskedOverlay : public ExpandingOverlayGraph {
+public:
+    
+    /// Make an overlay of the given graph, which must outlive it, with
+    /// nothing masked. The graph must not gain nodes while the overlay exists.
+    MaskedOverlay(const HandleGraph* graph);
+    
+    virtual ~MaskedOverlay() = default;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // Masking interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Hide the edge between the given handles. Has no effect if it is
+    /// already hidden. Throws std::runtime_error if the edge is not in the
+    /// underlying graph.
+    void mask_edge(const handle_t& left, const handle_t& right);
+    
+    /// Hide the given edge. Has no effect if it is already hidden. Throws
+    /// std::runtime_error if the edge is not in the underlying graph.
+    void mask_edge(const edge_t& edge);
+    
+    /// Show the given edge again, unless one of its nodes is masked. Has no
+    /// effect if it was not masked, including if it is not in the underlying
+    /// graph.
+    void unmask_edge(const edge_t& edge);
+    
+    /// Hide the node with the given ID, and its edges. Throws
+    /// std::runtime_error if the node is not in the underlying graph.
+    void mask_node(nid_t node_id);
+    
+    /// Show the node with the given ID again. Has no effect if it was not
+    /// masked.
+    void unmask_node(nid_t node_id);
+    
+    /// Return true if the given edge is masked by itself. Edges hidden only
+    /// because their nodes are masked do not count.
+    bool is_masked(const edge_t& edge) const;
+    
+    /// Return true if the node with the given ID is masked.
+    bool is_masked(nid_t node_id) const;
+    
+    /// Show everything again.
+    void clear_masks();
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // HandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Method to check if a node exists by ID
+    bool has_node(nid_t node_id) const;
+    
+    /// Look up the handle for the node with the given ID in the given orientation
+    handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+    
+    /// Get the ID from a handle
+    nid_t get_id(const handle_t& handle) const;
+    
+    /// Get the orientation of a handle
+    bool get_is_reverse(const handle_t& handle) const;
+    
+    /// Invert the orientation of a handle (potentially without getting its ID)
+    handle_t flip(const handle_t& handle) const;
+    
+    /// Get the length of a node
+    size_t get_length(const handle_t& handle) const;
+    
+    /// Get the sequence of a node, presented in the handle's local forward
+    /// orientation.
+    std::string get_sequence(const handle_t& handle) const;
+    
+    /// Return the number of nodes in the graph
+    size_t get_node_count() const;
+    
+    /// Return the smallest ID in the graph, or some smaller number if the
+    /// smallest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t min_node_id() const;
+    
+    /// Return the largest ID in the graph, or some larger number if the
+    /// largest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t max_node_id() const;
+    
+    /// Returns true if there is an edge that allows traversal from the left
+    /// handle to the right handle.
+    bool has_edge(const handle_t& left, const handle_t& right) const;
+    
+    /// Return the total number of edges in the graph. Takes time proportional
+    /// to the number of edges on masked nodes.
+    size_t get_edge_count() const;
+    
+    /// Return the total length of all nodes in the graph, in bp.
+    size_t get_total_length() const;
+    
+    /// Returns one base of a handle's sequence, in the orientation of the
+    /// handle.
+    char get_base(const handle_t& handle, size_t index) const;
+    
+    /// Returns a substring of a handle's sequence, in the orientation of the
+    /// handle.
+    std::string get_subsequence(const handle_t& handle, size_t index, size_t size) const;
+    
+    /// Writes a handle's sequence, in the orientation of the handle, into the
+    /// given buffer.
+    size_t copy_sequence(const handle_t& handle, char* dest) const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // ExpandingOverlayGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Returns the handle in the underlying graph that corresponds to a handle
+    /// in the overlay
+    handle_t get_underlying_handle(const handle_t& handle) const;
+    
+protected:
+    
+    /// Loop over all the handles to next/previous (right/left) nodes. Passes
+    /// them to a callback which returns false to stop iterating and true to
+    /// continue. Returns true if we finished and false if we stopped early.
+    bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+    
+    /// Loop over all the nodes in the graph in their local forward
+    /// orientations, in their internal stored order. Stop if the iteratee
+    /// returns false. Can be told to run in parallel, in which case stopping
+    /// after a false return value is on a best-effort basis and iteration
+    /// order is not defined.
+    bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+    
+    /// Determine if an edge is masked, without canonicalizing it first
+    bool is_masked_canonical(const edge_t& edge) const;
+    
+    /// The graph we are a view of
+    const HandleGraph* graph;
+    
+    /// The graph we are a view of, if it can give edges indexes
+    const VectorizableHandleGraph* vectorizable;
+    
+    /// The smallest node ID in the graph
+    nid_t min_id;
+    
+    /// Whether each node, by ID offset from min_id, is masked
+    std::vector<bool> masked_nodes;
+    
+    /// Whether each edge, by edge_index(), is masked, if we have indexes
+    std::vector<bool> masked_edge_indexes;
+    
+    /// The masked edges, in canonical orientation, if we don't have indexes
+    std::unordered_set<edge_t> masked_edges;
+    
+    /// The number of masked nodes
+    size_t masked_node_count;
+    
+    /// The number of edges masked by themselves
+    size_t masked_edge_count;
+    
+    /// The total length of masked nodes
+    size_t masked_length;
+};
+
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef HANDLEGRAPH_OVERLAYS_ORIENTATION_OVERLAY_HPP_INCLUDED
+#define HANDLEGRAPH_OVERLAYS_ORIENTATION_OVERLAY_HPP_INCLUDED
+
+/** \file
+ * Defines an overlay that presents a graph with some of its nodes flipped,
+ * without copying it.
+ */
+
+#include "handlegraph/expanding_overlay_graph.hpp"
+
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * A view of a graph where some nodes have their forward strand swapped with
+ * their reverse strand, as algorithms::apply_orientations() would do. Meant
+ * for presenting the output of algorithms::single_stranded_orientation() or
+ * algorithms::single_stranded_flips() as a single-stranded graph. Node IDs
+ * are the same as in the underlying graph. Overlay handles are underlying
+ * handles, with the meaning of their orientation flipped for flipped nodes,
+ * so the only thing stored is a bit per node ID.
+ */
+class OrientationOverlay : public ExpandingOverlayGraph {
+public:
+    
+    /// Make an overlay of the given graph, which must outlive it, in which
+    /// each node is oriented as in the given handles, as returned by
+    /// algorithms::single_stranded_orientation(). Nodes that are not
+    /// mentioned are left as they are.
+    OrientationOverlay(const HandleGraph* graph, const std::vector<handle_t>& orientations);
+    
+    /// Make an overlay of the given graph, which must outlive it, in which
+    /// the nodes to flip are flagged by ID, starting from the graph's
+    /// min_node_id(), as returned by algorithms::single_stranded_flips().
+    /// IDs past the end of the vector are left as they are.
+    OrientationOverlay(const HandleGraph* graph, std::vector<bool> flips);
+    
+    virtual ~OrientationOverlay() = default;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // HandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Method to check if a node exists by ID
+    bool has_node(nid_t node_id) const;
+    
+    /// Look up the handle for the node with the given ID in the given orientation
+    handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+    
+    /// Get the ID from a handle
+    nid_t get_id(const handle_t& handle) const;
+    
+    /// Get the orientation of a handle
+    bool get_is_reverse(const handle_t& handle) const;
+    
+    /// Invert the orientation of a handle (potentially without getting its ID)
+    handle_t flip(const handle_t& handle) const;
+    
+    /// Get the length of a node
+    size_t get_length(const handle_t& handle) const;
+    
+    /// Get the sequence of a node, presented in the handle's local forward
+    /// orientation.
+    std::string get_sequence(const handle_t& handle) const;
+    
+    /// Return the number of nodes in the graph
+    size_t get_node_count() const;
+    
+    /// Return the smallest ID in the graph, or some smaller number if the
+    /// smallest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t min_node_id() const;
+    
+    /// Return the largest ID in the graph, or some larger number if the
+    /// largest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t max_node_id() const;
+    
+    /// Get the number of edges on the right (go_left = false) or left (go_left
+    /// = true) side of the given handle.
+    size_t get_degree(const handle_t& handle, bool go_left) const;
+    
+    /// Returns true if there is an edge that allows traversal from the left
+    /// handle to the right handle.
+    bool has_edge(const handle_t& left, const handle_t& right) const;
+    
+    /// Return the total number of edges in the graph.
+    size_t get_edge_count() const;
+    
+    /// Return the total length of all nodes in the graph, in bp.
+    size_t get_total_length() const;
+    
+    /// Returns one base of a handle's sequence, in the orientation of the
+    /// handle.
+    char get_base(const handle_t& handle, size_t index) const;
+    
+    /// Returns a substring of a handle's sequence, in the orientation of the
+    /// handle.
+    std::string get_subsequence(const handle_t& handle, size_t index, size_t size) const;
+    
+    /// Writes a handle's sequence, in the orientation of the handle, into the
+    /// given buffer.
+    size_t copy_sequence(const handle_t& handle, char* dest) const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // ExpandingOverlayGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Returns the handle in the underlying graph that corresponds to a handle
+    /// in the overlay
+    handle_t get_underlying_handle(const handle_t& handle) const;
+    
+protected:
+    
+    /// Loop over all the handles to next/previous (right/left) nodes. Passes
+    /// them to a callback which returns false to stop iterating and true to
+    /// continue. Returns true if we finished and false if we stopped early.
+    bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+    
+    /// Loop over all the nodes in the graph in their local forward
+    /// orientations, in their internal stored order. Stop if the iteratee
+    /// returns false. Can be told to run in parallel, in which case stopping
+    /// after a false return value is on a best-effort basis and iteration
+    /// order is not defined.
+    bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+    
+    /// Determine if the node with the given ID is flipped relative to the
+    /// underlying graph.
+    inline bool is_flipped(nid_t node_id) const {
+        size_t index = node_id - min_id;
+        return index < flips.size() && flips[index];
+    }
+    
+    /// The graph we are a view of
+    const HandleGraph* graph;
+    
+    /// The ID that the first flag is for
+    nid_t min_id;
+    
+    /// Whether each node, by ID offset from min_id, is flipped
+    std::vector<bool> flips;
+};
+
+}
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef HANDLEGRAPH_OVERLAYS_REVERSE_COMPLEMENT_OVERLAY_HPP_INCLUDED
+#define HANDLEGRAPH_OVERLAYS_REVERSE_COMPLEMENT_OVERLAY_HPP_INCLUDED
+
+/** \file
+ * Defines overlays that present the reverse complement of a graph, without
+ * copying it.
+ */
+
+#include "handlegraph/expanding_overlay_graph.hpp"
+#include "handlegraph/path_handle_graph.hpp"
+
+namespace handlegraph {
+
+/**
+ * A view of a graph where the forward strand of every node is the reverse
+ * strand of the underlying node, as algorithms::reverse_complement_graph()
+ * would build. Node IDs are the same as in the underlying graph. Overlay
+ * handles are underlying handles, only with the meaning of their orientation
+ * flipped, so nothing is stored and everything is passed straight through.
+ */
+class ReverseComplementOverlay : public ExpandingOverlayGraph {
+public:
+    
+    /// Make an overlay of the given graph, which must outlive it.
+    ReverseComplementOverlay(const HandleGraph* graph);
+    
+    virtual ~ReverseComplementOverlay() = default;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // HandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Method to check if a node exists by ID
+    bool has_node(nid_t node_id) const;
+    
+    /// Look up the handle for the node with the given ID in the given orientation
+    handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+    
+    /// Get the ID from a handle
+    nid_t get_id(const handle_t& handle) const;
+    
+    /// Get the orientation of a handle
+    bool get_is_reverse(const handle_t& handle) const;
+    
+    /// Invert the orientation of a handle (potentially without getting its ID)
+    handle_t flip(const handle_t& handle) const;
+    
+    /// Get the length of a node
+    size_t get_length(const handle_t& handle) const;
+    
+    /// Get the sequence of a node, presented in the handle's local forward
+    /// orientation.
+    std::string get_sequence(const handle_t& handle) const;
+    
+    /// Return the number of nodes in the graph
+    size_t get_node_count() const;
+    
+    /// Return the smallest ID in the graph, or some smaller number if the
+    /// smallest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t min_node_id() const;
+    
+    /// Return the largest ID in the graph, or some larger number if the
+    /// largest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t max_node_id() const;
+    
+    /// Get the number of edges on the right (go_left = false) or left (go_left
+    /// = true) side of the given handle.
+    size_t get_degree(const handle_t& handle, bool go_left) const;
+    
+    /// Returns true if there is an edge that allows traversal from the left
+    /// handle to the right handle.
+    bool has_edge(const handle_t& left, const handle_t& right) const;
+    
+    /// Return the total number of edges in the graph.
+    size_t get_edge_count() const;
+    
+    /// Return the total length of all nodes in the graph, in bp.
+    size_t get_total_length() const;
+    
+    /// Returns one base of a handle's sequence, in the orientation of the
+    /// handle.
+    char get_base(const handle_t& handle, size_t index) const;
+    
+    /// Returns a substring of a handle's sequence, in the orientation of the
+    /// handle.
+    std::string get_subsequence(const handle_t& handle, size_t index, size_t size) const;
+    
+    /// Writes a handle's sequence, in the orientation of the handle, into the
+    /// given buffer.
+    size_t copy_sequence(const handle_t& handle, char* dest) const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // ExpandingOverlayGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Returns the handle in the underlying graph that corresponds to a handle
+    /// in the overlay
+    handle_t get_underlying_handle(const handle_t& handle) const;
+    
+protected:
+    
+    /// Loop over all the handles to next/previous (right/left) nodes. Passes
+    /// them to a callback which returns false to stop iterating and true to
+    /// continue. Returns true if we finished and false if we stopped early.
+    bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+    
+    /// Loop over all the nodes in the graph in their local forward
+    /// orientations, in their internal stored order. Stop if the iteratee
+    /// returns false. Can be told to run in parallel, in which case stopping
+    /// after a false return value is on a best-effort basis and iteration
+    /// order is not defined.
+    bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+    
+    /// The graph we are a view of
+    const HandleGraph* graph;
+};
+
+/**
+ * A ReverseComplementOverlay that also has the underlying graph's paths,
+ * each traversed backward, so that each path spells the reverse complement
+ * of what it spells in the underlying graph. Path handles and step handles
+ * are the underlying ones.
+ */
+class PathReverseComplementOverlay : public ReverseComplementOverlay, public PathHandleGraph {
+public:
+    
+    /// Make an overlay of the given graph, which must outlive it.
+    PathReverseComplementOverlay(const PathHandleGraph* graph);
+    
+    virtual ~PathReverseComplementOverlay() = default;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // PathHandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Returns the number of paths stored in the graph
+    size_t get_path_count() const;
+    
+    /// Determine if a path name exists and is legal to get a path handle for.
+    bool has_path(const std::string& path_name) const;
+    
+    /// Look up the path handle for the given path name.
+    path_handle_t get_path_handle(const std::string& path_name) const;
+    
+    /// Look up the name of a path from a handle to it
+    std::string get_path_name(const path_handle_t& path_handle) const;
+    
+    /// Look up whether a path is circular
+    bool get_is_circular(const path_handle_t& path_handle) const;
+    
+    /// Returns the number of node steps in the path
+    size_t get_step_count(const path_handle_t& path_handle) const;
+    
+    /// Returns the number of node steps on a handle
+    size_t get_step_count(const handle_t& handle) const;
+    
+    /// Get a node handle (node ID and orientation) from a handle to a step on a path
+    handle_t get_handle_of_step(const step_handle_t& step_handle) const;
+    
+    /// Returns a handle to the path that an step is on
+    path_handle_t get_path_handle_of_step(const step_handle_t& step_handle) const;
+    
+    /// Get a handle to the first step, which will be an arbitrary step in a circular path
+    /// that we consider "first" based on our construction of the path. If the path is empty,
+    /// then the implementation must return the same value as path_end().
+    step_handle_t path_begin(const path_handle_t& path_handle) const;
+    
+    /// Get a handle to a fictitious position past the end of a path. This position is
+    /// returned by get_next_step for the final step in a path in a non-circular path.
+    /// Note: get_next_step will *NEVER* return this value for a circular path.
+    step_handle_t path_end(const path_handle_t& path_handle) const;
+    
+    /// Get a handle to the last step, which will be an arbitrary step in a circular path that
+    /// we consider "last" based on our construction of the path. If the path is empty
+    /// then the implementation must return the same value as path_front_end().
+    step_handle_t path_back(const path_handle_t& path_handle) const;
+    
+    /// Get a handle to a fictitious position before the beginning of a path. This position is
+    /// return by get_previous_step for the first step in a path in a non-circular path.
+    /// Note: get_previous_step will *NEVER* return this value for a circular path.
+    step_handle_t path_front_end(const path_handle_t& path_handle) const;
+    
+    /// Returns true if the step is not the last step in a non-circular path.
+    bool has_next_step(const step_handle_t& step_handle) const;
+    
+    /// Returns true if the step is not the first step in a non-circular path.
+    bool has_previous_step(const step_handle_t& step_handle) const;
+    
+    /// Returns a handle to the next step on the path. If the given step is the final step
+    /// of a non-circular path, this method has undefined behavior. In a circular path,
+    /// the "last" step will loop around to the "first" step.
+    step_handle_t get_next_step(const step_handle_t& step_handle) const;
+    
+    /// Returns a handle to the previous step on the path. If the given step is the first
+    /// step of a non-circular path, this method has undefined behavior. In a circular path,
+    /// it will loop around from the "first" step (i.e. the one returned by path_begin) to
+    /// the "last" step.
+    step_handle_t get_previous_step(const step_handle_t& step_handle) const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // PathMetadata interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// What is the given path meant to be representing?
+    PathSense get_sense(const path_handle_t& handle) const;
+    
+    /// Get the name of the sample or assembly associated with the
+    /// path-or-thread, or NO_SAMPLE_NAME if it does not belong to one.
+    std::string get_sample_name(const path_handle_t& handle) const;
+    
+    /// Get the name of the contig or gene associated with the path-or-thread,
+    /// or NO_LOCUS_NAME if it does not belong to one.
+    std::string get_locus_name(const path_handle_t& handle) const;
+    
+    /// Get the haplotype number (0 or 1, for diploid) of the path-or-thread,
+    /// or NO_HAPLOTYPE if it does not belong to one.
+    size_t get_haplotype(const path_handle_t& handle) const;
+    
+    /// Get the phase block number (contiguously phased region of a sample,
+    /// contig, and haplotype) of the path-or-thread, or NO_PHASE_BLOCK if it
+    /// does not belong to one.
+    size_t get_phase_block(const path_handle_t& handle) const;
+    
+    /// Get the bounds of the path-or-thread that are actually represented
+    /// here. Should be NO_SUBRANGE if the entirety is represented here, and
+    /// 0-based inclusive start and exclusive end positions of the stored
+    /// region on the full path-or-thread if a subregion is stored. These are
+    /// the underlying path's bounds; they are not reversed.
+    subrange_t get_subrange(const path_handle_t& handle) const;
+    
+protected:
+    
+    /// Execute a function on each path in the graph. If it returns false, stop
+    /// iteration. Returns true if we finished and false if we stopped early.
+    bool for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const;
+    
+    /// Execute a function on each step of a handle in any path. If it
+    /// returns false, stop iteration. Returns true if we finished and false if
+    /// we stopped early.
+    bool for_each_step_on_handle_impl(const handle_t& handle,
+                                      const std::function<bool(const step_handle_t&)>& iteratee) const;
+    
+    /// Execute a function on the first and last steps of each maximal run of
+    /// consecutive path steps that visit nodes in the given ID ranges. Uses
+    /// the underlying graph's implementation.
+    bool for_each_path_interval_impl(const std::vector<std::pair<nid_t, nid_t>>& id_ranges,
+                                     const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const;
+    
+    /// Loop through all the paths matching the given query. Query elements
+    /// which are null match everything. Returns false and stops if the
+    /// iteratee returns false.
+    bool for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                     const std::unordered_set<std::string>* samples,
+                                     const std::unordered_set<std::string>* loci,
+                                     const std::function<bool(const path_handle_t&)>& iteratee) const;
+    
+    /// Loop through all steps on the given handle for paths with the given
+    /// sense. Returns false and stops if the iteratee returns false.
+    bool for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                     const std::function<bool(const step_handle_t&)>& iteratee) const;
+    
+    /// The graph we are a view of, as a PathHandleGraph
+    const PathHandleGraph* path_graph;
+};
+
+}
+
+#endif
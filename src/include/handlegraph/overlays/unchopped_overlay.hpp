@@ -0,0 +1,330 @@
+#ifndef HANDLEGRAPH_OVERLAYS_UNCHOPPED_OVERLAY_HPP_INCLUDED
+#define HANDLEGRAPH_OVERLAYS_UNCHOPPED_OVERLAY_HPP_INCLUDED
+
+/** \file
+ * Defines an overlay that presents a graph as if its unary chains of nodes had
+ * been merged, without copying it.
+ */
+
+#include "handlegraph/expanding_overlay_graph.hpp"
+#include "handlegraph/path_handle_graph.hpp"
+#include "handlegraph/named_node_back_translation.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * A view of a graph, with its paths, as algorithms::unchop() would leave it:
+ * each maximal chain of nodes that are joined by the only edges on their
+ * facing sides, and that every path visits together, is presented as one node.
+ *
+ * The chains are found in parallel when the overlay is made, and numbered
+ * from 1 in order of their lowest-ID ends, with any chains that close into
+ * cycles last. Each chain's underlying handles
+ * are stored in order, along with an offset into that table for each node ID,
+ * so memory use is proportional to the range of node IDs. Path handles are
+ * the underlying ones, and a step handle is the underlying step handle
+ * entering the chain, so stepping along a path takes time proportional to
+ * the number of underlying nodes in the chains stepped over.
+ *
+ * Translates back to the underlying graph's nodes, named by their IDs.
+ */
+class UnchoppedOverlay : public ExpandingOverlayGraph, public PathHandleGraph, public NamedNodeBackTranslation {
+public:
+    
+    /// Make an overlay of the given graph, which must outlive it, finding
+    /// chains in parallel as the execution options say.
+    UnchoppedOverlay(const PathHandleGraph* graph, const ExecutionOptions& execution = ExecutionOptions());
+    
+    virtual ~UnchoppedOverlay() = default;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // HandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Method to check if a node exists by ID
+    bool has_node(nid_t node_id) const;
+    
+    /// Look up the handle for the node with the given ID in the given orientation
+    handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+    
+    /// Get the ID from a handle
+    nid_t get_id(const handle_t& handle) const;
+    
+    /// Get the orientation of a handle
+    bool get_is_reverse(const handle_t& handle) const;
+    
+    /// Invert the orientation of a handle (potentially without getting its ID)
+    handle_t flip(const handle_t& handle) const;
+    
+    /// Get the length of a node
+    size_t get_length(const handle_t& handle) const;
+    
+    /// Get the sequence of a node, presented in the handle's local forward
+    /// orientation.
+    std::string get_sequence(const handle_t& handle) const;
+    
+    /// Return the number of nodes in the graph
+    size_t get_node_count() const;
+    
+    /// Return the smallest ID in the graph, or some smaller number if the
+    /// smallest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t min_node_id() const;
+    
+    /// Return the largest ID in the graph, or some larger number if the
+    /// largest ID is unavailable. Return value is unspecified if the graph is empty.
+    nid_t max_node_id() const;
+    
+    /// Return the total number of edges in the graph.
+    size_t get_edge_count() const;
+    
+    /// Return the total length of all nodes in the graph, in bp.
+    size_t get_total_length() const;
+    
+    /// Returns one base of a handle's sequence, in the orientation of the
+    /// handle.
+    char get_base(const handle_t& handle, size_t index) const;
+    
+    /// Returns a substring of a handle's sequence, in the orientation of the
+    /// handle.
+    std::string get_subsequence(const handle_t& handle, size_t index, size_t size) const;
+    
+    /// Writes a handle's sequence, in the orientation of the handle, into the
+    /// given buffer.
+    size_t copy_sequence(const handle_t& handle, char* dest) const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // ExpandingOverlayGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Returns the handle in the underlying graph that corresponds to a handle
+    /// in the overlay. This is the first underlying handle read by the overlay
+    /// handle.
+    handle_t get_underlying_handle(const handle_t& handle) const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // PathHandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Returns the number of paths stored in the graph
+    size_t get_path_count() const;
+    
+    /// Determine if a path name exists and is legal to get a path handle for.
+    bool has_path(const std::string& path_name) const;
+    
+    /// Look up the path handle for the given path name.
+    path_handle_t get_path_handle(const std::string& path_name) const;
+    
+    /// Look up the name of a path from a handle to it
+    std::string get_path_name(const path_handle_t& path_handle) const;
+    
+    /// Look up whether a path is circular
+    bool get_is_circular(const path_handle_t& path_handle) const;
+    
+    /// Returns the number of node steps in the path. Takes time proportional
+    /// to the number of steps in the underlying path.
+    size_t get_step_count(const path_handle_t& path_handle) const;
+    
+    /// Returns the number of node steps on a handle
+    size_t get_step_count(const handle_t& handle) const;
+    
+    /// Returns true if the given path is empty, and false otherwise
+    bool is_empty(const path_handle_t& path_handle) const;
+    
+    /// Get a node handle (node ID and orientation) from a handle to a step on a path
+    handle_t get_handle_of_step(const step_handle_t& step_handle) const;
+    
+    /// Returns a handle to the path that an step is on
+    path_handle_t get_path_handle_of_step(const step_handle_t& step_handle) const;
+    
+    /// Get a handle to the first step, which will be an arbitrary step in a circular path
+    /// that we consider "first" based on our construction of the path. If the path is empty,
+    /// then the implementation must return the same value as path_end().
+    step_handle_t path_begin(const path_handle_t& path_handle) const;
+    
+    /// Get a handle to a fictitious position past the end of a path. This position is
+    /// returned by get_next_step for the final step in a path in a non-circular path.
+    /// Note: get_next_step will *NEVER* return this value for a circular path.
+    step_handle_t path_end(const path_handle_t& path_handle) const;
+    
+    /// Get a handle to the last step, which will be an arbitrary step in a circular path that
+    /// we consider "last" based on our construction of the path. If the path is empty
+    /// then the implementation must return the same value as path_front_end().
+    step_handle_t path_back(const path_handle_t& path_handle) const;
+    
+    /// Get a handle to a fictitious position before the beginning of a path. This position is
+    /// return by get_previous_step for the first step in a path in a non-circular path.
+    /// Note: get_previous_step will *NEVER* return this value for a circular path.
+    step_handle_t path_front_end(const path_handle_t& path_handle) const;
+    
+    /// Returns true if the step is not the last step in a non-circular path.
+    bool has_next_step(const step_handle_t& step_handle) const;
+    
+    /// Returns true if the step is not the first step in a non-circular path.
+    bool has_previous_step(const step_handle_t& step_handle) const;
+    
+    /// Returns a handle to the next step on the path. If the given step is the final step
+    /// of a non-circular path, this method has undefined behavior. In a circular path,
+    /// the "last" step will loop around to the "first" step.
+    step_handle_t get_next_step(const step_handle_t& step_handle) const;
+    
+    /// Returns a handle to the previous step on the path. If the given step is the first
+    /// step of a non-circular path, this method has undefined behavior. In a circular path,
+    /// it will loop around from the "first" step (i.e. the one returned by path_begin) to
+    /// the "last" step.
+    step_handle_t get_previous_step(const step_handle_t& step_handle) const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // PathMetadata interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// What is the given path meant to be representing?
+    PathSense get_sense(const path_handle_t& handle) const;
+    
+    /// Get the name of the sample or assembly associated with the
+    /// path-or-thread, or NO_SAMPLE_NAME if it does not belong to one.
+    std::string get_sample_name(const path_handle_t& handle) const;
+    
+    /// Get the name of the contig or gene associated with the path-or-thread,
+    /// or NO_LOCUS_NAME if it does not belong to one.
+    std::string get_locus_name(const path_handle_t& handle) const;
+    
+    /// Get the haplotype number (0 or 1, for diploid) of the path-or-thread,
+    /// or NO_HAPLOTYPE if it does not belong to one.
+    size_t get_haplotype(const path_handle_t& handle) const;
+    
+    /// Get the phase block number (contiguously phased region of a sample,
+    /// contig, and haplotype) of the path-or-thread, or NO_PHASE_BLOCK if it
+    /// does not belong to one.
+    size_t get_phase_block(const path_handle_t& handle) const;
+    
+    /// Get the bounds of the path-or-thread that are actually represented
+    /// here. Should be NO_SUBRANGE if the entirety is represented here, and
+    /// 0-based inclusive start and exclusive end positions of the stored
+    /// region on the full path-or-thread if a subregion is stored.
+    subrange_t get_subrange(const path_handle_t& handle) const;
+    
+    ////////////////////////////////////////////////////////////////////////////
+    // NamedNodeBackTranslation interface
+    ////////////////////////////////////////////////////////////////////////////
+    
+    /// Translate the given range of bases on the given orientation of the
+    /// given node in the overlay, to the ranges on the underlying nodes it
+    /// covers, in order along the range.
+    std::vector<oriented_node_range_t> translate_back(const oriented_node_range_t& range) const;
+    
+    /// Get the name of a node in the underlying graph, given its ID, which is
+    /// the ID as a string.
+    std::string get_back_graph_node_name(const nid_t& back_node_id) const;
+    
+protected:
+    
+    /// Execute a function on each path in the graph. If it returns false, stop
+    /// iteration. Returns true if we finished and false if we stopped early.
+    bool for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const;
+    
+    /// Execute a function on each step of a handle in any path. If it
+    /// returns false, stop iteration. Returns true if we finished and false if
+    /// we stopped early.
+    bool for_each_step_on_handle_impl(const handle_t& handle,
+                                      const std::function<bool(const step_handle_t&)>& iteratee) const;
+    
+    /// Loop through all the paths matching the given query. Query elements
+    /// which are null match everything. Returns false and stops if the
+    /// iteratee returns false.
+    bool for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                     const std::unordered_set<std::string>* samples,
+                                     const std::unordered_set<std::string>* loci,
+                                     const std::function<bool(const path_handle_t&)>& iteratee) const;
+    
+    /// Loop through all steps on the given handle for paths with the given
+    /// sense. Returns false and stops if the iteratee returns false.
+    bool for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                     const std::function<bool(const step_handle_t&)>& iteratee) const;
+    
+    /// Loop over all the handles to next/previous (right/left) nodes. Passes
+    /// them to a callback which returns false to stop iterating and true to
+    /// continue. Returns true if we finished and false if we stopped early.
+    bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+    
+    /// Loop over all the nodes in the graph in their local forward
+    /// orientations, in their internal stored order. Stop if the iteratee
+    /// returns false. Can be told to run in parallel, in which case stopping
+    /// after a false return value is on a best-effort basis and iteration
+    /// order is not defined.
+    bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+    
+    /// Get the index in chain_handles of the given underlying node
+    inline size_t get_offset(nid_t node_id) const {
+        return node_offsets[node_id - min_id];
+    }
+    
+    /// Get the index of the chain that the entry in chain_handles at the given
+    /// offset belongs to
+    size_t get_chain(size_t offset) const;
+    
+    /// Get the overlay handle that contains the given underlying handle, in
+    /// the matching orientation
+    handle_t get_overlay_handle(const handle_t& underlying) const;
+    
+    /// Get the underlying handle an overlay handle starts with when read in
+    /// its orientation
+    handle_t get_entry_handle(const handle_t& handle) const;
+    
+    /// Get the underlying handle an overlay handle ends with when read in its
+    /// orientation
+    handle_t get_exit_handle(const handle_t& handle) const;
+    
+    /// Determine if an underlying handle is the first one in its chain, when
+    /// read in its own orientation
+    bool is_entry(const handle_t& underlying) const;
+    
+    /// Get the number of underlying nodes in a chain
+    inline size_t get_chain_size(size_t chain) const {
+        return chain_starts[chain + 1] - chain_starts[chain];
+    }
+    
+    /// Loop over the underlying handles that overlap the given range of the
+    /// sequence of an overlay handle, in order, along with the range on each.
+    /// Stops early if the iteratee returns false.
+    void for_each_piece(const handle_t& handle, size_t index, size_t size,
+                        const std::function<bool(const handle_t&, size_t, size_t)>& iteratee) const;
+    
+    /// Loop over the underlying steps that enter the given overlay handle.
+    /// Either loops over all steps or all steps of the given sense.
+    bool for_each_entering_step(const handle_t& handle, const PathSense* sense,
+                                const std::function<bool(const step_handle_t&)>& iteratee) const;
+    
+    /// Move along an underlying path by the given number of steps
+    step_handle_t advance(step_handle_t step, size_t steps, bool go_left) const;
+    
+    /// The graph we are a view of
+    const PathHandleGraph* graph;
+    
+    /// The smallest underlying node ID
+    nid_t min_id;
+    
+    /// The underlying handles in each chain, in order, with the chains
+    /// concatenated
+    std::vector<handle_t> chain_handles;
+    
+    /// The offset in the chain's sequence of each entry in chain_handles
+    std::vector<size_t> base_offsets;
+    
+    /// Where each chain starts in chain_handles, and then the total number of
+    /// handles
+    std::vector<size_t> chain_starts;
+    
+    /// The length of each chain's sequence
+    std::vector<size_t> chain_lengths;
+    
+    /// The index in chain_handles of each underlying node, by ID offset from
+    /// min_id
+    std::vector<size_t> node_offsets;
+};
+
+}
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef HANDLEGRAPH_OVERLAYS_VECTORIZABLE_OVERLAY_HPP_INCLUDED
+#define HANDLEGRAPH_OVERLAYS_VECTORIZABLE_OVERLAY_HPP_INCLUDED
+
+/** \file
+ * Defines an overlay that ranks the nodes and edges of any graph, so
+ * algorithms that keep dense arrays can run on it.
+ */
+
+#include "handlegraph/expanding_overlay_graph.hpp"
+#include "handlegraph/execution.hpp"
+#include "handlegraph/elias_fano.hpp"
+
+#include <vector>
+
+namespace handlegraph {
+
+/**
+ * A view of a graph as a VectorizableHandleGraph. Overlay handles are
+ * underlying handles. Node ranks follow node IDs, and node vector offsets
+ * follow node ranks.
+ *
+ * Node IDs are mapped to ranks in one of three ways, picked from how densely
+ * the IDs fill the range between the smallest and largest:
+ *
+ *  - If there are no gaps, ranks are computed from IDs, and nothing is kept.
+ *  - If at least half the IDs in the range are used, ranks are kept in an
+ *    array by ID, next to the sorted IDs.
+ *  - Otherwise, the sorted IDs are kept in an EliasFanoSequence, and a rank
+ *    is found by a search in it.
+ *
+ * Each node also keeps its vector offset and the number of edges before it.
+ * An edge is numbered from its canonical orientation, among the edges that
+ * leave its first handle's node to the right, so edge_index() takes time
+ * proportional to that node's degree. Edge indexes start at 1.
+ *
+ * The underlying graph must not change while the overlay exists.
+ */
+class VectorizableOverlay : public VectorizableHandleGraph, public ExpandingOverlayGraph {
+public:
+
+    /// Ways the node ranks can be stored
+    enum class RankEncoding {
+        /// IDs have no gaps, so ranks are computed
+        CONTIGUOUS,
+        /// Ranks are kept in an array by ID
+        DIRECT,
+        /// IDs are kept in an EliasFanoSequence
+        ELIAS_FANO
+    };
+
+    /// Make an overlay of the given graph, which must outlive it, finding
+    /// the nodes and their offsets in parallel as the execution options say.
+    VectorizableOverlay(const HandleGraph* graph, const ExecutionOptions& execution = ExecutionOptions());
+
+    virtual ~VectorizableOverlay() = default;
+
+    /// Get the way the node ranks are stored.
+    RankEncoding get_rank_encoding() const;
+
+    /// Get the number of bytes used by the ranks and offsets.
+    size_t get_memory_usage() const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // HandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Method to check if a node exists by ID
+    bool has_node(nid_t node_id) const;
+
+    /// Look up the handle for the node with the given ID in the given orientation
+    handle_t get_handle(const nid_t& node_id, bool is_reverse = false) const;
+
+    /// Get the ID from a handle
+    nid_t get_id(const handle_t& handle) const;
+
+    /// Get the orientation of a handle
+    bool get_is_reverse(const handle_t& handle) const;
+
+    /// Invert the orientation of a handle (potentially without getting its ID)
+    handle_t flip(const handle_t& handle) const;
+
+    /// Get the length of a node
+    size_t get_length(const handle_t& handle) const;
+
+    /// Get the sequence of a node, presented in the handle's local forward
+    /// orientation.
+    std::string get_sequence(const handle_t& handle) const;
+
+    /// Return the number of nodes in the graph
+    size_t get_node_count() const;
+
+    /// Return the smallest ID in the graph.
+    nid_t min_node_id() const;
+
+    /// Return the largest ID in the graph.
+    nid_t max_node_id() const;
+
+    /// Get the number of edges on the right (go_left = false) or left (go_left
+    /// = true) side of the given handle.
+    size_t get_degree(const handle_t& handle, bool go_left) const;
+
+    /// Returns true if there is an edge that allows traversal from the left
+    /// handle to the right handle.
+    bool has_edge(const handle_t& left, const handle_t& right) const;
+
+    /// Return the total number of edges in the graph.
+    size_t get_edge_count() const;
+
+    /// Return the total length of all nodes in the graph, in bp.
+    size_t get_total_length() const;
+
+    /// Returns one base of a handle's sequence, in the orientation of the
+    /// handle.
+    char get_base(const handle_t& handle, size_t index) const;
+
+    /// Returns a substring of a handle's sequence, in the orientation of the
+    /// handle.
+    std::string get_subsequence(const handle_t& handle, size_t index, size_t size) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // RankedHandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Return the rank of a node (ranks start at 1 and are dense), or 0 if
+    /// the node is not in the graph.
+    size_t id_to_rank(const nid_t& node_id) const;
+
+    /// Return the node with a given rank.
+    nid_t rank_to_id(const size_t& rank) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // VectorizableHandleGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Return the start position of the node in a (possibly implict) sorted array
+    /// constructed from the concatenation of the node sequences
+    size_t node_vector_offset(const nid_t& node_id) const;
+
+    /// Return the node overlapping the given offset in the implicit node
+    /// vector. Throws std::runtime_error if the offset is past the end.
+    nid_t node_at_vector_offset(const size_t& offset) const;
+
+    /// Return a unique index among edges in the graph, from 1 to
+    /// get_edge_count(). Throws std::runtime_error if the edge is not in the
+    /// graph.
+    size_t edge_index(const edge_t& edge) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    // ExpandingOverlayGraph interface
+    ////////////////////////////////////////////////////////////////////////////
+
+    /// Returns the handle in the underlying graph that corresponds to a handle
+    /// in the overlay
+    handle_t get_underlying_handle(const handle_t& handle) const;
+
+protected:
+
+    /// Loop over all the handles to next/previous (right/left) nodes. Passes
+    /// them to a callback which returns false to stop iterating and true to
+    /// continue. Returns true if we finished and false if we stopped early.
+    bool follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const;
+
+    /// Loop over all the nodes in the graph in their local forward
+    /// orientations, in the underlying graph's order. Stop if the iteratee
+    /// returns false. Can be told to run in parallel, in which case stopping
+    /// after a false return value is on a best-effort basis and iteration
+    /// order is not defined.
+    bool for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel = false) const;
+
+    /// Loop over the edges numbered from the given node, in canonical
+    /// orientation, in the order they are numbered.
+    bool for_each_numbered_edge(nid_t node_id, const std::function<bool(const edge_t&)>& iteratee) const;
+
+    /// The graph we are a view of
+    const HandleGraph* graph;
+
+    /// How ranks are stored
+    RankEncoding encoding = RankEncoding::CONTIGUOUS;
+
+    /// The number of nodes
+    size_t node_count = 0;
+
+    /// The smallest node ID
+    nid_t min_id = 0;
+
+    /// The largest node ID
+    nid_t max_id = 0;
+
+    /// The rank of each ID offset from min_id, or 0 if it is missing, for
+    /// DIRECT
+    std::vector<size_t> ranks;
+
+    /// The IDs in rank order, for DIRECT
+    std::vector<nid_t> ids;
+
+    /// The IDs offset from min_id, for ELIAS_FANO
+    EliasFanoSequence id_sequence;
+
+    /// The vector offset of each rank minus 1, then the total length
+    std::vector<size_t> node_offsets;
+
+    /// The number of edges numbered from earlier ranks, by rank minus 1,
+    /// then the total number of edges
+    std::vector<size_t> edge_offsets;
+};
+
+}
+
+#endif
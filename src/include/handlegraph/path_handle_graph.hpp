@@ -116,6 +116,16 @@ public:
     template<typename Iteratee>
     bool for_each_step_on_handle(const handle_t& handle, const Iteratee& iteratee) const;
     
+    /// Execute a function on the first and last steps of each maximal run of
+    /// consecutive path steps that visit nodes in the given ID ranges. The
+    /// ranges are inclusive, sorted, and non-overlapping. If it returns bool
+    /// and returns false, stop iteration. Returns true if we finished and
+    /// false if we stopped early.
+    ///
+    /// Only paths visible to for_each_step_on_handle() are searched.
+    template<typename Iteratee>
+    bool for_each_path_interval(const std::vector<std::pair<nid_t, nid_t>>& id_ranges, const Iteratee& iteratee) const;
+    
     ////////////////////////////////////////////////////////////////////////////
     // Backing protected virtual methods that need to be implemented
     ////////////////////////////////////////////////////////////////////////////
@@ -153,6 +163,42 @@ public:
 
     /// Returns true if the given path is empty, and false otherwise
     virtual bool is_empty(const path_handle_t& path_handle) const;
+    
+    /// Write the handles of up to max_steps consecutive steps of the given
+    /// path, starting at the given step, into the buffer, and advance the step
+    /// past them. After the step returned by path_back() is written, the step
+    /// is set to path_end(), even in a circular path. Returns the number of
+    /// handles written, which is 0 if the step is already path_end(). The
+    /// default implementation calls get_next_step() per step, but
+    /// implementations that store steps contiguously can do much better.
+    virtual size_t get_step_handles(const path_handle_t& path, step_handle_t& step,
+                                    handle_t* buffer, size_t max_steps) const;
+    
+    /// Write up to max_steps of the steps on the given handle into the
+    /// buffer, continuing the order of for_each_step_on_handle() from the
+    /// given cursor, and advance the cursor past them. A cursor starts at 0,
+    /// and is otherwise only meaningful to the implementation. Returns the
+    /// number of steps written, which is 0 at the end. The default
+    /// implementation counts its way through for_each_step_on_handle() every
+    /// time; implementations that override it should also override
+    /// has_efficient_cursors().
+    virtual size_t get_next_steps_on_handle(const handle_t& handle, uint64_t& cursor,
+                                            step_handle_t* buffer, size_t max_steps) const;
+
+protected:
+    
+    /// Execute a function on the first and last steps of each maximal run of
+    /// consecutive path steps that visit nodes in the given inclusive, sorted,
+    /// non-overlapping ID ranges. If it returns false, stop iteration. Returns
+    /// true if we finished and false if we stopped early. The default
+    /// implementation finds the steps on each node with
+    /// for_each_step_on_handle() and joins them with
+    /// for_each_step_interval(), but implementations with an index of the
+    /// paths through ID ranges can do better.
+    virtual bool for_each_path_interval_impl(const std::vector<std::pair<nid_t, nid_t>>& id_ranges,
+                                             const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const;
+    
+public:
 
     ////////////////////////////////////////////////////////////////////////////
     // Concrete utility methods
@@ -163,6 +209,10 @@ public:
     /// for (handle_t handle : graph->scan_path(path)) { }
     PathForEachSocket scan_path(const path_handle_t& path) const;
     
+    /// Get a pull iterator over the steps on a handle, in the same order as
+    /// for_each_step_on_handle().
+    Cursor<step_handle_t> scan_steps_on_handle(const handle_t& handle) const;
+    
     /// Loop over all the steps (step_handle_t) along a path. In a non-circular
     /// path, iterates from first through last step. In a circular path, iterates
     /// from the step returned by path_begin forward around to the step immediately
@@ -170,6 +220,24 @@ public:
     /// true if we finished and false if we stopped early.
     template<typename Iteratee>
     bool for_each_step_in_path(const path_handle_t& path, const Iteratee& iteratee) const;
+    
+    /// Loop over the handles of all the steps along a path, in the same order
+    /// as for_each_step_in_path(), fetching them in blocks with
+    /// get_step_handles(). If the iteratee returns bool, and it returns false,
+    /// stop. Returns true if we finished and false if we stopped early.
+    template<typename Iteratee>
+    bool for_each_handle_in_path(const path_handle_t& path, const Iteratee& iteratee) const;
+    
+    /// Number of steps fetched at a time by for_each_handle_in_path().
+    static const size_t STEP_BLOCK_SIZE = 256;
+    
+    /// Given distinct steps, in any order, execute a function on the first
+    /// and last steps of each maximal run of consecutive steps among them, on
+    /// the same path. A circular path with all its steps given is one run.
+    /// If the iteratee returns false, stop iteration. Returns true if we
+    /// finished and false if we stopped early.
+    bool for_each_step_interval(const std::vector<step_handle_t>& steps,
+                                const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const;
 };
 
 ////////////////////////////////////////////////////////////////////////////
@@ -186,6 +254,11 @@ bool PathHandleGraph::for_each_step_on_handle(const handle_t& handle, const Iter
     return for_each_step_on_handle_impl(handle, BoolReturningWrapper<Iteratee>::wrap(iteratee));
 }
 
+template<typename Iteratee>
+bool PathHandleGraph::for_each_path_interval(const std::vector<std::pair<nid_t, nid_t>>& id_ranges, const Iteratee& iteratee) const {
+    return for_each_path_interval_impl(id_ranges, BoolReturningWrapper<Iteratee>::wrap(iteratee));
+}
+
 
 template<typename Iteratee>
 bool PathHandleGraph::for_each_step_in_path(const path_handle_t& path, const Iteratee& iteratee) const {
@@ -212,6 +285,25 @@ bool PathHandleGraph::for_each_step_in_path(const path_handle_t& path, const Ite
     
     return keep_going;
 }
+
+template<typename Iteratee>
+bool PathHandleGraph::for_each_handle_in_path(const path_handle_t& path, const Iteratee& iteratee) const {
+    
+    auto wrapped = BoolReturningWrapper<Iteratee>::wrap(iteratee);
+    
+    handle_t block[STEP_BLOCK_SIZE];
+    step_handle_t here = path_begin(path);
+    size_t count;
+    while ((count = get_step_handles(path, here, block, STEP_BLOCK_SIZE)) != 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (!wrapped(block[i])) {
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
     
 /**
  * An auxilliary class that enables for each loops over paths. Not intended to
@@ -0,0 +1,128 @@
+#ifndef HANDLEGRAPH_READ_AHEAD_HPP_INCLUDED
+#define HANDLEGRAPH_READ_AHEAD_HPP_INCLUDED
+
+/** \file 
+ * Defines a stream buffer that reads ahead of its consumer on a background
+ * thread, for feeding deserialize_members() from pipes and slow streams.
+ */
+
+#include <streambuf>
+#include <istream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+
+namespace handlegraph {
+
+/**
+ * A std::streambuf that reads from a file descriptor or another std::istream
+ * on a background thread, filling one large aligned buffer while the consumer
+ * reads from the other. This keeps a producer on the other end of a pipe (such
+ * as a decompressor) working while the data already read is being parsed.
+ *
+ * The source is read ahead of the consumer, possibly to its end, so nothing
+ * else should read from it while the buffer exists. Read errors are reported
+ * to the consumer as end of file, and can be rethrown with rethrow_error().
+ */
+class ReadAheadBuffer : public std::streambuf {
+public:
+    
+    /// Size of each of the two buffers, if not specified.
+    static const size_t DEFAULT_BUFFER_SIZE;
+    
+    /// Read ahead from an open file descriptor, which is not closed.
+    ReadAheadBuffer(int fd, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    
+    /// Read ahead from another stream. Destruction may block until a
+    /// pending read from the stream returns.
+    ReadAheadBuffer(std::istream& in, size_t buffer_size = DEFAULT_BUFFER_SIZE);
+    
+    /// Stop reading ahead and release the buffers.
+    virtual ~ReadAheadBuffer();
+    
+    ReadAheadBuffer(const ReadAheadBuffer& other) = delete;
+    ReadAheadBuffer& operator=(const ReadAheadBuffer& other) = delete;
+    
+    /// If reading from the source failed, throw the error that occurred.
+    void rethrow_error() const;
+    
+protected:
+    
+    /// Make the next filled buffer available to the consumer.
+    virtual int_type underflow();
+    
+private:
+    
+    /// Allocate the buffers and start the reading thread.
+    void start(size_t buffer_size);
+    
+    /// Body of the reading thread.
+    void fill_buffers();
+    
+    /// Read up to the given number of bytes from the source, returning the
+    /// number read, or 0 at the end of the source, or throwing on error.
+    /// Returns early with 0 bytes if asked to stop.
+    size_t read_source(char* dest, size_t length);
+    
+    /// Number of bytes before each buffer kept for putting back characters
+    /// that came from the previous buffer.
+    static const size_t PUTBACK_SIZE;
+    
+    /// Source file descriptor, or -1 if reading from a stream
+    int source_fd = -1;
+    /// Source stream, or null if reading from a file descriptor
+    std::istream* source_stream = nullptr;
+    
+    /// Capacity of each buffer, not counting its putback area
+    size_t buffer_size = 0;
+    /// The two buffers, each with a putback area in front
+    char* buffers[2] = {nullptr, nullptr};
+    /// Number of bytes in each buffer that the reading thread has filled
+    size_t filled[2] = {0, 0};
+    /// Whether each buffer has been filled and not yet released by the consumer
+    bool ready[2] = {false, false};
+    /// The buffer the consumer is reading, if it is holding one
+    size_t consuming = 0;
+    bool holding = false;
+    
+    /// Set when the reading thread has read everything it will read
+    bool source_done = false;
+    /// Set to ask the reading thread to exit
+    bool stopping = false;
+    /// Set while the consumer is blocked waiting for data
+    std::atomic<bool> consumer_waiting{false};
+    /// Error encountered by the reading thread, if any
+    std::exception_ptr error;
+    
+    mutable std::mutex mutex;
+    std::condition_variable state_changed;
+    std::thread reader;
+};
+
+/**
+ * A std::istream over a ReadAheadBuffer, suitable for passing to
+ * deserialize_members().
+ */
+class ReadAheadStream : public std::istream {
+public:
+    
+    /// Read ahead from an open file descriptor, which is not closed.
+    ReadAheadStream(int fd, size_t buffer_size = ReadAheadBuffer::DEFAULT_BUFFER_SIZE);
+    
+    /// Read ahead from another stream.
+    ReadAheadStream(std::istream& in, size_t buffer_size = ReadAheadBuffer::DEFAULT_BUFFER_SIZE);
+    
+    virtual ~ReadAheadStream() = default;
+    
+    /// If reading from the source failed, throw the error that occurred.
+    void rethrow_error() const;
+    
+private:
+    ReadAheadBuffer buffer;
+};
+
+}
+
+#endif
@@ -66,6 +66,13 @@ public:
     /// of this interface as is calling deserialize(). Can only be called on an
     /// empty object.
     virtual void deserialize(const std::string& filename);
+    /// Sets the contents of this object to the contents of a serialized object
+    /// from an open file descriptor, such as a pipe. The serialized object
+    /// must be from the same implementation of this interface as is calling
+    /// deserialize(). Can only be called on an empty object. By default, reads
+    /// ahead on a background thread while deserialize_members() runs, so the
+    /// file descriptor may be read past the end of the object.
+    virtual void deserialize(int fd);
     
     ////////////////////////////////////////
     // These methods can be overridden if non-const serialization can be more
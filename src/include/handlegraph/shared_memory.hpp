@@ -0,0 +1,66 @@
+#ifndef HANDLEGRAPH_SHARED_MEMORY_HPP_INCLUDED
+#define HANDLEGRAPH_SHARED_MEMORY_HPP_INCLUDED
+
+/** \file 
+ * Defines tools for sharing TriviallySerializable objects between processes
+ * through named POSIX shared memory.
+ */
+
+#include "handlegraph/trivially_serializable.hpp"
+
+#include <string>
+
+namespace handlegraph {
+
+/*
+ * A published object lives in two shared memory segments: one holding exactly
+ * its serialized representation, so that it can be handed to
+ * TriviallySerializable::deserialize(int), and a small header segment holding
+ * a format version, the object's magic number, its length, and a count of
+ * attached processes.
+ *
+ * Attaching processes only share memory if the implementation's
+ * deserialize(int) maps the file descriptor rather than copying from it. The
+ * descriptor is opened read only, so the implementation must map it with
+ * PROT_READ alone, or MAP_PRIVATE if it needs to write; one that maps
+ * MAP_SHARED with PROT_WRITE will fail to attach.
+ *
+ * The attachment count is advisory: it is only changed by
+ * attach_to_shared_memory() and detach_from_shared_memory(), so a process
+ * that exits or crashes without detaching stays counted forever, and nothing
+ * is removed when the count reaches zero. Whoever published the object is
+ * responsible for calling remove_from_shared_memory() when it is done.
+ *
+ * Names follow shm_open() rules; a leading '/' is added if missing.
+ */
+
+/// Version of the shared memory header layout. Attaching to a segment
+/// published with a different version fails.
+extern const uint32_t SHARED_MEMORY_FORMAT_VERSION;
+
+/// Copy the serialized representation of the given object into new named
+/// shared memory segments. Throws if segments with that name already exist.
+void publish_to_shared_memory(const TriviallySerializable& object, const std::string& name);
+
+/// Load the given empty object from the named shared memory segments, read
+/// only, and count this as an attachment. Throws if the segments do not exist,
+/// are from a different header version, hold a different type of object, or
+/// are still being published.
+void attach_to_shared_memory(TriviallySerializable& object, const std::string& name);
+
+/// Record that an object attached to the named segments is no longer in use.
+/// Returns the number of attachments remaining. Does not remove the segments,
+/// even if none remain.
+size_t detach_from_shared_memory(const std::string& name);
+
+/// Get the number of attachments currently recorded for the named segments.
+/// Includes processes that attached and then died without detaching.
+size_t get_shared_memory_attach_count(const std::string& name);
+
+/// Remove the names of the shared memory segments. Attached objects remain
+/// valid, and the memory is released when the last of them is destroyed.
+void remove_from_shared_memory(const std::string& name);
+
+}
+
+#endif
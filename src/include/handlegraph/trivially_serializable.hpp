@@ -10,6 +10,7 @@
 #include <iostream>
 #include <limits>
 #include <functional>
+#include <vector>
 
 namespace handlegraph {
 
@@ -27,6 +28,12 @@ namespace handlegraph {
  * disk or through another associated object, is undefined behavior.
  * To prevent modifications to an object from modifying the last file loaded or
  * saved to, use dissociate().
+ *
+ * Implementations can opt in to incremental saving by returning true from
+ * tracks_dirty_regions() and reporting every byte range of the serialized
+ * representation they modify through mark_dirty(). serialize_incremental()
+ * can then bring the file last saved or loaded up to date by rewriting only
+ * the dirty pages.
  */
 class TriviallySerializable : public Serializable {
 
@@ -129,14 +136,82 @@ public:
     /// be called on an empty object. May result in a write-back link to a file
     /// opened as standard input if that stream is passed.
     virtual void deserialize(std::istream& in);
+    
+    // Incremental saving support. Implementations that can report which parts
+    // of their serialized representation they change need to override
+    // tracks_dirty_regions() and call mark_dirty(); everything else is
+    // provided.
+    
+    /// Returns true if the implementation reports all modifications to its
+    /// serialized representation through mark_dirty(). If false (the
+    /// default), serialize_incremental() always rewrites the whole file.
+    virtual bool tracks_dirty_regions() const;
+    
+    /// Bring the named file, which must hold the serialized representation
+    /// written or read by the most recent serialize(filename) or
+    /// deserialize(filename) call on this object, up to date with the
+    /// object's current contents. Only pages marked dirty since then are
+    /// rewritten, through a journal that makes the update atomic with respect
+    /// to crashes. If the named file is not that baseline, or dirty regions
+    /// are not tracked, atomically replaces the whole file instead. Does not affect
+    /// any existing write-back links.
+    virtual void serialize_incremental(const std::string& filename);
+    
+    /// Complete an incremental save of the named file that was interrupted
+    /// after its journal was committed, or discard one that was interrupted
+    /// before. Called automatically by deserialize(filename) and
+    /// serialize_incremental().
+    ///
+    /// Recovery, and saving and loading by file name, each hold an flock on
+    /// a ".lock" file next to the named file, which is left in place, so
+    /// that processes sharing the file wait for each other's saves. A full
+    /// save with serialize(filename) discards any leftover journal.
+    static void recover_incremental(const std::string& filename);
 
 protected:
+    
+    /// Granularity, in bytes, at which dirty regions are tracked.
+    static const size_t DIRTY_PAGE_SIZE;
+    
+    /// Record that the given range of bytes of the serialized representation,
+    /// counted from the start of the magic number, has changed since the last
+    /// save or load.
+    void mark_dirty(size_t offset, size_t length);
+    
+    /// Record that the object matches the named file, just saved or loaded,
+    /// and clear all dirty regions. The file is identified by its device,
+    /// inode and size, so incremental saves only patch that same file.
+    /// Called automatically by the filename-based serialize() and
+    /// deserialize().
+    void mark_clean(const std::string& filename);
+    
+    /// Return true if the named file is the one last passed to mark_clean(),
+    /// and is still the size it was then.
+    bool is_baseline(const std::string& filename) const;
+    
+    /// Call the given function with the start and past-end offsets of each
+    /// maximal run of dirty pages, in order.
+    void for_each_dirty_range(const std::function<void(size_t, size_t)>& iteratee) const;
 
     /// Helper to open a file descriptor with error checking.
     int open_fd(const std::string& filename) const;
     
     /// Helper to close a file descriptor with error checking.
     void close_fd(int fd) const;
+    
+private:
+    
+    /// One flag per DIRTY_PAGE_SIZE page of the serialized representation.
+    std::vector<bool> dirty_pages;
+    
+    /// True if the object is known to match the file last saved or loaded,
+    /// apart from the dirty pages.
+    bool has_clean_baseline = false;
+    
+    /// Device, inode and size of the file last saved or loaded
+    uint64_t baseline_device = 0;
+    uint64_t baseline_inode = 0;
+    uint64_t baseline_size = 0;
 };
 
 
@@ -117,6 +117,54 @@ inline bool operator<(const step_handle_t& a, const step_handle_t& b) {
            && as_integers(a)[1] < as_integers(b)[1]));
 }
 
+/// Define a way to pack a small extra number into the spare high bits of the
+/// second integer of some other step handle, for overlays that present more
+/// than one step for each underlying step. The second integer of the
+/// underlying step handle must be between -MAX_VALUE - 1 and MAX_VALUE, which
+/// holds for implementations that keep a rank or offset there. The number is
+/// XORed in, so packing 0 leaves the step handle unchanged.
+struct step_number_packing {
+
+    /// Number of bits available for the packed number
+    static const int NUMBER_BITS = 24;
+
+    /// Largest packable number
+    static const uint64_t MAX_NUMBER = (0x1ULL << NUMBER_BITS) - 1;
+
+    /// Largest allowed value of the second integer of the step handle
+    static const int64_t MAX_VALUE = (0x1LL << (63 - NUMBER_BITS)) - 1;
+
+    /// Determine if a step handle has the spare bits to pack a number into
+    inline static bool can_pack(const step_handle_t& step_handle) {
+        return as_integers(step_handle)[1] <= MAX_VALUE && as_integers(step_handle)[1] >= -MAX_VALUE - 1;
+    }
+
+    /// Extract the packed number
+    inline static uint64_t unpack_number(const step_handle_t& step_handle) {
+        uint64_t value = as_integers(step_handle)[1];
+        // Undo the XOR against the copies of the sign bit that were there
+        return ((value >> (63 - NUMBER_BITS)) ^ (value >> 63 ? MAX_NUMBER : 0)) & MAX_NUMBER;
+    }
+
+    /// Extract the step handle the number was packed into
+    inline static step_handle_t unpack_step(const step_handle_t& step_handle) {
+        step_handle_t unpacked = step_handle;
+        as_integers(unpacked)[1] ^= (int64_t) (unpack_number(step_handle) << (63 - NUMBER_BITS));
+        return unpacked;
+    }
+
+    /// Pack a number into a step handle
+    inline static step_handle_t pack(const step_handle_t& step_handle, const uint64_t& number) {
+        // Make sure everything fits
+        assert(number <= MAX_NUMBER);
+        assert(can_pack(step_handle));
+
+        step_handle_t packed = step_handle;
+        as_integers(packed)[1] ^= (int64_t) (number << (63 - NUMBER_BITS));
+        return packed;
+    }
+};
+
 //
 // Net handles
 //
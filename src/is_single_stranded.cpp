@@ -1,6 +1,8 @@
 #include "handlegraph/algorithms/is_single_stranded.hpp"
 
+
 #include <unordered_map>
+#include <algorithm>
 
 namespace handlegraph {
 namespace algorithms {
@@ -96,6 +98,137 @@ vector<handle_t> single_stranded_orientation(const HandleGraph* graph) {
     return orientation;
 }
 
+/// Number of node IDs handled by a thread at a time. A multiple of the word
+/// size, so threads never write to the same word of a vector<bool>.
+static const size_t NODE_BLOCK_SIZE = 4096;
+
+/**
+ * Union-find over dense indexes that also tracks, for each element, whether
+ * it has the same or the opposite parity from the root of its set.
+ */
+struct ParityUnionFind {
+    vector<size_t> parent;
+    vector<uint8_t> parity;
+    vector<uint8_t> rank;
+    
+    ParityUnionFind(size_t size) : parent(size), parity(size, 0), rank(size, 0) {
+        for (size_t i = 0; i < size; i++) {
+            parent[i] = i;
+        }
+    }
+    
+    /// Find the root of an element and its parity relative to the root,
+    /// without changing anything.
+    pair<size_t, bool> find(size_t i) const {
+        bool relative = false;
+        while (parent[i] != i) {
+            relative ^= parity[i];
+            i = parent[i];
+        }
+        return make_pair(i, relative);
+    }
+    
+    /// Find the root of an element and its parity relative to the root, and
+    /// point it and everything on the way straight at the root.
+    pair<size_t, bool> find_compress(size_t i) {
+        auto root = find(i);
+        bool relative = root.second;
+        while (parent[i] != root.first) {
+            size_t next = parent[i];
+            bool next_relative = relative ^ parity[i];
+            parent[i] = root.first;
+            parity[i] = relative;
+            i = next;
+            relative = next_relative;
+        }
+        return root;
+    }
+    
+    /// Require that two elements have the given relative parity. Returns false
+    /// if they are already known to have the other one.
+    bool unite(size_t a, size_t b, bool relative) {
+        auto root_a = find_compress(a);
+        auto root_b = find_compress(b);
+        bool root_relative = root_a.second ^ root_b.second ^ relative;
+        if (root_a.first == root_b.first) {
+            return !root_relative;
+        }
+        if (rank[root_a.first] < rank[root_b.first]) {
+            swap(root_a, root_b);
+        }
+        parent[root_b.first] = root_a.first;
+        parity[root_b.first] = root_relative;
+        if (rank[root_a.first] == rank[root_b.first]) {
+            rank[root_a.first]++;
+        }
+        return true;
+    }
+};
+
+vector<bool> single_stranded_flips(const HandleGraph* graph, const ExecutionOptions& execution) {
+    
+    if (graph->get_node_count() == 0) {
+        return vector<bool>();
+    }
+    nid_t min_id = graph->min_node_id();
+    size_t width = graph->max_node_id() - min_id + 1;
+    size_t block_count = (width + NODE_BLOCK_SIZE - 1) / NODE_BLOCK_SIZE;
+    
+    // Collect the constraints from the edges in parallel. Each edge says
+    // whether its ends need to be flipped the same way or opposite ways.
+    struct Constraint {
+        size_t a;
+        size_t b;
+        bool opposite;
+    };
+    vector<vector<Constraint>> block_constraints(block_count);
+    execution.parallel_for(block_count, [&](size_t block) {
+        auto& constraints = block_constraints[block];
+        size_t block_end = min(width, (block + 1) * NODE_BLOCK_SIZE);
+        for (size_t index = block * NODE_BLOCK_SIZE; index < block_end; index++) {
+            nid_t node_id = min_id + index;
+            if (!graph->has_node(node_id)) {
+                continue;
+            }
+            handle_t handle = graph->get_handle(node_id);
+            // Take each edge once, from its lowest ID node, as in for_each_edge()
+            graph->follow_edges(handle, false, [&](const handle_t& next) {
+                if (node_id <= graph->get_id(next)) {
+                    constraints.push_back({index, (size_t) (graph->get_id(next) - min_id), graph->get_is_reverse(next)});
+                }
+            });
+            graph->follow_edges(handle, true, [&](const handle_t& prev) {
+                if (node_id < graph->get_id(prev) || (node_id == graph->get_id(prev) && graph->get_is_reverse(prev))) {
+                    constraints.push_back({index, (size_t) (graph->get_id(prev) - min_id), graph->get_is_reverse(prev)});
+                }
+            });
+        }
+    });
+    
+    // Solve them
+    ParityUnionFind components(width);
+    for (auto& constraints : block_constraints) {
+        for (auto& constraint : constraints) {
+            if (!components.unite(constraint.a, constraint.b, constraint.opposite)) {
+                // A cycle needs a node flipped both ways
+                return vector<bool>();
+            }
+        }
+        constraints.clear();
+        constraints.shrink_to_fit();
+    }
+    
+    // Read off the flips, leaving each component's root as it is
+    vector<bool> flips(width, false);
+    execution.parallel_for(block_count, [&](size_t block) {
+        size_t block_end = min(width, (block + 1) * NODE_BLOCK_SIZE);
+        for (size_t index = block * NODE_BLOCK_SIZE; index < block_end; index++) {
+            flips[index] = components.find(index).second;
+        }
+    });
+    
+    return flips;
+}
 
 unordered_set<nid_t> make_single_stranded(MutableHandleGraph* graph) {
     
@@ -0,0 +1,228 @@
+#include "handlegraph/overlays/masked_overlay.hpp"
+
+#include <stdexcept>
+
+/** \file masked_overlay.cpp
+ * Implement the masked overlay.
+ */
+
+namespace handlegraph {
+
+MaskedOverlay::MaskedOverlay(const HandleGraph* graph) : graph(graph),
+    vectorizable(dynamic_cast<const VectorizableHandleGraph*>(graph)), min_id(0),
+    masked_node_count(0), masked_edge_count(0), masked_length(0) {
+
+    if (graph->get_node_count() != 0) {
+        min_id = graph->min_node_id();
+        masked_nodes.resize(graph->max_node_id() - min_id + 1, false);
+    }
+    if (vectorizable) {
+        masked_edge_indexes.resize(graph->get_edge_count() + 1, false);
+    }
+}
+
+void MaskedOverlay::mask_edge(const handle_t& left, const handle_t& right) {
+    mask_edge(edge_t(left, right));
+}
+
+void MaskedOverlay::mask_edge(const edge_t& edge) {
+    if (!graph->has_edge(edge.first, edge.second)) {
+        throw std::runtime_error("error:[MaskedOverlay] cannot mask missing edge from " +
+                                 std::to_string(graph->get_id(edge.first)) + (graph->get_is_reverse(edge.first) ? "-" : "+") + " to " +
+                                 std::to_string(graph->get_id(edge.second)) + (graph->get_is_reverse(edge.second) ? "-" : "+"));
+    }
+    edge_t canonical = graph->edge_handle(edge.first, edge.second);
+    if (vectorizable) {
+        size_t index = vectorizable->edge_index(canonical);
+        if (index >= masked_edge_indexes.size()) {
+            masked_edge_indexes.resize(index + 1, false);
+        }
+        if (!masked_edge_indexes[index]) {
+            masked_edge_indexes[index] = true;
+            masked_edge_count++;
+        }
+    } else if (masked_edges.insert(canonical).second) {
+        masked_edge_count++;
+    }
+}
+
+void MaskedOverlay::unmask_edge(const edge_t& edge) {
+    if (masked_edge_count == 0 || !graph->has_edge(edge.first, edge.second)) {
+        // It can't be masked
+        return;
+    }
+    edge_t canonical = graph->edge_handle(edge.first, edge.second);
+    if (vectorizable) {
+        size_t index = vectorizable->edge_index(canonical);
+        if (index < masked_edge_indexes.size() && masked_edge_indexes[index]) {
+            masked_edge_indexes[index] = false;
+            masked_edge_count--;
+        }
+    } else if (masked_edges.erase(canonical)) {
+        masked_edge_count--;
+    }
+}
+
+void MaskedOverlay::mask_node(nid_t node_id) {
+    if (!graph->has_node(node_id)) {
+        throw std::runtime_error("error:[MaskedOverlay] cannot mask missing node " + std::to_string(node_id));
+    }
+    if (!masked_nodes.at(node_id - min_id)) {
+        masked_nodes[node_id - min_id] = true;
+        masked_node_count++;
+        masked_length += graph->get_length(graph->get_handle(node_id));
+    }
+}
+
+void MaskedOverlay::unmask_node(nid_t node_id) {
+    if (is_masked(node_id)) {
+        masked_nodes[node_id - min_id] = false;
+        masked_node_count--;
+        masked_length -= graph->get_length(graph->get_handle(node_id));
+    }
+}
+
+bool MaskedOverlay::is_masked(const edge_t& edge) const {
+    return masked_edge_count != 0 && graph->has_edge(edge.first, edge.second) &&
+        is_masked_canonical(graph->edge_handle(edge.first, edge.second));
+}
+
+bool MaskedOverlay::is_masked_canonical(const edge_t& edge) const {
+    if (vectorizable) {
+        size_t index = vectorizable->edge_index(edge);
+        return index < masked_edge_indexes.size() && masked_edge_indexes[index];
+    }
+    return masked_edges.count(edge);
+}
+
+bool MaskedOverlay::is_masked(nid_t node_id) const {
+    size_t index = node_id - min_id;
+    return index < masked_nodes.size() && masked_nodes[index];
+}
+
+void MaskedOverlay::clear_masks() {
+    masked_nodes.assign(masked_nodes.size(), false);
+    masked_edge_indexes.assign(masked_edge_indexes.size(), false);
+    masked_edges.clear();
+    masked_node_count = 0;
+    masked_edge_count = 0;
+    masked_length = 0;
+}
+
+bool MaskedOverlay::has_node(nid_t node_id) const {
+    return graph->has_node(node_id) && !is_masked(node_id);
+}
+
+handle_t MaskedOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return graph->get_handle(node_id, is_reverse);
+}
+
+nid_t MaskedOverlay::get_id(const handle_t& handle) const {
+    return graph->get_id(handle);
+}
+
+bool MaskedOverlay::get_is_reverse(const handle_t& handle) const {
+    return graph->get_is_reverse(handle);
+}
+
+handle_t MaskedOverlay::flip(const handle_t& handle) const {
+    return graph->flip(handle);
+}
+
+size_t MaskedOverlay::get_length(const handle_t& handle) const {
+    return graph->get_length(handle);
+}
+
+std::string MaskedOverlay::get_sequence(const handle_t& handle) const {
+    return graph->get_sequence(handle);
+}
+
+size_t MaskedOverlay::get_node_count() const {
+    return graph->get_node_count() - masked_node_count;
+}
+
+nid_t MaskedOverlay::min_node_id() const {
+    return graph->min_node_id();
+}
+
+nid_t MaskedOverlay::max_node_id() const {
+    return graph->max_node_id();
+}
+
+bool MaskedOverlay::has_edge(const handle_t& left, const handle_t& right) const {
+    return !is_masked(graph->get_id(left)) && !is_masked(graph->get_id(right))
+        && !is_masked(edge_t(left, right)) && graph->has_edge(left, right);
+}
+
+size_t MaskedOverlay::get_edge_count() const {
+    if (masked_node_count == 0) {
+        return graph->get_edge_count() - masked_edge_count;
+    }
+
+    // Find the edges hidden by masked nodes that aren't also masked by
+    // themselves.
+    std::unordered_set<edge_t> node_edges;
+    for (size_t index = 0; index < masked_nodes.size(); index++) {
+        if (!masked_nodes[index]) {
+            continue;
+        }
+        handle_t handle = graph->get_handle(min_id + index);
+        for (bool go_left : {false, true}) {
+            graph->follow_edges(handle, go_left, [&](const handle_t& other) {
+                edge_t edge = go_left ? graph->edge_handle(other, handle) : graph->edge_handle(handle, other);
+                if (masked_edge_count == 0 || !is_masked_canonical(edge)) {
+                    node_edges.insert(edge);
+                }
+            });
+        }
+    }
+    return graph->get_edge_count() - masked_edge_count - node_edges.size();
+}
+
+size_t MaskedOverlay::get_total_length() const {
+    return graph->get_total_length() - masked_length;
+}
+
+char MaskedOverlay::get_base(const handle_t& handle, size_t index) const {
+    return graph->get_base(handle, index);
+}
+
+std::string MaskedOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    return graph->get_subsequence(handle, index, size);
+}
+
+size_t MaskedOverlay::copy_sequence(const handle_t& handle, char* dest) const {
+    return graph->copy_sequence(handle, dest);
+}
+
+handle_t MaskedOverlay::get_underlying_handle(const handle_t& handle) const {
+    return handle;
+}
+
+bool MaskedOverlay::follow_edges_impl(const handle_t& handle, bool go_left,
+                                      const std::function<bool(const handle_t&)>& iteratee) const {
+    if (masked_node_count == 0 && masked_edge_count == 0) {
+        return graph->follow_edges(handle, go_left, iteratee);
+    }
+    return graph->follow_edges(handle, go_left, [&](const handle_t& other) {
+        if (is_masked(graph->get_id(other))) {
+            return true;
+        }
+        if (masked_edge_count != 0
+            && is_masked_canonical(go_left ? graph->edge_handle(other, handle) : graph->edge_handle(handle, other))) {
+            return true;
+        }
+        return iteratee(other);
+    });
+}
+
+bool MaskedOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    if (masked_node_count == 0) {
+        return graph->for_each_handle(iteratee, parallel);
+    }
+    return graph->for_each_handle([&](const handle_t& handle) {
+        return is_masked(graph->get_id(handle)) || iteratee(handle);
+    }, parallel);
+}
+
+}
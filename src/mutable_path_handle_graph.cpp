@@ -1,15 +1,70 @@
 #include "handlegraph/mutable_path_handle_graph.hpp"
 
+#include <algorithm>
+
 /** \file mutable_path_handle_graph.cpp
  * Implement MutablePathHandleGraph methods
  */
 
 namespace handlegraph {
 
+/// Sort and deduplicate a list of node IDs.
+static void sort_unique(std::vector<nid_t>& ids) {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
 void MutablePathHandleGraph::destroy_paths(const std::vector<path_handle_t>& paths) {
+    if (!wants_path_edit_batch()) {
+        // Nobody needs the affected nodes, so don't go looking for them
+        for (const auto& path : paths) {
+            destroy_path(path);
+        }
+        return;
+    }
+    
+    std::vector<nid_t> affected_nodes;
+    for (const auto& path : paths) {
+        for_each_handle_in_path(path, [&](const handle_t& handle) {
+            affected_nodes.push_back(get_id(handle));
+        });
+    }
+    sort_unique(affected_nodes);
+    
+    begin_path_edit_batch(affected_nodes);
     for (const auto& path : paths) {
         destroy_path(path);
     }
+    end_path_edit_batch(affected_nodes);
+}
+
+std::vector<std::pair<step_handle_t, step_handle_t>> MutablePathHandleGraph::rewrite_segments(const std::vector<PathSegmentRewrite>& rewrites) {
+    std::vector<std::pair<step_handle_t, step_handle_t>> new_ranges;
+    new_ranges.reserve(rewrites.size());
+    if (!wants_path_edit_batch()) {
+        for (const auto& rewrite : rewrites) {
+            new_ranges.push_back(rewrite_segment(rewrite.segment_begin, rewrite.segment_end, rewrite.new_segment));
+        }
+        return new_ranges;
+    }
+    
+    std::vector<nid_t> affected_nodes;
+    for (const auto& rewrite : rewrites) {
+        for (step_handle_t here = rewrite.segment_begin; here != rewrite.segment_end; here = get_next_step(here)) {
+            affected_nodes.push_back(get_id(get_handle_of_step(here)));
+        }
+        for (const auto& handle : rewrite.new_segment) {
+            affected_nodes.push_back(get_id(handle));
+        }
+    }
+    sort_unique(affected_nodes);
+    
+    begin_path_edit_batch(affected_nodes);
+    for (const auto& rewrite : rewrites) {
+        new_ranges.push_back(rewrite_segment(rewrite.segment_begin, rewrite.segment_end, rewrite.new_segment));
+    }
+    end_path_edit_batch(affected_nodes);
+    return new_ranges;
 }
 
 void MutablePathHandleGraph::pop_front_step(const path_handle_t& path_handle) {
@@ -39,6 +94,18 @@ path_handle_t MutablePathHandleGraph::rename_path(const path_handle_t& path_hand
     return renamed;
 }
 
+bool MutablePathHandleGraph::wants_path_edit_batch() const {
+    return false;
+}
+
+void MutablePathHandleGraph::begin_path_edit_batch(const std::vector<nid_t>&) {
+    // Nothing to do
+}
+
+void MutablePathHandleGraph::end_path_edit_batch(const std::vector<nid_t>&) {
+    // Nothing to do
+}
+
 }
 
 
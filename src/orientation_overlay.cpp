@@ -0,0 +1,112 @@
+#include "handlegraph/overlays/orientation_overlay.hpp"
+
+/** \file orientation_overlay.cpp
+ * Implement the orientation overlay.
+ */
+
+namespace handlegraph {
+
+OrientationOverlay::OrientationOverlay(const HandleGraph* graph, const std::vector<handle_t>& orientations) :
+    graph(graph), min_id(0) {
+    
+    if (graph->get_node_count() == 0) {
+        return;
+    }
+    min_id = graph->min_node_id();
+    flips.resize(graph->max_node_id() - min_id + 1, false);
+    for (const handle_t& orientation : orientations) {
+        if (graph->get_is_reverse(orientation)) {
+            flips.at(graph->get_id(orientation) - min_id) = true;
+        }
+    }
+}
+
+OrientationOverlay::OrientationOverlay(const HandleGraph* graph, std::vector<bool> flips) :
+    graph(graph), min_id(graph->get_node_count() == 0 ? 0 : graph->min_node_id()), flips(std::move(flips)) {
+    // Nothing to do
+}
+
+bool OrientationOverlay::has_node(nid_t node_id) const {
+    return graph->has_node(node_id);
+}
+
+handle_t OrientationOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return graph->get_handle(node_id, is_reverse != is_flipped(node_id));
+}
+
+nid_t OrientationOverlay::get_id(const handle_t& handle) const {
+    return graph->get_id(handle);
+}
+
+bool OrientationOverlay::get_is_reverse(const handle_t& handle) const {
+    return graph->get_is_reverse(handle) != is_flipped(graph->get_id(handle));
+}
+
+handle_t OrientationOverlay::flip(const handle_t& handle) const {
+    return graph->flip(handle);
+}
+
+size_t OrientationOverlay::get_length(const handle_t& handle) const {
+    return graph->get_length(handle);
+}
+
+std::string OrientationOverlay::get_sequence(const handle_t& handle) const {
+    return graph->get_sequence(handle);
+}
+
+size_t OrientationOverlay::get_node_count() const {
+    return graph->get_node_count();
+}
+
+nid_t OrientationOverlay::min_node_id() const {
+    return graph->min_node_id();
+}
+
+nid_t OrientationOverlay::max_node_id() const {
+    return graph->max_node_id();
+}
+
+size_t OrientationOverlay::get_degree(const handle_t& handle, bool go_left) const {
+    return graph->get_degree(handle, go_left);
+}
+
+bool OrientationOverlay::has_edge(const handle_t& left, const handle_t& right) const {
+    return graph->has_edge(left, right);
+}
+
+size_t OrientationOverlay::get_edge_count() const {
+    return graph->get_edge_count();
+}
+
+size_t OrientationOverlay::get_total_length() const {
+    return graph->get_total_length();
+}
+
+char OrientationOverlay::get_base(const handle_t& handle, size_t index) const {
+    return graph->get_base(handle, index);
+}
+
+std::string OrientationOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    return graph->get_subsequence(handle, index, size);
+}
+
+size_t OrientationOverlay::copy_sequence(const handle_t& handle, char* dest) const {
+    return graph->copy_sequence(handle, dest);
+}
+
+handle_t OrientationOverlay::get_underlying_handle(const handle_t& handle) const {
+    return handle;
+}
+
+bool OrientationOverlay::follow_edges_impl(const handle_t& handle, bool go_left,
+                                           const std::function<bool(const handle_t&)>& iteratee) const {
+    return graph->follow_edges(handle, go_left, iteratee);
+}
+
+bool OrientationOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    return graph->for_each_handle([&](const handle_t& handle) {
+        return iteratee(is_flipped(graph->get_id(handle)) ? graph->flip(handle) : handle);
+    }, parallel);
+}
+
+}
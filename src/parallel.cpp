@@ -0,0 +1,21 @@
+#include "handlegraph/algorithms/internal/parallel.hpp"
+#include "handlegraph/execution.hpp"
+
+#include <thread>
+#include <algorithm>
+
+namespace handlegraph {
+namespace algorithms {
+namespace internal {
+
+size_t default_thread_count() {
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+void parallel_for(size_t count, size_t thread_count, const std::function<void(size_t)>& body) {
+    ExecutionOptions(thread_count).parallel_for(count, body);
+}
+
+}
+}
+}
@@ -0,0 +1,154 @@
+#include "handlegraph/algorithms/path_depth.hpp"
+#include "handlegraph/algorithms/for_each_path_range.hpp"
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+
+namespace handlegraph {
+namespace algorithms {
+
+using namespace std;
+
+uint64_t PathDepth::get_depth(nid_t node_id, size_t group) const {
+    if (node_id < min_id || group >= depth.size() || node_id - min_id >= (nid_t) depth[group].size()) {
+        return 0;
+    }
+    return depth[group][node_id - min_id];
+}
+
+uint64_t PathDepth::get_total_depth(nid_t node_id) const {
+    uint64_t total = 0;
+    for (size_t i = 0; i < depth.size(); i++) {
+        total += get_depth(node_id, i);
+    }
+    return total;
+}
+
+/// All the senses, in enum order.
+static const PathSense ALL_SENSES[] = {PathSense::GENERIC, PathSense::REFERENCE, PathSense::HAPLOTYPE};
+
+/// Number of node IDs handed to a thread at a time when visiting nodes.
+static const size_t NODE_BLOCK_SIZE = 4096;
+
+PathDepth compute_path_depth(const PathHandleGraph* graph,
+                             PathDepthGrouping grouping,
+                             const ExecutionOptions& execution,
+                             PathDepthStrategy strategy) {
+    
+    PathDepth result;
+    if (graph->get_node_count() == 0) {
+        return result;
+    }
+    result.min_id = graph->min_node_id();
+    size_t width = graph->max_node_id() - result.min_id + 1;
+    
+    // Find the paths and assign them to groups
+    vector<path_handle_t> paths;
+    vector<size_t> path_groups;
+    unordered_map<path_handle_t, size_t> group_of_path;
+    unordered_map<string, size_t> sample_groups;
+    size_t total_steps = 0;
+    if (grouping == PathDepthGrouping::NONE) {
+        result.group_names.push_back("");
+    } else if (grouping == PathDepthGrouping::BY_SENSE) {
+        result.group_names = {"generic", "reference", "haplotype"};
+    }
+    for (auto& sense : ALL_SENSES) {
+        graph->for_each_path_of_sense(sense, [&](const path_handle_t& path) {
+            size_t group = 0;
+            if (grouping == PathDepthGrouping::BY_SENSE) {
+                group = (size_t) sense;
+            } else if (grouping == PathDepthGrouping::BY_SAMPLE) {
+                string sample = graph->get_sample_name(path);
+                auto found = sample_groups.find(sample);
+                if (found == sample_groups.end()) {
+                    found = sample_groups.emplace(sample, result.group_names.size()).first;
+                    result.group_names.push_back(sample);
+                }
+                group = found->second;
+            }
+            paths.push_back(path);
+            path_groups.push_back(group);
+            group_of_path[path] = group;
+            total_steps += graph->get_step_count(path);
+        });
+    }
+    size_t group_count = result.group_names.size();
+    
+    if (strategy == PathDepthStrategy::AUTOMATIC) {
+        // Walking paths streams steps in blocks but pays for an atomic
+        // increment on each one. Visiting nodes needs no synchronization,
+        // but pays a per-sense lookup on each node, which only pays off when
+        // nodes are visited by many steps each.
+        size_t path_major_cost = 2 * total_steps;
+        size_t node_major_cost = 3 * graph->get_node_count() + total_steps;
+        strategy = node_major_cost < path_major_cost ? PathDepthStrategy::NODE_MAJOR : PathDepthStrategy::PATH_MAJOR;
+    }
+    
+    if (strategy == PathDepthStrategy::NODE_MAJOR) {
+        result.depth.assign(group_count, vector<uint64_t>(width, 0));
+        // Each node is only ever touched by one thread, so we don't need any
+        // atomics. We go through blocks of IDs so we can control the thread
+        // count ourselves.
+        size_t block_count = (width + NODE_BLOCK_SIZE - 1) / NODE_BLOCK_SIZE;
+        execution.parallel_for(block_count, [&](size_t block) {
+            size_t block_end = min(width, (block + 1) * NODE_BLOCK_SIZE);
+            for (size_t index = block * NODE_BLOCK_SIZE; index < block_end; index++) {
+                nid_t node_id = result.min_id + index;
+                if (!graph->has_node(node_id)) {
+                    continue;
+                }
+                handle_t handle = graph->get_handle(node_id);
+                for (auto& sense : ALL_SENSES) {
+                    graph->for_each_step_of_sense(handle, sense, [&](const step_handle_t& step) {
+                        size_t group = 0;
+                        if (grouping == PathDepthGrouping::BY_SENSE) {
+                            group = (size_t) sense;
+                        } else if (grouping == PathDepthGrouping::BY_SAMPLE) {
+                            group = group_of_path.at(graph->get_path_handle_of_step(step));
+                        }
+                        result.depth[group][index]++;
+                    });
+                }
+            }
+        });
+    } else {
+        unordered_map<path_handle_t, size_t> path_index;
+        for (size_t i = 0; i < paths.size(); i++) {
+            path_index.emplace(paths[i], i);
+        }
+        
+        vector<unique_ptr<atomic<uint64_t>[]>> counts;
+        for (size_t i = 0; i < group_count; i++) {
+            counts.emplace_back(new atomic<uint64_t>[width]);
+            for (size_t j = 0; j < width; j++) {
+                counts.back()[j].store(0, memory_order_relaxed);
+            }
+        }
+        
+        for_each_path_range_parallel(graph, paths, [&](const path_handle_t& path, const step_handle_t&,
+                                                       const handle_t* handles, size_t count) {
+            atomic<uint64_t>* group_counts = counts[path_groups[path_index.at(path)]].get();
+            for (size_t i = 0; i < count; i++) {
+                group_counts[graph->get_id(handles[i]) - result.min_id].fetch_add(1, memory_order_relaxed);
+            }
+        }, DEFAULT_PATH_RANGE_LENGTH, execution);
+        
+        result.depth.resize(group_count);
+        for (size_t i = 0; i < group_count; i++) {
+            result.depth[i].resize(width);
+            for (size_t j = 0; j < width; j++) {
+                result.depth[i][j] = counts[i][j].load(memory_order_relaxed);
+            }
+            // Free up the atomics as we go
+            counts[i].reset();
+        }
+    }
+    
+    return result;
+}
+
+}
+}
@@ -1,6 +1,8 @@
 #include "handlegraph/path_handle_graph.hpp"
 
 #include <vector>
+#include <unordered_set>
+#include <algorithm>
 
 /** \file path_handle_graph.cpp
  * Implement PathHandleGraph and associated utilities' methods
@@ -36,10 +38,153 @@ bool PathHandleGraph::is_empty(const path_handle_t& path_handle) const {
     // But some implementations may have an expensive length query and a cheaper emptiness one
     return get_step_count(path_handle) == 0;
 }
+
+const size_t PathHandleGraph::STEP_BLOCK_SIZE;
+
+size_t PathHandleGraph::get_step_handles(const path_handle_t& path, step_handle_t& step,
+                                         handle_t* buffer, size_t max_steps) const {
+    step_handle_t end = path_end(path);
+    if (step == end || max_steps == 0) {
+        return 0;
+    }
+    // Paths are nonempty here, so there is a last step to stop after
+    step_handle_t back = path_back(path);
+    size_t count = 0;
+    while (count < max_steps) {
+        buffer[count++] = get_handle_of_step(step);
+        if (step == back) {
+            // Don't loop around circular paths
+            step = end;
+            break;
+        }
+        step = get_next_step(step);
+    }
+    return count;
+}
+
+size_t PathHandleGraph::get_next_steps_on_handle(const handle_t& handle, uint64_t& cursor,
+                                                 step_handle_t* buffer, size_t max_steps) const {
+    uint64_t seen = 0;
+    size_t count = 0;
+    if (max_steps != 0) {
+        for_each_step_on_handle(handle, [&](const step_handle_t& step) {
+            if (seen++ >= cursor) {
+                buffer[count++] = step;
+            }
+            return count < max_steps;
+        });
+    }
+    cursor += count;
+    return count;
+}
+    
+bool PathHandleGraph::for_each_path_interval_impl(const std::vector<std::pair<nid_t, nid_t>>& id_ranges,
+                                                  const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const {
+    if (id_ranges.empty() || get_node_count() == 0) {
+        return true;
+    }
+    nid_t min_id = min_node_id();
+    nid_t max_id = max_node_id();
+    
+    // Work out how many IDs we would have to probe
+    size_t probe_count = 0;
+    for (auto& range : id_ranges) {
+        nid_t first = std::max(range.first, min_id);
+        nid_t last = std::min(range.second, max_id);
+        if (first <= last) {
+            probe_count += last - first + 1;
+        }
+    }
+    
+    std::vector<step_handle_t> steps;
+    auto collect = [&](const handle_t& handle) {
+        for_each_step_on_handle(handle, [&](const step_handle_t& step) {
+            steps.push_back(step);
+        });
+    };
+    if (probe_count > get_node_count()) {
+        // It's cheaper to scan all the nodes and keep the ones in range
+        for_each_handle([&](const handle_t& handle) {
+            nid_t id = get_id(handle);
+            auto it = std::upper_bound(id_ranges.begin(), id_ranges.end(), id, [](nid_t id, const std::pair<nid_t, nid_t>& range) {
+                return id < range.first;
+            });
+            if (it != id_ranges.begin() && id <= (--it)->second) {
+                collect(handle);
+            }
+        });
+    } else {
+        for (auto& range : id_ranges) {
+            for (nid_t id = std::max(range.first, min_id); id <= std::min(range.second, max_id); id++) {
+                if (has_node(id)) {
+                    collect(get_handle(id));
+                }
+            }
+        }
+    }
     
+    return for_each_step_interval(steps, iteratee);
+}
+
+bool PathHandleGraph::for_each_step_interval(const std::vector<step_handle_t>& steps,
+                                             const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const {
+    std::unordered_set<step_handle_t> remaining(steps.begin(), steps.end());
+    for (auto& step : steps) {
+        if (!remaining.count(step)) {
+            // Already part of an interval
+            continue;
+        }
+        
+        // Extend back, and stop if we come around a circular path
+        step_handle_t first = step;
+        while (has_previous_step(first)) {
+            step_handle_t prev = get_previous_step(first);
+            if (prev == step || !remaining.count(prev)) {
+                break;
+            }
+            first = prev;
+        }
+        // Extend forward, likewise
+        step_handle_t last = step;
+        while (has_next_step(last)) {
+            step_handle_t next = get_next_step(last);
+            if (next == first || !remaining.count(next)) {
+                break;
+            }
+            last = next;
+        }
+        
+        for (step_handle_t here = first; ; here = get_next_step(here)) {
+            remaining.erase(here);
+            if (here == last) {
+                break;
+            }
+        }
+        
+        if (!iteratee(first, last)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 PathForEachSocket PathHandleGraph::scan_path(const path_handle_t& path) const {
     return PathForEachSocket(this, path);
 }
+
+Cursor<step_handle_t> PathHandleGraph::scan_steps_on_handle(const handle_t& handle) const {
+    if (has_efficient_cursors()) {
+        uint64_t cursor = 0;
+        return Cursor<step_handle_t>([this, handle, cursor](step_handle_t* buffer, size_t max_steps) mutable {
+            return get_next_steps_on_handle(handle, cursor, buffer, max_steps);
+        });
+    }
+    std::vector<step_handle_t> steps;
+    for_each_step_on_handle(handle, [&](const step_handle_t& step) {
+        steps.push_back(step);
+    });
+    return Cursor<step_handle_t>(std::move(steps));
+}
     
 PathForEachSocket::PathForEachSocket(const PathHandleGraph* graph, const path_handle_t& path) : graph(graph), path(path) {
     
@@ -0,0 +1,190 @@
+#include "handlegraph/algorithms/path_intervals.hpp"
+#include "handlegraph/path_position_handle_graph.hpp"
+#include "handlegraph/util.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace handlegraph {
+namespace algorithms {
+
+using namespace std;
+
+PathIntervalIndex::PathIntervalIndex(const PathHandleGraph* graph, const ExecutionOptions& execution) : graph(graph) {
+    
+    vector<path_handle_t> paths;
+    graph->for_each_path_handle([&](const path_handle_t& path) {
+        paths.push_back(path);
+    });
+    
+    // Collect each path's steps
+    vector<vector<pair<nid_t, step_handle_t>>> path_entries(paths.size());
+    execution.parallel_for(paths.size(), [&](size_t i) {
+        auto& entries = path_entries[i];
+        entries.reserve(graph->get_step_count(paths[i]));
+        graph->for_each_step_in_path(paths[i], [&](const step_handle_t& step) {
+            entries.emplace_back(graph->get_id(graph->get_handle_of_step(step)), step);
+        });
+    });
+    
+    vector<pair<nid_t, step_handle_t>> entries;
+    for (auto& path_entry_list : path_entries) {
+        entries.insert(entries.end(), path_entry_list.begin(), path_entry_list.end());
+        path_entry_list.clear();
+        path_entry_list.shrink_to_fit();
+    }
+    stable_sort(entries.begin(), entries.end(), [](const pair<nid_t, step_handle_t>& a, const pair<nid_t, step_handle_t>& b) {
+        return a.first < b.first;
+    });
+    
+    step_ids.reserve(entries.size());
+    steps.reserve(entries.size());
+    for (auto& entry : entries) {
+        step_ids.push_back(entry.first);
+        steps.push_back(entry.second);
+    }
+}
+
+bool PathIntervalIndex::for_each_path_interval(const vector<pair<nid_t, nid_t>>& id_ranges,
+                                               const function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const {
+    vector<step_handle_t> found;
+    for (auto& range : id_ranges) {
+        auto begin = lower_bound(step_ids.begin(), step_ids.end(), range.first);
+        auto end = upper_bound(begin, step_ids.end(), range.second);
+        found.insert(found.end(), steps.begin() + (begin - step_ids.begin()), steps.begin() + (end - step_ids.begin()));
+    }
+    return graph->for_each_step_interval(found, iteratee);
+}
+
+vector<pair<nid_t, nid_t>> node_ids_to_ranges(vector<nid_t> node_ids) {
+    sort(node_ids.begin(), node_ids.end());
+    vector<pair<nid_t, nid_t>> ranges;
+    for (auto& id : node_ids) {
+        if (!ranges.empty() && id <= ranges.back().second + 1) {
+            ranges.back().second = max(ranges.back().second, id);
+        } else {
+            ranges.emplace_back(id, id);
+        }
+    }
+    return ranges;
+}
+
+vector<PathInterval> find_path_intervals(const PathHandleGraph* graph,
+                                         const vector<pair<nid_t, nid_t>>& id_ranges,
+                                         bool include_positions,
+                                         const PathIntervalIndex* index) {
+    
+    const PathPositionHandleGraph* position_graph = nullptr;
+    if (include_positions) {
+        position_graph = dynamic_cast<const PathPositionHandleGraph*>(graph);
+        if (position_graph == nullptr) {
+            throw runtime_error("Cannot find positions of path intervals in a graph without path positions");
+        }
+    }
+    
+    vector<PathInterval> intervals;
+    auto add_interval = [&](const step_handle_t& first, const step_handle_t& last) {
+        intervals.emplace_back();
+        auto& interval = intervals.back();
+        interval.path = graph->get_path_handle_of_step(first);
+        interval.first = first;
+        interval.last = last;
+        if (position_graph) {
+            interval.start_position = position_graph->get_position_of_step(first);
+            interval.end_position = position_graph->get_position_of_step(last) +
+                                    graph->get_length(graph->get_handle_of_step(last));
+        }
+        return true;
+    };
+    if (index) {
+        index->for_each_path_interval(id_ranges, add_interval);
+    } else {
+        graph->for_each_path_interval(id_ranges, add_interval);
+    }
+    
+    if (position_graph) {
+        sort(intervals.begin(), intervals.end(), [](const PathInterval& a, const PathInterval& b) {
+            return a.path < b.path || (a.path == b.path && a.start_position < b.start_position);
+        });
+    } else {
+        // Find the order of the intervals along each path by walking forward
+        // from the last step of each interval to the first step of the next.
+        // The walks on a path advance together and stop once all but one
+        // have found the next interval, so the walking is bounded by the gaps
+        // between intervals, not by the length of the path.
+        unordered_map<step_handle_t, size_t> interval_of_first;
+        unordered_map<path_handle_t, vector<size_t>> intervals_on_path;
+        for (size_t i = 0; i < intervals.size(); i++) {
+            interval_of_first[intervals[i].first] = i;
+            intervals_on_path[intervals[i].path].push_back(i);
+        }
+        vector<size_t> rank(intervals.size(), 0);
+        vector<size_t> next_interval(intervals.size(), numeric_limits<size_t>::max());
+        vector<bool> has_previous(intervals.size(), false);
+        for (auto& path_intervals : intervals_on_path) {
+            auto& on_path = path_intervals.second;
+            if (on_path.size() == 1) {
+                continue;
+            }
+            // Each walk is an interval and where it has got to
+            vector<pair<size_t, step_handle_t>> walks;
+            for (auto& i : on_path) {
+                walks.emplace_back(i, intervals[i].last);
+            }
+            size_t linked = 0;
+            while (linked + 1 < on_path.size() && !walks.empty()) {
+                for (size_t j = 0; j < walks.size() && linked + 1 < on_path.size();) {
+                    auto& walk = walks[j];
+                    bool done = true;
+                    if (graph->has_next_step(walk.second)) {
+                        walk.second = graph->get_next_step(walk.second);
+                        auto found = interval_of_first.find(walk.second);
+                        if (found != interval_of_first.end()) {
+                            next_interval[walk.first] = found->second;
+                            has_previous[found->second] = true;
+                            linked++;
+                        } else {
+                            done = false;
+                        }
+                    }
+                    if (done) {
+                        walks[j] = walks.back();
+                        walks.pop_back();
+                    } else {
+                        j++;
+                    }
+                }
+            }
+            // Number the intervals along the chain from the one nothing leads to
+            for (auto& i : on_path) {
+                if (!has_previous[i]) {
+                    size_t next_rank = 0;
+                    for (size_t here = i; here != numeric_limits<size_t>::max(); here = next_interval[here]) {
+                        rank[here] = next_rank++;
+                    }
+                    break;
+                }
+            }
+        }
+        vector<size_t> order(intervals.size());
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return intervals[a].path < intervals[b].path ||
+                   (intervals[a].path == intervals[b].path && rank[a] < rank[b]);
+        });
+        vector<PathInterval> sorted;
+        sorted.reserve(intervals.size());
+        for (auto& i : order) {
+            sorted.push_back(intervals[i]);
+        }
+        intervals = move(sorted);
+    }
+    
+    return intervals;
+}
+
+}
+}
@@ -0,0 +1,229 @@
+#include "handlegraph/algorithms/path_sequences.hpp"
+#include "handlegraph/algorithms/for_each_path_range.hpp"
+#include "handlegraph/path_position_handle_graph.hpp"
+
+#include <unordered_map>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace handlegraph {
+namespace algorithms {
+
+using namespace std;
+
+vector<size_t> get_path_lengths(const PathHandleGraph* graph,
+                                const vector<path_handle_t>& paths,
+                                const ExecutionOptions& execution) {
+    
+    vector<size_t> lengths(paths.size(), 0);
+    auto position_graph = dynamic_cast<const PathPositionHandleGraph*>(graph);
+    execution.parallel_for(paths.size(), [&](size_t i) {
+        if (position_graph) {
+            lengths[i] = position_graph->get_path_length(paths[i]);
+        } else {
+            size_t length = 0;
+            graph->for_each_handle_in_path(paths[i], [&](const handle_t& handle) {
+                length += graph->get_length(handle);
+            });
+            lengths[i] = length;
+        }
+    });
+    return lengths;
+}
+
+/// Call the iteratee, in parallel, with the index of the path, the offset in
+/// the path's sequence, and the handles, for runs of steps covering all the
+/// given paths.
+static void for_each_path_run(const PathHandleGraph* graph,
+                              const vector<path_handle_t>& paths,
+                              const function<void(size_t, size_t, const handle_t*, size_t)>& iteratee,
+                              const ExecutionOptions& execution) {
+    
+    unordered_map<path_handle_t, size_t> path_index;
+    path_index.reserve(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        path_index.emplace(paths[i], i);
+    }
+    
+    auto position_graph = dynamic_cast<const PathPositionHandleGraph*>(graph);
+    // Without positions, each path is done in order by one thread, so we can
+    // keep a running offset for it.
+    vector<size_t> next_offset(position_graph ? 0 : paths.size(), 0);
+    
+    for_each_path_range_parallel(graph, paths, [&](const path_handle_t& path, const step_handle_t& start,
+                                                   const handle_t* handles, size_t count) {
+        size_t i = path_index.at(path);
+        size_t offset;
+        if (position_graph) {
+            offset = position_graph->get_position_of_step(start);
+        } else {
+            offset = next_offset[i];
+            for (size_t j = 0; j < count; j++) {
+                next_offset[i] += graph->get_length(handles[j]);
+            }
+        }
+        iteratee(i, offset, handles, count);
+    }, DEFAULT_PATH_RANGE_LENGTH, execution);
+}
+
+void extract_path_sequences(const PathHandleGraph* graph,
+                            const vector<path_handle_t>& paths,
+                            const function<char*(const path_handle_t&, size_t)>& get_buffer,
+                            const ExecutionOptions& execution) {
+    
+    vector<size_t> lengths = get_path_lengths(graph, paths, execution);
+    
+    vector<path_handle_t> wanted;
+    vector<char*> buffers;
+    for (size_t i = 0; i < paths.size(); i++) {
+        char* buffer = get_buffer(paths[i], lengths[i]);
+        if (buffer != nullptr && lengths[i] != 0) {
+            wanted.push_back(paths[i]);
+            buffers.push_back(buffer);
+        }
+    }
+    
+    for_each_path_run(graph, wanted, [&](size_t i, size_t offset, const handle_t* handles, size_t count) {
+        char* dest = buffers[i] + offset;
+        for (size_t j = 0; j < count; j++) {
+            dest += graph->copy_sequence(handles[j], dest);
+        }
+    }, execution);
+}
+
+void extract_path_sequences(const PathHandleGraph* graph,
+                            const unordered_set<PathSense>* senses,
+                            const unordered_set<string>* samples,
+                            const unordered_set<string>* loci,
+                            const function<char*(const path_handle_t&, size_t)>& get_buffer,
+                            const ExecutionOptions& execution) {
+    
+    vector<path_handle_t> paths;
+    graph->for_each_path_matching(senses, samples, loci, [&](const path_handle_t& path) {
+        paths.push_back(path);
+    });
+    extract_path_sequences(graph, paths, get_buffer, execution);
+}
+
+/// Write all of the given data at the given offset in the file, or throw.
+static void pwrite_fully(int fd, const char* data, size_t length, size_t offset) {
+    while (length > 0) {
+        ssize_t written = pwrite(fd, data, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw runtime_error("Could not write FASTA: " + string(strerror(errno)));
+        }
+        data += written;
+        length -= written;
+        offset += written;
+    }
+}
+
+void write_path_fasta(const PathHandleGraph* graph,
+                      const vector<path_handle_t>& paths,
+                      int fd,
+                      size_t line_width,
+                      const ExecutionOptions& execution) {
+    
+    vector<size_t> lengths = get_path_lengths(graph, paths, execution);
+    
+    // Lay out the records and write the header lines
+    vector<size_t> sequence_starts(paths.size());
+    size_t file_length = 0;
+    string headers;
+    size_t headers_start = 0;
+    for (size_t i = 0; i < paths.size(); i++) {
+        string header = ">" + graph->get_path_name(paths[i]) + "\n";
+        if (file_length != headers_start + headers.size()) {
+            // Flush the previous run of adjacent headers
+            pwrite_fully(fd, headers.data(), headers.size(), headers_start);
+            headers.clear();
+            headers_start = file_length;
+        }
+        headers.append(header);
+        file_length += header.size();
+        sequence_starts[i] = file_length;
+        // Each line of sequence is followed by a newline
+        size_t line_count = line_width == 0 ? (lengths[i] != 0) : (lengths[i] + line_width - 1) / line_width;
+        file_length += lengths[i] + line_count;
+    }
+    pwrite_fully(fd, headers.data(), headers.size(), headers_start);
+    if (ftruncate(fd, file_length) != 0) {
+        throw runtime_error("Could not size FASTA: " + string(strerror(errno)));
+    }
+    
+    for_each_path_run(graph, paths, [&](size_t i, size_t offset, const handle_t* handles, size_t count) {
+        size_t run_length = 0;
+        for (size_t j = 0; j < count; j++) {
+            run_length += graph->get_length(handles[j]);
+        }
+        if (run_length == 0) {
+            return;
+        }
+        
+        // Spell the run, then insert line breaks working backward
+        string text(run_length + (line_width == 0 ? 1 : run_length / line_width + 2), '\n');
+        char* dest = &text[0];
+        for (size_t j = 0; j < count; j++) {
+            dest += graph->copy_sequence(handles[j], dest);
+        }
+        size_t end = offset + run_length;
+        size_t text_length = run_length;
+        if (line_width != 0) {
+            text_length += (end - 1) / line_width - offset / line_width;
+            // Spread out from the back so we never overwrite unmoved bases
+            size_t to = text_length;
+            for (size_t from = run_length; from > 0; from--) {
+                size_t position = offset + from - 1;
+                if ((position + 1) % line_width == 0 && position + 1 != end) {
+                    text[--to] = '\n';
+                }
+                text[--to] = text[from - 1];
+            }
+        }
+        if (end == lengths[i] || (line_width != 0 && end % line_width == 0)) {
+            // Finish the last line
+            text[text_length++] = '\n';
+        }
+        
+        size_t file_offset = sequence_starts[i] + offset + (line_width == 0 ? 0 : offset / line_width);
+        pwrite_fully(fd, text.data(), text_length, file_offset);
+    }, execution);
+}
+
+void write_path_fasta(const PathHandleGraph* graph,
+                      const unordered_set<PathSense>* senses,
+                      const unordered_set<string>* samples,
+                      const unordered_set<string>* loci,
+                      const string& filename,
+                      size_t line_width,
+                      const ExecutionOptions& execution) {
+    
+    vector<path_handle_t> paths;
+    graph->for_each_path_matching(senses, samples, loci, [&](const path_handle_t& path) {
+        paths.push_back(path);
+    });
+    
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        throw runtime_error("Could not open " + filename + " for writing: " + string(strerror(errno)));
+    }
+    try {
+        write_path_fasta(graph, paths, fd, line_width, execution);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    if (close(fd) != 0) {
+        throw runtime_error("Could not close " + filename + ": " + string(strerror(errno)));
+    }
+}
+
+}
+}
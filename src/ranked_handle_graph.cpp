@@ -20,6 +20,16 @@ handle_t RankedHandleGraph::rank_to_handle(const size_t& rank) const {
     return get_handle(rank_to_id((rank - 1)/2 + 1), rank % 2 == 0);
 }
 
+bool RankedHandleGraph::for_each_handle_in_range_impl(size_t begin_rank, size_t end_rank,
+                                                      const std::function<bool(const handle_t&)>& iteratee) const {
+    for (size_t rank = begin_rank; rank < end_rank; rank++) {
+        if (!iteratee(get_handle(rank_to_id(rank)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 }
 
 
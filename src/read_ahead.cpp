@@ -0,0 +1,206 @@
+#include "handlegraph/read_ahead.hpp"
+
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <string.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+/** \file read_ahead.cpp
+ * Implement the read-ahead stream buffer.
+ */
+
+namespace handlegraph {
+
+const size_t ReadAheadBuffer::DEFAULT_BUFFER_SIZE = 4 * 1024 * 1024;
+const size_t ReadAheadBuffer::PUTBACK_SIZE = 8;
+
+/// Alignment of the buffers, so they suit direct IO and page mapping
+static const size_t BUFFER_ALIGNMENT = 4096;
+
+ReadAheadBuffer::ReadAheadBuffer(int fd, size_t buffer_size) : source_fd(fd) {
+    start(buffer_size);
+}
+
+ReadAheadBuffer::ReadAheadBuffer(std::istream& in, size_t buffer_size) : source_stream(&in) {
+    start(buffer_size);
+}
+
+ReadAheadBuffer::~ReadAheadBuffer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    state_changed.notify_all();
+    if (reader.joinable()) {
+        reader.join();
+    }
+    for (auto& buffer : buffers) {
+        if (buffer != nullptr) {
+            std::free(buffer - (BUFFER_ALIGNMENT - PUTBACK_SIZE));
+        }
+    }
+}
+
+void ReadAheadBuffer::start(size_t buffer_size) {
+    this->buffer_size = std::max<size_t>(buffer_size, 1);
+    for (auto& buffer : buffers) {
+        // Put the putback area just in front of an aligned data area
+        void* allocated = nullptr;
+        if (posix_memalign(&allocated, BUFFER_ALIGNMENT, BUFFER_ALIGNMENT + this->buffer_size) != 0) {
+            throw std::bad_alloc();
+        }
+        buffer = (char*) allocated + BUFFER_ALIGNMENT - PUTBACK_SIZE;
+    }
+    // Nothing to read until the first underflow
+    setg(buffers[0] + PUTBACK_SIZE, buffers[0] + PUTBACK_SIZE, buffers[0] + PUTBACK_SIZE);
+    reader = std::thread(&ReadAheadBuffer::fill_buffers, this);
+}
+
+size_t ReadAheadBuffer::read_source(char* dest, size_t length) {
+    if (source_stream != nullptr) {
+        source_stream->read(dest, length);
+        if (source_stream->bad()) {
+            throw std::runtime_error("Could not read from input stream");
+        }
+        return source_stream->gcount();
+    }
+    
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                return 0;
+            }
+        }
+        // Wait for data to be available, so that we can notice being asked
+        // to stop while a pipe is idle.
+        struct pollfd waiting;
+        waiting.fd = source_fd;
+        waiting.events = POLLIN;
+        int polled = ::poll(&waiting, 1, 100);
+        if (polled == 0 || (polled == -1 && errno == EINTR)) {
+            continue;
+        }
+        auto result = ::read(source_fd, dest, length);
+        if (result == -1) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            auto problem = errno;
+            std::stringstream ss;
+            ss << "Could not read from file descriptor " << source_fd << ": " << ::strerror(problem);
+            throw std::runtime_error(ss.str());
+        }
+        return result;
+    }
+}
+
+void ReadAheadBuffer::fill_buffers() {
+    try {
+        for (size_t i = 0; ; i ^= 1) {
+            {
+                // Wait for the consumer to be done with this buffer
+                std::unique_lock<std::mutex> lock(mutex);
+                state_changed.wait(lock, [&]() { return stopping || !ready[i]; });
+                if (stopping) {
+                    break;
+                }
+            }
+            
+            // Fill the buffer outside the lock, in as few big chunks as the
+            // source allows.
+            char* data = buffers[i] + PUTBACK_SIZE;
+            size_t total = 0;
+            bool ended = false;
+            while (total < buffer_size) {
+                size_t got = read_source(data + total, buffer_size - total);
+                if (got == 0) {
+                    ended = true;
+                    break;
+                }
+                total += got;
+                if (consumer_waiting.load()) {
+                    // Hand over what we have rather than make the consumer
+                    // wait for a slow source to fill the whole buffer.
+                    break;
+                }
+            }
+            
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                filled[i] = total;
+                ready[i] = true;
+                source_done = ended;
+            }
+            state_changed.notify_all();
+            if (ended) {
+                break;
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+        source_done = true;
+    }
+    state_changed.notify_all();
+}
+
+ReadAheadBuffer::int_type ReadAheadBuffer::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    size_t next = holding ? consuming ^ 1 : 0;
+    consumer_waiting.store(true);
+    state_changed.wait(lock, [&]() { return ready[next] || source_done; });
+    consumer_waiting.store(false);
+    if (!ready[next] || filled[next] == 0) {
+        // Nothing more is coming. Keep the current buffer so putback still works.
+        return traits_type::eof();
+    }
+    
+    // Carry the end of the current buffer over as the putback area
+    char* start = buffers[next] + PUTBACK_SIZE;
+    size_t carried = 0;
+    if (holding) {
+        carried = std::min<size_t>(PUTBACK_SIZE, filled[consuming]);
+        std::memcpy(start - carried, buffers[consuming] + PUTBACK_SIZE + filled[consuming] - carried, carried);
+        // Let the reading thread refill the buffer we are leaving
+        ready[consuming] = false;
+    }
+    consuming = next;
+    holding = true;
+    lock.unlock();
+    state_changed.notify_all();
+    
+    setg(start - carried, start, start + filled[next]);
+    return traits_type::to_int_type(*gptr());
+}
+
+void ReadAheadBuffer::rethrow_error() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+ReadAheadStream::ReadAheadStream(int fd, size_t buffer_size) : std::istream(nullptr), buffer(fd, buffer_size) {
+    rdbuf(&buffer);
+}
+
+ReadAheadStream::ReadAheadStream(std::istream& in, size_t buffer_size) : std::istream(nullptr), buffer(in, buffer_size) {
+    rdbuf(&buffer);
+}
+
+void ReadAheadStream::rethrow_error() const {
+    buffer.rethrow_error();
+}
+
+}
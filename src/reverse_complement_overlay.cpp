@@ -0,0 +1,224 @@
+#include "handlegraph/overlays/reverse_complement_overlay.hpp"
+
+/** \file reverse_complement_overlay.cpp
+ * Implement the reverse complement overlays.
+ */
+
+namespace handlegraph {
+
+ReverseComplementOverlay::ReverseComplementOverlay(const HandleGraph* graph) : graph(graph) {
+    // Nothing to do
+}
+
+bool ReverseComplementOverlay::has_node(nid_t node_id) const {
+    return graph->has_node(node_id);
+}
+
+handle_t ReverseComplementOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return graph->get_handle(node_id, !is_reverse);
+}
+
+nid_t ReverseComplementOverlay::get_id(const handle_t& handle) const {
+    return graph->get_id(handle);
+}
+
+bool ReverseComplementOverlay::get_is_reverse(const handle_t& handle) const {
+    return !graph->get_is_reverse(handle);
+}
+
+handle_t ReverseComplementOverlay::flip(const handle_t& handle) const {
+    return graph->flip(handle);
+}
+
+size_t ReverseComplementOverlay::get_length(const handle_t& handle) const {
+    return graph->get_length(handle);
+}
+
+std::string ReverseComplementOverlay::get_sequence(const handle_t& handle) const {
+    // The handle already reads the strand it means
+    return graph->get_sequence(handle);
+}
+
+size_t ReverseComplementOverlay::get_node_count() const {
+    return graph->get_node_count();
+}
+
+nid_t ReverseComplementOverlay::min_node_id() const {
+    return graph->min_node_id();
+}
+
+nid_t ReverseComplementOverlay::max_node_id() const {
+    return graph->max_node_id();
+}
+
+size_t ReverseComplementOverlay::get_degree(const handle_t& handle, bool go_left) const {
+    return graph->get_degree(handle, go_left);
+}
+
+bool ReverseComplementOverlay::has_edge(const handle_t& left, const handle_t& right) const {
+    return graph->has_edge(left, right);
+}
+
+size_t ReverseComplementOverlay::get_edge_count() const {
+    return graph->get_edge_count();
+}
+
+size_t ReverseComplementOverlay::get_total_length() const {
+    return graph->get_total_length();
+}
+
+char ReverseComplementOverlay::get_base(const handle_t& handle, size_t index) const {
+    return graph->get_base(handle, index);
+}
+
+std::string ReverseComplementOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    return graph->get_subsequence(handle, index, size);
+}
+
+size_t ReverseComplementOverlay::copy_sequence(const handle_t& handle, char* dest) const {
+    return graph->copy_sequence(handle, dest);
+}
+
+handle_t ReverseComplementOverlay::get_underlying_handle(const handle_t& handle) const {
+    return handle;
+}
+
+bool ReverseComplementOverlay::follow_edges_impl(const handle_t& handle, bool go_left,
+                                                 const std::function<bool(const handle_t&)>& iteratee) const {
+    return graph->follow_edges(handle, go_left, iteratee);
+}
+
+bool ReverseComplementOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    return graph->for_each_handle([&](const handle_t& handle) {
+        return iteratee(graph->flip(handle));
+    }, parallel);
+}
+
+PathReverseComplementOverlay::PathReverseComplementOverlay(const PathHandleGraph* graph) :
+    ReverseComplementOverlay(graph), path_graph(graph) {
+    // Nothing to do
+}
+
+size_t PathReverseComplementOverlay::get_path_count() const {
+    return path_graph->get_path_count();
+}
+
+bool PathReverseComplementOverlay::has_path(const std::string& path_name) const {
+    return path_graph->has_path(path_name);
+}
+
+path_handle_t PathReverseComplementOverlay::get_path_handle(const std::string& path_name) const {
+    return path_graph->get_path_handle(path_name);
+}
+
+std::string PathReverseComplementOverlay::get_path_name(const path_handle_t& path_handle) const {
+    return path_graph->get_path_name(path_handle);
+}
+
+bool PathReverseComplementOverlay::get_is_circular(const path_handle_t& path_handle) const {
+    return path_graph->get_is_circular(path_handle);
+}
+
+size_t PathReverseComplementOverlay::get_step_count(const path_handle_t& path_handle) const {
+    return path_graph->get_step_count(path_handle);
+}
+
+size_t PathReverseComplementOverlay::get_step_count(const handle_t& handle) const {
+    return path_graph->get_step_count(handle);
+}
+
+handle_t PathReverseComplementOverlay::get_handle_of_step(const step_handle_t& step_handle) const {
+    // Going backward, we read the other strand
+    return path_graph->flip(path_graph->get_handle_of_step(step_handle));
+}
+
+path_handle_t PathReverseComplementOverlay::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    return path_graph->get_path_handle_of_step(step_handle);
+}
+
+step_handle_t PathReverseComplementOverlay::path_begin(const path_handle_t& path_handle) const {
+    return path_graph->path_back(path_handle);
+}
+
+step_handle_t PathReverseComplementOverlay::path_end(const path_handle_t& path_handle) const {
+    return path_graph->path_front_end(path_handle);
+}
+
+step_handle_t PathReverseComplementOverlay::path_back(const path_handle_t& path_handle) const {
+    return path_graph->path_begin(path_handle);
+}
+
+step_handle_t PathReverseComplementOverlay::path_front_end(const path_handle_t& path_handle) const {
+    return path_graph->path_end(path_handle);
+}
+
+bool PathReverseComplementOverlay::has_next_step(const step_handle_t& step_handle) const {
+    return path_graph->has_previous_step(step_handle);
+}
+
+bool PathReverseComplementOverlay::has_previous_step(const step_handle_t& step_handle) const {
+    return path_graph->has_next_step(step_handle);
+}
+
+step_handle_t PathReverseComplementOverlay::get_next_step(const step_handle_t& step_handle) const {
+    return path_graph->get_previous_step(step_handle);
+}
+
+step_handle_t PathReverseComplementOverlay::get_previous_step(const step_handle_t& step_handle) const {
+    return path_graph->get_next_step(step_handle);
+}
+
+PathSense PathReverseComplementOverlay::get_sense(const path_handle_t& handle) const {
+    return path_graph->get_sense(handle);
+}
+
+std::string PathReverseComplementOverlay::get_sample_name(const path_handle_t& handle) const {
+    return path_graph->get_sample_name(handle);
+}
+
+std::string PathReverseComplementOverlay::get_locus_name(const path_handle_t& handle) const {
+    return path_graph->get_locus_name(handle);
+}
+
+size_t PathReverseComplementOverlay::get_haplotype(const path_handle_t& handle) const {
+    return path_graph->get_haplotype(handle);
+}
+
+size_t PathReverseComplementOverlay::get_phase_block(const path_handle_t& handle) const {
+    return path_graph->get_phase_block(handle);
+}
+
+subrange_t PathReverseComplementOverlay::get_subrange(const path_handle_t& handle) const {
+    return path_graph->get_subrange(handle);
+}
+
+bool PathReverseComplementOverlay::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
+    return path_graph->for_each_path_handle(iteratee);
+}
+
+bool PathReverseComplementOverlay::for_each_step_on_handle_impl(const handle_t& handle,
+                                                                const std::function<bool(const step_handle_t&)>& iteratee) const {
+    return path_graph->for_each_step_on_handle(handle, iteratee);
+}
+
+bool PathReverseComplementOverlay::for_each_path_interval_impl(const std::vector<std::pair<nid_t, nid_t>>& id_ranges,
+                                                               const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const {
+    return path_graph->for_each_path_interval(id_ranges, [&](const step_handle_t& first, const step_handle_t& last) {
+        // The run goes the other way here
+        return iteratee(last, first);
+    });
+}
+
+bool PathReverseComplementOverlay::for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                                               const std::unordered_set<std::string>* samples,
+                                                               const std::unordered_set<std::string>* loci,
+                                                               const std::function<bool(const path_handle_t&)>& iteratee) const {
+    return path_graph->for_each_path_matching(senses, samples, loci, iteratee);
+}
+
+bool PathReverseComplementOverlay::for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                                               const std::function<bool(const step_handle_t&)>& iteratee) const {
+    return path_graph->for_each_step_of_sense(visited, sense, iteratee);
+}
+
+}
@@ -1,7 +1,13 @@
 #include "handlegraph/serializable.hpp"
+#include "handlegraph/read_ahead.hpp"
 
 #include <fstream>
+#include <sstream>
+#include <cstring>
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
 
 /** \file serializable.cpp
  * Implement Serializable default methods
@@ -59,8 +65,34 @@ void Serializable::deserialize(std::istream& in) {
 }
 
 void Serializable::deserialize(const std::string& filename) {
-    std::ifstream in(filename);
-    deserialize(in);
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        auto problem = errno;
+        std::stringstream ss;
+        ss << "Could not load from file " << filename << ": " << ::strerror(problem);
+        throw std::runtime_error(ss.str());
+    }
+    try {
+        deserialize(fd);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+void Serializable::deserialize(int fd) {
+    // Let a background thread keep the source busy while we parse
+    ReadAheadStream in(fd);
+    try {
+        deserialize(in);
+    } catch (...) {
+        // Surface any read error rather than whatever parse error it caused
+        in.rethrow_error();
+        throw;
+    }
+    // A read error can also just look like the end of the data
+    in.rethrow_error();
 }
 
 }
@@ -0,0 +1,237 @@
+#include "handlegraph/shared_memory.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+
+/** \file shared_memory.cpp
+ * Implement publishing and attaching objects in shared memory.
+ */
+
+namespace handlegraph {
+
+const uint32_t SHARED_MEMORY_FORMAT_VERSION = 1;
+
+/// Magic string at the start of every header segment
+static const char SHARED_MEMORY_MAGIC[8] = {'H', 'G', 'S', 'H', 'M', 'E', 'M', '\0'};
+
+/**
+ * Layout of the header segment. Only lock-free atomics are used, so that they
+ * work across processes.
+ */
+struct SharedMemoryHeader {
+    char magic[sizeof(SHARED_MEMORY_MAGIC)];
+    uint32_t format_version;
+    /// Magic number of the published object's implementation
+    uint32_t object_magic;
+    /// Length of the serialized representation, in bytes
+    uint64_t data_length;
+    /// Set once the data segment is completely written
+    std::atomic<uint32_t> ready;
+    /// Number of objects attached and not yet detached, as reported by the
+    /// attaching processes themselves
+    std::atomic<uint64_t> attach_count;
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared memory reference counts need lock-free atomics");
+
+/// Get the shm_open() name of the data segment
+static std::string data_segment_name(const std::string& name) {
+    return name.empty() || name.front() != '/' ? "/" + name : name;
+}
+
+/// Get the shm_open() name of the header segment
+static std::string header_segment_name(const std::string& name) {
+    return data_segment_name(name) + ".header";
+}
+
+/// Throw a runtime_error describing errno, for the given action on the given segment
+static void throw_errno(const std::string& action, const std::string& segment) {
+    auto problem = errno;
+    std::stringstream ss;
+    ss << "Could not " << action << " shared memory " << segment << ": " << ::strerror(problem);
+    throw std::runtime_error(ss.str());
+}
+
+/// Map the header of an existing published object. Must be unmapped with
+/// unmap_header().
+static SharedMemoryHeader* map_header(const std::string& name) {
+    std::string segment = header_segment_name(name);
+    int fd = ::shm_open(segment.c_str(), O_RDWR, 0);
+    if (fd == -1) {
+        throw_errno("open", segment);
+    }
+    struct stat stats;
+    if (::fstat(fd, &stats) != 0 || (size_t) stats.st_size < sizeof(SharedMemoryHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Shared memory " + segment + " is not a libhandlegraph header");
+    }
+    void* mapped = ::mmap(nullptr, sizeof(SharedMemoryHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw_errno("map", segment);
+    }
+    SharedMemoryHeader* header = (SharedMemoryHeader*) mapped;
+    if (::memcmp(header->magic, SHARED_MEMORY_MAGIC, sizeof(SHARED_MEMORY_MAGIC)) != 0) {
+        ::munmap(mapped, sizeof(SharedMemoryHeader));
+        throw std::runtime_error("Shared memory " + segment + " is not a libhandlegraph header");
+    }
+    if (header->format_version != SHARED_MEMORY_FORMAT_VERSION) {
+        std::stringstream ss;
+        ss << "Shared memory " << segment << " uses header version " << header->format_version
+           << " but this library uses version " << SHARED_MEMORY_FORMAT_VERSION;
+        ::munmap(mapped, sizeof(SharedMemoryHeader));
+        throw std::runtime_error(ss.str());
+    }
+    return header;
+}
+
+/// Release a header mapped with map_header()
+static void unmap_header(SharedMemoryHeader* header) {
+    ::munmap((void*) header, sizeof(SharedMemoryHeader));
+}
+
+void publish_to_shared_memory(const TriviallySerializable& object, const std::string& name) {
+    
+    // Claim the name by creating the header first, marked as not ready.
+    std::string header_segment = header_segment_name(name);
+    int header_fd = ::shm_open(header_segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (header_fd == -1) {
+        throw_errno("create", header_segment);
+    }
+    if (::ftruncate(header_fd, sizeof(SharedMemoryHeader)) != 0) {
+        ::close(header_fd);
+        ::shm_unlink(header_segment.c_str());
+        throw_errno("size", header_segment);
+    }
+    void* mapped = ::mmap(nullptr, sizeof(SharedMemoryHeader), PROT_READ | PROT_WRITE, MAP_SHARED, header_fd, 0);
+    ::close(header_fd);
+    if (mapped == MAP_FAILED) {
+        ::shm_unlink(header_segment.c_str());
+        throw_errno("map", header_segment);
+    }
+    SharedMemoryHeader* header = new (mapped) SharedMemoryHeader();
+    ::memcpy(header->magic, SHARED_MEMORY_MAGIC, sizeof(SHARED_MEMORY_MAGIC));
+    header->format_version = SHARED_MEMORY_FORMAT_VERSION;
+    header->object_magic = object.get_magic_number();
+    header->data_length = 0;
+    header->ready.store(0);
+    header->attach_count.store(0);
+    
+    // Now write the object itself
+    std::string data_segment = data_segment_name(name);
+    int data_fd = ::shm_open(data_segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (data_fd == -1) {
+        unmap_header(header);
+        ::shm_unlink(header_segment.c_str());
+        throw_errno("create", data_segment);
+    }
+    try {
+        object.serialize(data_fd);
+    } catch (...) {
+        ::close(data_fd);
+        ::shm_unlink(data_segment.c_str());
+        unmap_header(header);
+        ::shm_unlink(header_segment.c_str());
+        throw;
+    }
+    struct stat stats;
+    if (::fstat(data_fd, &stats) != 0) {
+        auto problem = errno;
+        ::close(data_fd);
+        ::shm_unlink(data_segment.c_str());
+        unmap_header(header);
+        ::shm_unlink(header_segment.c_str());
+        errno = problem;
+        throw_errno("inspect", data_segment);
+    }
+    ::close(data_fd);
+    
+    header->data_length = stats.st_size;
+    // Let attachers in
+    header->ready.store(1, std::memory_order_release);
+    unmap_header(header);
+}
+
+void attach_to_shared_memory(TriviallySerializable& object, const std::string& name) {
+    
+    SharedMemoryHeader* header = map_header(name);
+    
+    if (!header->ready.load(std::memory_order_acquire)) {
+        unmap_header(header);
+        throw std::runtime_error("Shared memory " + data_segment_name(name) + " is still being published");
+    }
+    if (header->object_magic != object.get_magic_number()) {
+        std::stringstream ss;
+        ss << "Shared memory " << data_segment_name(name) << " holds an object with magic number "
+           << std::hex << header->object_magic << " but the object being loaded has magic number "
+           << object.get_magic_number();
+        unmap_header(header);
+        throw std::runtime_error(ss.str());
+    }
+    
+    std::string data_segment = data_segment_name(name);
+    int data_fd = ::shm_open(data_segment.c_str(), O_RDONLY, 0);
+    if (data_fd == -1) {
+        unmap_header(header);
+        throw_errno("open", data_segment);
+    }
+    struct stat stats;
+    if (::fstat(data_fd, &stats) != 0 || (uint64_t) stats.st_size != header->data_length) {
+        ::close(data_fd);
+        unmap_header(header);
+        throw std::runtime_error("Shared memory " + data_segment + " does not match its header");
+    }
+    
+    try {
+        // Read only, so there can be no write-back into the shared copy.
+        // Implementations that map MAP_SHARED with PROT_WRITE will fail here.
+        object.deserialize(data_fd);
+    } catch (...) {
+        ::close(data_fd);
+        unmap_header(header);
+        throw;
+    }
+    ::close(data_fd);
+    
+    header->attach_count.fetch_add(1);
+    unmap_header(header);
+}
+
+size_t detach_from_shared_memory(const std::string& name) {
+    SharedMemoryHeader* header = map_header(name);
+    uint64_t count = header->attach_count.load();
+    // Don't let an unbalanced detach wrap around
+    while (count != 0 && !header->attach_count.compare_exchange_weak(count, count - 1)) {
+        // count was reloaded; try again
+    }
+    unmap_header(header);
+    return count == 0 ? 0 : count - 1;
+}
+
+size_t get_shared_memory_attach_count(const std::string& name) {
+    SharedMemoryHeader* header = map_header(name);
+    size_t count = header->attach_count.load();
+    unmap_header(header);
+    return count;
+}
+
+void remove_from_shared_memory(const std::string& name) {
+    std::string data_segment = data_segment_name(name);
+    std::string header_segment = header_segment_name(name);
+    if (::shm_unlink(data_segment.c_str()) != 0 && errno != ENOENT) {
+        throw_errno("remove", data_segment);
+    }
+    if (::shm_unlink(header_segment.c_str()) != 0 && errno != ENOENT) {
+        throw_errno("remove", header_segment);
+    }
+}
+
+}
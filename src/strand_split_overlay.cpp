@@ -0,0 +1,106 @@
+#include "handlegraph/overlays/strand_split_overlay.hpp"
+#include "handlegraph/util.hpp"
+
+/** \file strand_split_overlay.cpp
+ * Implement the StrandSplitOverlay.
+ */
+
+namespace handlegraph {
+
+// An overlay handle packs the underlying handle for the forward strand of the
+// overlay node as the number, and the overlay orientation as the bit.
+
+StrandSplitOverlay::StrandSplitOverlay(const HandleGraph* graph) : graph(graph) {
+    // Nothing to do
+}
+
+bool StrandSplitOverlay::has_node(nid_t node_id) const {
+    return graph->has_node(node_id >> 1);
+}
+
+handle_t StrandSplitOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(as_integer(graph->get_handle(node_id >> 1, node_id & 1)), is_reverse);
+}
+
+nid_t StrandSplitOverlay::get_id(const handle_t& handle) const {
+    handle_t strand = as_handle(number_bool_packing::unpack_number(handle));
+    return (graph->get_id(strand) << 1) | (nid_t) graph->get_is_reverse(strand);
+}
+
+bool StrandSplitOverlay::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t StrandSplitOverlay::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t StrandSplitOverlay::get_length(const handle_t& handle) const {
+    return graph->get_length(get_underlying_handle(handle));
+}
+
+std::string StrandSplitOverlay::get_sequence(const handle_t& handle) const {
+    return graph->get_sequence(get_underlying_handle(handle));
+}
+
+size_t StrandSplitOverlay::get_node_count() const {
+    return 2 * graph->get_node_count();
+}
+
+nid_t StrandSplitOverlay::min_node_id() const {
+    return graph->min_node_id() << 1;
+}
+
+nid_t StrandSplitOverlay::max_node_id() const {
+    return (graph->max_node_id() << 1) | 1;
+}
+
+size_t StrandSplitOverlay::get_degree(const handle_t& handle, bool go_left) const {
+    return graph->get_degree(get_underlying_handle(handle), go_left);
+}
+
+bool StrandSplitOverlay::has_edge(const handle_t& left, const handle_t& right) const {
+    // Edges only ever connect the same orientations of overlay nodes
+    return get_is_reverse(left) == get_is_reverse(right) &&
+        graph->has_edge(get_underlying_handle(left), get_underlying_handle(right));
+}
+
+size_t StrandSplitOverlay::get_total_length() const {
+    return 2 * graph->get_total_length();
+}
+
+char StrandSplitOverlay::get_base(const handle_t& handle, size_t index) const {
+    return graph->get_base(get_underlying_handle(handle), index);
+}
+
+std::string StrandSplitOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    return graph->get_subsequence(get_underlying_handle(handle), index, size);
+}
+
+size_t StrandSplitOverlay::copy_sequence(const handle_t& handle, char* dest) const {
+    return graph->copy_sequence(get_underlying_handle(handle), dest);
+}
+
+handle_t StrandSplitOverlay::get_underlying_handle(const handle_t& handle) const {
+    handle_t strand = as_handle(number_bool_packing::unpack_number(handle));
+    return number_bool_packing::unpack_bit(handle) ? graph->flip(strand) : strand;
+}
+
+bool StrandSplitOverlay::follow_edges_impl(const handle_t& handle, bool go_left,
+                                           const std::function<bool(const handle_t&)>& iteratee) const {
+    bool is_reverse = get_is_reverse(handle);
+    return graph->follow_edges(get_underlying_handle(handle), go_left, [&](const handle_t& next) {
+        // Reading along the reverse strand of overlay nodes means reading
+        // along the overlay nodes for the other underlying strand
+        return iteratee(number_bool_packing::pack(as_integer(is_reverse ? graph->flip(next) : next), is_reverse));
+    });
+}
+
+bool StrandSplitOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    return graph->for_each_handle([&](const handle_t& handle) {
+        return iteratee(number_bool_packing::pack(as_integer(handle), false)) &&
+            iteratee(number_bool_packing::pack(as_integer(graph->flip(handle)), false));
+    }, parallel);
+}
+
+}
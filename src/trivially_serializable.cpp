@@ -4,11 +4,14 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/file.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
 #include <cassert>
+#include <cstring>
 #include <sstream>
+#include <algorithm>
 
 
 /** \file trivially_serializable.cpp
@@ -81,6 +84,168 @@ void TriviallySerializable::deserialize(std::istream& in) {
     }
 }
 
+// Incremental saving works by writing a journal of (offset, length, data)
+// records next to the file, committing it with an atomic rename, and then
+// replaying it onto the file. If we crash before the rename, the partial
+// journal is ignored and the file is untouched. If we crash after, the journal
+// is replayed the next time the file is loaded or saved.
+//
+// Saving, loading and recovery of a file all hold an flock on a lock file
+// next to it, so processes sharing the file don't replay or discard each
+// other's journals.
+
+const size_t TriviallySerializable::DIRTY_PAGE_SIZE = 4096;
+
+/// Magic string at the start of every committed journal
+static const char JOURNAL_MAGIC[8] = {'H', 'G', 'J', 'O', 'U', 'R', 'N', '1'};
+
+/// Throw a runtime_error describing errno, for the given action on the given file
+static void throw_errno(const std::string& action, const std::string& filename) {
+    auto problem = errno;
+    std::stringstream ss;
+    ss << "Could not " << action << " " << filename << ": " << ::strerror(problem);
+    throw std::runtime_error(ss.str());
+}
+
+/// Write all of a buffer to a file descriptor at its current offset
+static void write_all(int fd, const void* data, size_t length, const std::string& filename) {
+    size_t written = 0;
+    while (written != length) {
+        auto result = ::write(fd, (const char*) data + written, length - written);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("write to", filename);
+        }
+        written += result;
+    }
+}
+
+/// Read exactly the given number of bytes from a file descriptor. Returns
+/// false if the file ends first.
+static bool read_all(int fd, void* data, size_t length, const std::string& filename) {
+    size_t read_so_far = 0;
+    while (read_so_far != length) {
+        auto result = ::read(fd, (char*) data + read_so_far, length - read_so_far);
+        if (result == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_errno("read from", filename);
+        }
+        if (result == 0) {
+            return false;
+        }
+        read_so_far += result;
+    }
+    return true;
+}
+
+/// Flush a file descriptor to stable storage
+static void sync_fd(int fd, const std::string& filename) {
+    if (::fsync(fd) != 0) {
+        throw_errno("sync", filename);
+    }
+}
+
+/// Flush the directory entry changes for the given file to stable storage
+static void sync_parent_directory(const std::string& filename) {
+    auto slash = filename.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : filename.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd == -1) {
+        // Not every platform lets us open directories; the rename is still atomic.
+        return;
+    }
+    ::fsync(fd);
+    ::close(fd);
+}
+
+/// Get the journal file name used for the given file
+static std::string journal_name(const std::string& filename) {
+    return filename + ".journal";
+}
+
+/// Get the name the journal is written under before it is committed
+static std::string partial_journal_name(const std::string& filename) {
+    return filename + ".journal.part";
+}
+
+/// Get the name a full replacement is written under before it is renamed into place
+static std::string replacement_name(const std::string& filename) {
+    return filename + ".replace.part";
+}
+
+/// Get the name of the lock file used for the given file
+static std::string lock_name(const std::string& filename) {
+    return filename + ".lock";
+}
+
+/// Holds an flock on the lock file for a file, exclusively at first. If the
+/// lock file can't be made or opened, as in a read-only directory, nobody can
+/// be saving there through us, so we go without.
+class JournalLock {
+public:
+    JournalLock(const std::string& filename) : filename(lock_name(filename)) {
+        fd = ::open(this->filename.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd == -1) {
+            fd = ::open(this->filename.c_str(), O_RDONLY);
+        }
+        lock(LOCK_EX);
+    }
+    
+    ~JournalLock() {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+    
+    /// Let other readers in, while still keeping out writers.
+    void share() {
+        lock(LOCK_SH);
+    }
+    
+private:
+    void lock(int operation) {
+        if (fd == -1) {
+            return;
+        }
+        while (::flock(fd, operation) != 0) {
+            if (errno != EINTR) {
+                auto problem = errno;
+                ::close(fd);
+                fd = -1;
+                errno = problem;
+                throw_errno("lock", filename);
+            }
+        }
+    }
+    
+    std::string filename;
+    int fd = -1;
+};
+
+/// Remove a file if it exists.
+static void remove_if_present(const std::string& filename) {
+    if (::unlink(filename.c_str()) != 0 && errno != ENOENT) {
+        throw_errno("remove", filename);
+    }
+}
+
+/// Throw away any journal or partial save for the given file, because the
+/// whole file is about to be rewritten. Must hold its JournalLock.
+static void discard_journal(const std::string& filename) {
+    remove_if_present(partial_journal_name(filename));
+    remove_if_present(replacement_name(filename));
+    remove_if_present(journal_name(filename));
+    sync_parent_directory(filename);
+}
+
+/// Finish or discard an interrupted incremental save of the given file. Must
+/// hold its JournalLock.
+static void replay_journal(const std::string& filename);
+
 // To let the const and non-const filename serialization implementations share
 // code, we have some helpers
 
@@ -110,6 +275,11 @@ void TriviallySerializable::close_fd(int fd) const {
 }
 
 void TriviallySerializable::serialize(const std::string& filename) const {
+    // A journal left over from an interrupted incremental save would be
+    // replayed over what we write, so get rid of it first.
+    JournalLock lock(filename);
+    discard_journal(filename);
+    
     int fd = open_fd(filename);
     
     // Serialize to the file, as const
@@ -119,16 +289,31 @@ void TriviallySerializable::serialize(const std::string& filename) const {
 }
 
 void TriviallySerializable::serialize(const std::string& filename) {
+    // A journal left over from an interrupted incremental save would be
+    // replayed over what we write, so get rid of it first.
+    JournalLock lock(filename);
+    discard_journal(filename);
+    
     int fd = open_fd(filename);
     
     // Serialize to the file, as non const
     serialize(fd);
     
     close_fd(fd);
+    
+    // The file now matches us exactly
+    mark_clean(filename);
 }
 
 void TriviallySerializable::deserialize(const std::string& filename) {
 
+    // If we crashed in the middle of saving this file incrementally, finish
+    // the job first. Then let other readers load alongside us, but don't let
+    // anyone save while we do.
+    JournalLock lock(filename);
+    replay_journal(filename);
+    lock.share();
+
     // Use the file descriptor version
     
     // Try to open in read write mode
@@ -152,6 +337,233 @@ void TriviallySerializable::deserialize(const std::string& filename) {
     
     // Close up the file
     close_fd(fd);
+    
+    // We now match the file exactly
+    mark_clean(filename);
+}
+
+void TriviallySerializable::recover_incremental(const std::string& filename) {
+    JournalLock lock(filename);
+    replay_journal(filename);
+}
+
+static void replay_journal(const std::string& filename) {
+    
+    // Anything uncommitted is just garbage, since whoever wrote it no longer
+    // holds the lock
+    remove_if_present(partial_journal_name(filename));
+    remove_if_present(replacement_name(filename));
+    
+    std::string journal = journal_name(filename);
+    int journal_fd = ::open(journal.c_str(), O_RDONLY);
+    if (journal_fd == -1) {
+        if (errno == ENOENT) {
+            // Nothing to recover
+            return;
+        }
+        throw_errno("open journal", journal);
+    }
+    
+    char magic[sizeof(JOURNAL_MAGIC)];
+    uint64_t final_length;
+    if (!read_all(journal_fd, magic, sizeof(magic), journal) ||
+        ::memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) != 0 ||
+        !read_all(journal_fd, &final_length, sizeof(final_length), journal)) {
+        ::close(journal_fd);
+        throw std::runtime_error("Journal " + journal + " is corrupt; cannot recover " + filename);
+    }
+    
+    int fd = ::open(filename.c_str(), O_WRONLY);
+    if (fd == -1) {
+        ::close(journal_fd);
+        throw_errno("open for recovery", filename);
+    }
+    
+    // Replay all the records onto the file
+    std::vector<char> buffer;
+    uint64_t record[2];
+    while (read_all(journal_fd, record, sizeof(record), journal)) {
+        // Each record is an offset and a length, followed by the data
+        buffer.resize(record[1]);
+        if (!read_all(journal_fd, buffer.data(), buffer.size(), journal)) {
+            ::close(fd);
+            ::close(journal_fd);
+            throw std::runtime_error("Journal " + journal + " is truncated; cannot recover " + filename);
+        }
+        size_t written = 0;
+        while (written != buffer.size()) {
+            auto result = ::pwrite(fd, buffer.data() + written, buffer.size() - written, record[0] + written);
+            if (result == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ::close(fd);
+                ::close(journal_fd);
+                throw_errno("write recovered data to", filename);
+            }
+            written += result;
+        }
+    }
+    ::close(journal_fd);
+    
+    if (::ftruncate(fd, final_length) != 0) {
+        ::close(fd);
+        throw_errno("resize", filename);
+    }
+    sync_fd(fd, filename);
+    if (::close(fd) != 0) {
+        throw_errno("close", filename);
+    }
+    
+    // Only now is the journal no longer needed
+    if (::unlink(journal.c_str()) != 0 && errno != ENOENT) {
+        throw_errno("remove journal", journal);
+    }
+    sync_parent_directory(filename);
+}
+
+bool TriviallySerializable::tracks_dirty_regions() const {
+    return false;
+}
+
+void TriviallySerializable::mark_dirty(size_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    size_t first_page = offset / DIRTY_PAGE_SIZE;
+    size_t last_page = (offset + length - 1) / DIRTY_PAGE_SIZE;
+    if (dirty_pages.size() <= last_page) {
+        dirty_pages.resize(last_page + 1, false);
+    }
+    std::fill(dirty_pages.begin() + first_page, dirty_pages.begin() + last_page + 1, true);
+}
+
+void TriviallySerializable::mark_clean(const std::string& filename) {
+    dirty_pages.clear();
+    struct stat file_stats;
+    has_clean_baseline = (::stat(filename.c_str(), &file_stats) == 0);
+    if (has_clean_baseline) {
+        baseline_device = file_stats.st_dev;
+        baseline_inode = file_stats.st_ino;
+        baseline_size = file_stats.st_size;
+    }
+}
+
+bool TriviallySerializable::is_baseline(const std::string& filename) const {
+    struct stat file_stats;
+    return has_clean_baseline && ::stat(filename.c_str(), &file_stats) == 0 &&
+        (uint64_t) file_stats.st_dev == baseline_device &&
+        (uint64_t) file_stats.st_ino == baseline_inode &&
+        (uint64_t) file_stats.st_size == baseline_size;
+}
+
+void TriviallySerializable::for_each_dirty_range(const std::function<void(size_t, size_t)>& iteratee) const {
+    size_t page = 0;
+    while (page < dirty_pages.size()) {
+        if (!dirty_pages[page]) {
+            ++page;
+            continue;
+        }
+        // Find the end of this run of dirty pages
+        size_t run_end = page + 1;
+        while (run_end < dirty_pages.size() && dirty_pages[run_end]) {
+            ++run_end;
+        }
+        iteratee(page * DIRTY_PAGE_SIZE, run_end * DIRTY_PAGE_SIZE);
+        page = run_end;
+    }
+}
+
+void TriviallySerializable::serialize_incremental(const std::string& filename) {
+    
+    // Make sure the file is in a committed state before we compare against
+    // it, and keep other processes from saving or recovering it until we are
+    // done.
+    JournalLock lock(filename);
+    replay_journal(filename);
+    
+    struct stat file_stats;
+    bool have_file = (::stat(filename.c_str(), &file_stats) == 0);
+    
+    if (!tracks_dirty_regions() || !have_file || !is_baseline(filename)) {
+        // We can't know what changed, or the file isn't the one our dirty
+        // pages are relative to, so atomically replace the whole file.
+        std::string replacement = replacement_name(filename);
+        int fd = ::open(replacement.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) {
+            throw_errno("save to", replacement);
+        }
+        // Use the const version so we don't associate with the temporary file
+        ((const TriviallySerializable*) this)->serialize(fd);
+        sync_fd(fd, replacement);
+        close_fd(fd);
+        if (::rename(replacement.c_str(), filename.c_str()) != 0) {
+            throw_errno("replace", filename);
+        }
+        sync_parent_directory(filename);
+        mark_clean(filename);
+        return;
+    }
+    
+    // Collect the ranges we need to write. Anything past the current end of
+    // the file is also dirty.
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for_each_dirty_range([&](size_t start, size_t end) {
+        ranges.emplace_back(start, end);
+    });
+    size_t old_length = file_stats.st_size;
+    while (!ranges.empty() && ranges.back().second >= old_length) {
+        // Absorb dirty ranges that reach the old end into the tail range
+        old_length = std::min(old_length, ranges.back().first);
+        ranges.pop_back();
+    }
+    ranges.emplace_back(old_length, std::numeric_limits<size_t>::max());
+    
+    // Write the journal, with the new data for each dirty range
+    std::string partial = partial_journal_name(filename);
+    int journal_fd = ::open(partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (journal_fd == -1) {
+        throw_errno("create journal", partial);
+    }
+    write_all(journal_fd, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC), partial);
+    // Leave space for the final length, which we learn as we go
+    uint64_t final_length = 0;
+    write_all(journal_fd, &final_length, sizeof(final_length), partial);
+    
+    auto next_range = ranges.begin();
+    ((const TriviallySerializable*) this)->serialize([&](const void* start, size_t length) {
+        // Find the overlap of this block with each dirty range
+        size_t block_start = final_length;
+        size_t block_end = block_start + length;
+        while (next_range != ranges.end() && next_range->second <= block_start) {
+            ++next_range;
+        }
+        for (auto it = next_range; it != ranges.end() && it->first < block_end; ++it) {
+            uint64_t record[2];
+            record[0] = std::max(block_start, it->first);
+            record[1] = std::min(block_end, it->second) - record[0];
+            write_all(journal_fd, record, sizeof(record), partial);
+            write_all(journal_fd, (const char*) start + (record[0] - block_start), record[1], partial);
+        }
+        final_length = block_end;
+    });
+    
+    if (::pwrite(journal_fd, &final_length, sizeof(final_length), sizeof(JOURNAL_MAGIC)) != sizeof(final_length)) {
+        ::close(journal_fd);
+        throw_errno("finish journal", partial);
+    }
+    sync_fd(journal_fd, partial);
+    close_fd(journal_fd);
+    
+    // Commit the journal. From here on a crash will be repaired by recovery.
+    if (::rename(partial.c_str(), journal_name(filename).c_str()) != 0) {
+        throw_errno("commit journal", partial);
+    }
+    sync_parent_directory(filename);
+    
+    // Apply it
+    replay_journal(filename);
+    mark_clean(filename);
 }
 
 }
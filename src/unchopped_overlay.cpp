@@ -0,0 +1,529 @@
+#include "handlegraph/overlays/unchopped_overlay.hpp"
+#include "handlegraph/algorithms/chop.hpp"
+#include "handlegraph/algorithms/internal/parallel.hpp"
+#include "handlegraph/util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <tuple>
+
+/** \file unchopped_overlay.cpp
+ * Implement the unchopped overlay.
+ */
+
+namespace handlegraph {
+
+/// Number of node IDs or chains handled by a thread at a time
+static const size_t BLOCK_SIZE = 4096;
+
+/// Flags for what sides of a node can be glued to their neighbors
+static const uint8_t PRESENT = 1;
+static const uint8_t JOINS_LEFT = 2;
+static const uint8_t JOINS_RIGHT = 4;
+
+/// Determine if the right side of the given handle can be glued to the
+/// neighbor on that side.
+static bool can_join_right(const PathHandleGraph* graph, const handle_t& handle) {
+    size_t count = 0;
+    handle_t next;
+    graph->follow_edges(handle, false, [&](const handle_t& other) {
+        next = other;
+        return ++count < 2;
+    });
+    return count == 1
+        && graph->get_id(next) != graph->get_id(handle)
+        && graph->get_degree(next, true) == 1
+        && algorithms::nodes_are_perfect_path_neighbors(*graph, handle, next);
+}
+
+UnchoppedOverlay::UnchoppedOverlay(const PathHandleGraph* graph, const ExecutionOptions& execution) :
+    graph(graph), min_id(0) {
+
+    chain_starts.push_back(0);
+    if (graph->get_node_count() == 0) {
+        return;
+    }
+    min_id = graph->min_node_id();
+    size_t width = graph->max_node_id() - min_id + 1;
+
+    // Work out which sides of which nodes join up, in parallel
+    std::vector<uint8_t> joins(width, 0);
+    execution.parallel_for((width + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](size_t block) {
+        size_t block_end = std::min(width, (block + 1) * BLOCK_SIZE);
+        for (size_t index = block * BLOCK_SIZE; index < block_end; index++) {
+            if (!graph->has_node(min_id + index)) {
+                continue;
+            }
+            handle_t handle = graph->get_handle(min_id + index);
+            joins[index] = PRESENT
+                | (can_join_right(graph, handle) ? JOINS_RIGHT : 0)
+                | (can_join_right(graph, graph->flip(handle)) ? JOINS_LEFT : 0);
+        }
+    });
+
+    // Determine if the right side of a handle joins up, and if so to what. We
+    // only join if both nodes agree.
+    auto side_joins = [&](const handle_t& handle, bool go_left) {
+        return joins[graph->get_id(handle) - min_id] & (graph->get_is_reverse(handle) != go_left ? JOINS_LEFT : JOINS_RIGHT);
+    };
+    auto find_next = [&](const handle_t& handle, handle_t& next) {
+        if (!side_joins(handle, false)) {
+            return false;
+        }
+        graph->follow_edges(handle, false, [&](const handle_t& other) {
+            next = other;
+        });
+        return (bool) side_joins(next, true);
+    };
+
+    // Walk out the chains from their ends
+    node_offsets.resize(width, 0);
+    chain_handles.reserve(graph->get_node_count());
+    std::vector<bool> visited(width, false);
+    auto walk_chain = [&](handle_t here) {
+        while (true) {
+            size_t index = graph->get_id(here) - min_id;
+            visited[index] = true;
+            node_offsets[index] = chain_handles.size();
+            chain_handles.push_back(here);
+            handle_t next;
+            if (!find_next(here, next) || visited[graph->get_id(next) - min_id]) {
+                break;
+            }
+            here = next;
+        }
+        chain_starts.push_back(chain_handles.size());
+    };
+    for (size_t index = 0; index < width; index++) {
+        if (!(joins[index] & PRESENT) || visited[index]) {
+            continue;
+        }
+        handle_t handle = graph->get_handle(min_id + index);
+        handle_t ignored;
+        if (!find_next(graph->flip(handle), ignored)) {
+            // Nothing joins on the left, so the chain reads from here
+            walk_chain(handle);
+        } else if (!find_next(handle, ignored)) {
+            // Nothing joins on the right, so the chain reads back from here
+            walk_chain(graph->flip(handle));
+        }
+    }
+    for (size_t index = 0; index < width; index++) {
+        if ((joins[index] & PRESENT) && !visited[index]) {
+            // Anything left is in a cycle of joined nodes, so break it here
+            walk_chain(graph->get_handle(min_id + index));
+        }
+    }
+
+    // Lay out the sequences, in parallel
+    size_t chain_count = chain_starts.size() - 1;
+    base_offsets.resize(chain_handles.size());
+    chain_lengths.resize(chain_count);
+    execution.parallel_for((chain_count + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](size_t block) {
+        size_t block_end = std::min(chain_count, (block + 1) * BLOCK_SIZE);
+        for (size_t chain = block * BLOCK_SIZE; chain < block_end; chain++) {
+            size_t offset = 0;
+            for (size_t i = chain_starts[chain]; i < chain_starts[chain + 1]; i++) {
+                base_offsets[i] = offset;
+                offset += graph->get_length(chain_handles[i]);
+            }
+            chain_lengths[chain] = offset;
+        }
+    });
+}
+
+size_t UnchoppedOverlay::get_chain(size_t offset) const {
+    return std::upper_bound(chain_starts.begin(), chain_starts.end(), offset) - chain_starts.begin() - 1;
+}
+
+handle_t UnchoppedOverlay::get_overlay_handle(const handle_t& underlying) const {
+    size_t offset = get_offset(graph->get_id(underlying));
+    return get_handle(get_chain(offset) + 1, underlying != chain_handles[offset]);
+}
+
+handle_t UnchoppedOverlay::get_entry_handle(const handle_t& handle) const {
+    size_t chain = get_id(handle) - 1;
+    if (get_is_reverse(handle)) {
+        return graph->flip(chain_handles[chain_starts[chain + 1] - 1]);
+    }
+    return chain_handles[chain_starts[chain]];
+}
+
+handle_t UnchoppedOverlay::get_exit_handle(const handle_t& handle) const {
+    return graph->flip(get_entry_handle(flip(handle)));
+}
+
+bool UnchoppedOverlay::is_entry(const handle_t& underlying) const {
+    size_t offset = get_offset(graph->get_id(underlying));
+    size_t chain = get_chain(offset);
+    if (underlying == chain_handles[offset]) {
+        return offset == chain_starts[chain];
+    }
+    return offset + 1 == chain_starts[chain + 1];
+}
+
+void UnchoppedOverlay::for_each_piece(const handle_t& handle, size_t index, size_t size,
+                                      const std::function<bool(const handle_t&, size_t, size_t)>& iteratee) const {
+    size_t chain = get_id(handle) - 1;
+    size_t length = chain_lengths[chain];
+    if (index >= length) {
+        return;
+    }
+    size_t end = std::min(length, index + size);
+    if (get_is_reverse(handle)) {
+        // Work on the forward strand
+        std::tie(index, end) = std::make_pair(length - end, length - index);
+    }
+
+    // Find the handles that overlap, in forward order
+    size_t chain_begin = chain_starts[chain];
+    size_t chain_end = chain_starts[chain + 1];
+    size_t first = std::upper_bound(base_offsets.begin() + chain_begin, base_offsets.begin() + chain_end, index)
+        - base_offsets.begin() - 1;
+    size_t past_last = first;
+    while (past_last < chain_end && base_offsets[past_last] < end) {
+        past_last++;
+    }
+
+    for (size_t k = 0; k < past_last - first; k++) {
+        size_t i = get_is_reverse(handle) ? past_last - 1 - k : first + k;
+        size_t node_start = base_offsets[i];
+        size_t node_end = (i + 1 < chain_end ? base_offsets[i + 1] : length);
+        size_t piece_start = std::max(index, node_start) - node_start;
+        size_t piece_end = std::min(end, node_end) - node_start;
+        if (piece_start >= piece_end) {
+            continue;
+        }
+        bool keep_going;
+        if (get_is_reverse(handle)) {
+            size_t node_length = node_end - node_start;
+            keep_going = iteratee(graph->flip(chain_handles[i]), node_length - piece_end, piece_end - piece_start);
+        } else {
+            keep_going = iteratee(chain_handles[i], piece_start, piece_end - piece_start);
+        }
+        if (!keep_going) {
+            return;
+        }
+    }
+}
+
+bool UnchoppedOverlay::for_each_entering_step(const handle_t& handle, const PathSense* sense,
+                                              const std::function<bool(const step_handle_t&)>& iteratee) const {
+    auto for_each_step = [&](const handle_t& underlying, const std::function<bool(const step_handle_t&)>& visit) {
+        if (sense) {
+            return graph->for_each_step_of_sense(underlying, *sense, visit);
+        }
+        return graph->for_each_step_on_handle(underlying, visit);
+    };
+
+    size_t chain = get_id(handle) - 1;
+    handle_t first = chain_handles[chain_starts[chain]];
+    if (get_chain_size(chain) == 1) {
+        // Every visit enters and leaves at once
+        return for_each_step(first, iteratee);
+    }
+    // Visits reading forward enter at the first node, and visits reading
+    // backward enter at the last node.
+    handle_t last = chain_handles[chain_starts[chain + 1] - 1];
+    return for_each_step(first, [&](const step_handle_t& step) {
+        return graph->get_handle_of_step(step) != first || iteratee(step);
+    }) && for_each_step(last, [&](const step_handle_t& step) {
+        return graph->get_handle_of_step(step) == last || iteratee(step);
+    });
+}
+
+step_handle_t UnchoppedOverlay::advance(step_handle_t step, size_t steps, bool go_left) const {
+    for (size_t i = 0; i < steps; i++) {
+        step = go_left ? graph->get_previous_step(step) : graph->get_next_step(step);
+    }
+    return step;
+}
+
+bool UnchoppedOverlay::has_node(nid_t node_id) const {
+    return node_id >= 1 && (size_t) node_id < chain_starts.size();
+}
+
+handle_t UnchoppedOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return number_bool_packing::pack(node_id, is_reverse);
+}
+
+nid_t UnchoppedOverlay::get_id(const handle_t& handle) const {
+    return number_bool_packing::unpack_number(handle);
+}
+
+bool UnchoppedOverlay::get_is_reverse(const handle_t& handle) const {
+    return number_bool_packing::unpack_bit(handle);
+}
+
+handle_t UnchoppedOverlay::flip(const handle_t& handle) const {
+    return number_bool_packing::toggle_bit(handle);
+}
+
+size_t UnchoppedOverlay::get_length(const handle_t& handle) const {
+    return chain_lengths[get_id(handle) - 1];
+}
+
+std::string UnchoppedOverlay::get_sequence(const handle_t& handle) const {
+    std::string sequence(get_length(handle), '\0');
+    copy_sequence(handle, &sequence[0]);
+    return sequence;
+}
+
+size_t UnchoppedOverlay::get_node_count() const {
+    return chain_lengths.size();
+}
+
+nid_t UnchoppedOverlay::min_node_id() const {
+    return 1;
+}
+
+nid_t UnchoppedOverlay::max_node_id() const {
+    return chain_lengths.size();
+}
+
+size_t UnchoppedOverlay::get_edge_count() const {
+    // Every join inside a chain hides an edge
+    return graph->get_edge_count() - (chain_handles.size() - chain_lengths.size());
+}
+
+size_t UnchoppedOverlay::get_total_length() const {
+    return graph->get_total_length();
+}
+
+char UnchoppedOverlay::get_base(const handle_t& handle, size_t index) const {
+    char base = 'N';
+    for_each_piece(handle, index, 1, [&](const handle_t& underlying, size_t offset, size_t) {
+        base = graph->get_base(underlying, offset);
+        return false;
+    });
+    return base;
+}
+
+std::string UnchoppedOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    std::string subsequence;
+    for_each_piece(handle, index, size, [&](const handle_t& underlying, size_t offset, size_t length) {
+        subsequence += graph->get_subsequence(underlying, offset, length);
+        return true;
+    });
+    return subsequence;
+}
+
+size_t UnchoppedOverlay::copy_sequence(const handle_t& handle, char* dest) const {
+    char* cursor = dest;
+    for_each_piece(handle, 0, get_length(handle), [&](const handle_t& underlying, size_t, size_t) {
+        // We only get whole nodes
+        cursor += graph->copy_sequence(underlying, cursor);
+        return true;
+    });
+    return cursor - dest;
+}
+
+handle_t UnchoppedOverlay::get_underlying_handle(const handle_t& handle) const {
+    return get_entry_handle(handle);
+}
+
+bool UnchoppedOverlay::follow_edges_impl(const handle_t& handle, bool go_left,
+                                         const std::function<bool(const handle_t&)>& iteratee) const {
+    handle_t end = go_left ? get_entry_handle(handle) : get_exit_handle(handle);
+    return graph->follow_edges(end, go_left, [&](const handle_t& other) {
+        // Edges can only reach the ends of chains
+        return iteratee(get_overlay_handle(other));
+    });
+}
+
+bool UnchoppedOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    size_t chain_count = chain_lengths.size();
+    if (!parallel) {
+        for (size_t chain = 0; chain < chain_count; chain++) {
+            if (!iteratee(get_handle(chain + 1))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::atomic<bool> keep_going(true);
+    algorithms::internal::parallel_for((chain_count + BLOCK_SIZE - 1) / BLOCK_SIZE, 0, [&](size_t block) {
+        size_t block_end = std::min(chain_count, (block + 1) * BLOCK_SIZE);
+        for (size_t chain = block * BLOCK_SIZE; chain < block_end && keep_going.load(); chain++) {
+            if (!iteratee(get_handle(chain + 1))) {
+                keep_going.store(false);
+            }
+        }
+    });
+    return keep_going.load();
+}
+
+size_t UnchoppedOverlay::get_path_count() const {
+    return graph->get_path_count();
+}
+
+bool UnchoppedOverlay::has_path(const std::string& path_name) const {
+    return graph->has_path(path_name);
+}
+
+path_handle_t UnchoppedOverlay::get_path_handle(const std::string& path_name) const {
+    return graph->get_path_handle(path_name);
+}
+
+std::string UnchoppedOverlay::get_path_name(const path_handle_t& path_handle) const {
+    return graph->get_path_name(path_handle);
+}
+
+bool UnchoppedOverlay::get_is_circular(const path_handle_t& path_handle) const {
+    return graph->get_is_circular(path_handle);
+}
+
+size_t UnchoppedOverlay::get_step_count(const path_handle_t& path_handle) const {
+    size_t count = 0;
+    graph->for_each_step_in_path(path_handle, [&](const step_handle_t& step) {
+        if (is_entry(graph->get_handle_of_step(step))) {
+            count++;
+        }
+    });
+    return count;
+}
+
+size_t UnchoppedOverlay::get_step_count(const handle_t& handle) const {
+    // Every visit to the chain visits every node once
+    return graph->get_step_count(get_entry_handle(handle));
+}
+
+bool UnchoppedOverlay::is_empty(const path_handle_t& path_handle) const {
+    return graph->is_empty(path_handle);
+}
+
+handle_t UnchoppedOverlay::get_handle_of_step(const step_handle_t& step_handle) const {
+    return get_overlay_handle(graph->get_handle_of_step(step_handle));
+}
+
+path_handle_t UnchoppedOverlay::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    return graph->get_path_handle_of_step(step_handle);
+}
+
+step_handle_t UnchoppedOverlay::path_begin(const path_handle_t& path_handle) const {
+    step_handle_t begin = graph->path_begin(path_handle);
+    if (!graph->get_is_circular(path_handle) || begin == graph->path_end(path_handle)) {
+        // Paths can only start at the ends of chains
+        return begin;
+    }
+    // A circular path might start partway through a chain, so go back to where
+    // it enters.
+    handle_t underlying = graph->get_handle_of_step(begin);
+    size_t offset = get_offset(graph->get_id(underlying));
+    size_t chain = get_chain(offset);
+    if (underlying == chain_handles[offset]) {
+        return advance(begin, offset - chain_starts[chain], true);
+    }
+    return advance(begin, chain_starts[chain + 1] - 1 - offset, true);
+}
+
+step_handle_t UnchoppedOverlay::path_end(const path_handle_t& path_handle) const {
+    return graph->path_end(path_handle);
+}
+
+step_handle_t UnchoppedOverlay::path_back(const path_handle_t& path_handle) const {
+    if (graph->get_is_circular(path_handle) && !graph->is_empty(path_handle)) {
+        // The last step is the one before wherever we start
+        return get_previous_step(path_begin(path_handle));
+    }
+    step_handle_t back = graph->path_back(path_handle);
+    if (back == graph->path_front_end(path_handle)) {
+        // The path is empty
+        return back;
+    }
+    // Go back to where the path enters the last chain
+    size_t chain = get_id(get_handle_of_step(back)) - 1;
+    return advance(back, get_chain_size(chain) - 1, true);
+}
+
+step_handle_t UnchoppedOverlay::path_front_end(const path_handle_t& path_handle) const {
+    return graph->path_front_end(path_handle);
+}
+
+bool UnchoppedOverlay::has_next_step(const step_handle_t& step_handle) const {
+    size_t chain = get_id(get_handle_of_step(step_handle)) - 1;
+    return graph->has_next_step(advance(step_handle, get_chain_size(chain) - 1, false));
+}
+
+bool UnchoppedOverlay::has_previous_step(const step_handle_t& step_handle) const {
+    return graph->has_previous_step(step_handle);
+}
+
+step_handle_t UnchoppedOverlay::get_next_step(const step_handle_t& step_handle) const {
+    if (step_handle == graph->path_front_end(graph->get_path_handle_of_step(step_handle))) {
+        return graph->get_next_step(step_handle);
+    }
+    size_t chain = get_id(get_handle_of_step(step_handle)) - 1;
+    return graph->get_next_step(advance(step_handle, get_chain_size(chain) - 1, false));
+}
+
+step_handle_t UnchoppedOverlay::get_previous_step(const step_handle_t& step_handle) const {
+    step_handle_t previous = graph->get_previous_step(step_handle);
+    if (previous == graph->path_front_end(graph->get_path_handle_of_step(previous))) {
+        return previous;
+    }
+    size_t chain = get_id(get_handle_of_step(previous)) - 1;
+    return advance(previous, get_chain_size(chain) - 1, true);
+}
+
+PathSense UnchoppedOverlay::get_sense(const path_handle_t& handle) const {
+    return graph->get_sense(handle);
+}
+
+std::string UnchoppedOverlay::get_sample_name(const path_handle_t& handle) const {
+    return graph->get_sample_name(handle);
+}
+
+std::string UnchoppedOverlay::get_locus_name(const path_handle_t& handle) const {
+    return graph->get_locus_name(handle);
+}
+
+size_t UnchoppedOverlay::get_haplotype(const path_handle_t& handle) const {
+    return graph->get_haplotype(handle);
+}
+
+size_t UnchoppedOverlay::get_phase_block(const path_handle_t& handle) const {
+    return graph->get_phase_block(handle);
+}
+
+subrange_t UnchoppedOverlay::get_subrange(const path_handle_t& handle) const {
+    return graph->get_subrange(handle);
+}
+
+std::vector<oriented_node_range_t> UnchoppedOverlay::translate_back(const oriented_node_range_t& range) const {
+    std::vector<oriented_node_range_t> translated;
+    for_each_piece(get_handle(std::get<0>(range), std::get<1>(range)), std::get<2>(range), std::get<3>(range),
+                   [&](const handle_t& underlying, size_t offset, size_t length) {
+        translated.emplace_back(graph->get_id(underlying), graph->get_is_reverse(underlying), offset, length);
+        return true;
+    });
+    return translated;
+}
+
+std::string UnchoppedOverlay::get_back_graph_node_name(const nid_t& back_node_id) const {
+    return std::to_string(back_node_id);
+}
+
+bool UnchoppedOverlay::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
+    return graph->for_each_path_handle(iteratee);
+}
+
+bool UnchoppedOverlay::for_each_step_on_handle_impl(const handle_t& handle,
+                                                    const std::function<bool(const step_handle_t&)>& iteratee) const {
+    return for_each_entering_step(handle, nullptr, iteratee);
+}
+
+bool UnchoppedOverlay::for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                                   const std::unordered_set<std::string>* samples,
+                                                   const std::unordered_set<std::string>* loci,
+                                                   const std::function<bool(const path_handle_t&)>& iteratee) const {
+    return graph->for_each_path_matching(senses, samples, loci, iteratee);
+}
+
+bool UnchoppedOverlay::for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                                   const std::function<bool(const step_handle_t&)>& iteratee) const {
+    return for_each_entering_step(visited, &sense, iteratee);
+}
+
+}
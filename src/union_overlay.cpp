@@ -0,0 +1,493 @@
+#include "handlegraph/overlays/union_overlay.hpp"
+#include "handlegraph/algorithms/internal/parallel.hpp"
+#include "handlegraph/util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <unordered_map>
+
+/** \file union_overlay.cpp
+ * Implement the union overlay.
+ */
+
+namespace handlegraph {
+
+/// Number of low bits left for the graphs' own values
+static const size_t VALUE_BITS = 64 - UnionOverlay::INDEX_BITS;
+
+/// Mask for the graphs' own values
+static const uint64_t VALUE_MASK = (0x1ULL << VALUE_BITS) - 1;
+
+/// Tag a value from a graph with the graph's index
+static inline uint64_t tag(uint64_t value, size_t index) {
+    if (value >> VALUE_BITS) {
+        throw std::runtime_error("error:[UnionOverlay] handle from graph " + std::to_string(index)
+                                 + " uses the bits needed to tag it");
+    }
+    return value | ((uint64_t) index << VALUE_BITS);
+}
+
+/// Get the index of the graph a tagged value is from
+static inline size_t index_of(uint64_t value) {
+    return value >> VALUE_BITS;
+}
+
+static inline handle_t tag(const handle_t& handle, size_t index) {
+    uint64_t value = tag(as_integer(handle), index);
+    return as_handle(value);
+}
+
+static inline handle_t untag(const handle_t& handle) {
+    uint64_t value = as_integer(handle) & VALUE_MASK;
+    return as_handle(value);
+}
+
+static inline path_handle_t tag(const path_handle_t& path_handle, size_t index) {
+    uint64_t value = tag(as_integer(path_handle), index);
+    return as_path_handle(value);
+}
+
+static inline path_handle_t untag(const path_handle_t& path_handle) {
+    uint64_t value = as_integer(path_handle) & VALUE_MASK;
+    return as_path_handle(value);
+}
+
+static inline step_handle_t tag(const step_handle_t& step_handle, size_t index) {
+    step_handle_t tagged = step_handle;
+    as_integers(tagged)[0] = tag((uint64_t) as_integers(step_handle)[0], index);
+    return tagged;
+}
+
+static inline step_handle_t untag(const step_handle_t& step_handle) {
+    step_handle_t untagged = step_handle;
+    as_integers(untagged)[0] = (uint64_t) as_integers(step_handle)[0] & VALUE_MASK;
+    return untagged;
+}
+
+UnionOverlay::UnionOverlay(const std::vector<const PathHandleGraph*>& graphs) : graphs(graphs) {
+
+    if (graphs.size() > (0x1ULL << INDEX_BITS)) {
+        throw std::runtime_error("error:[UnionOverlay] cannot combine more than "
+                                 + std::to_string(0x1ULL << INDEX_BITS) + " graphs");
+    }
+
+    // Stack up the ID ranges, moving only those that would overlap
+    id_offsets.resize(graphs.size(), 0);
+    nid_t next_free_id = 0;
+    for (size_t i = 0; i < graphs.size(); i++) {
+        if (graphs[i]->get_node_count() == 0) {
+            continue;
+        }
+        nid_t min_id = graphs[i]->min_node_id();
+        if (!range_starts.empty() && min_id < next_free_id) {
+            id_offsets[i] = next_free_id - min_id;
+        }
+        range_starts.push_back(min_id + id_offsets[i]);
+        range_graphs.push_back(i);
+        next_free_id = graphs[i]->max_node_id() + id_offsets[i] + 1;
+    }
+    
+    // Path names must stay unique across the union
+    std::unordered_map<std::string, size_t> path_graphs;
+    for (size_t i = 0; i < graphs.size(); i++) {
+        graphs[i]->for_each_path_matching(nullptr, nullptr, nullptr, [&](const path_handle_t& path_handle) {
+            std::string name = graphs[i]->get_path_name(path_handle);
+            auto inserted = path_graphs.emplace(name, i);
+            if (!inserted.second) {
+                throw std::runtime_error("error:[UnionOverlay] graphs " + std::to_string(inserted.first->second)
+                                         + " and " + std::to_string(i) + " both have a path named " + name);
+            }
+        });
+    }
+}
+
+size_t UnionOverlay::get_graph_count() const {
+    return graphs.size();
+}
+
+const PathHandleGraph* UnionOverlay::get_graph(size_t index) const {
+    return graphs.at(index);
+}
+
+nid_t UnionOverlay::get_id_offset(size_t index) const {
+    return id_offsets.at(index);
+}
+
+size_t UnionOverlay::get_graph_index(const handle_t& handle) const {
+    return index_of(as_integer(handle));
+}
+
+size_t UnionOverlay::get_graph_index(const path_handle_t& path_handle) const {
+    return index_of(as_integer(path_handle));
+}
+
+handle_t UnionOverlay::get_underlying_handle(const handle_t& handle) const {
+    return untag(handle);
+}
+
+handle_t UnionOverlay::get_overlay_handle(size_t index, const handle_t& handle) const {
+    return tag(handle, index);
+}
+
+bool UnionOverlay::has_node(nid_t node_id) const {
+    auto it = std::upper_bound(range_starts.begin(), range_starts.end(), node_id);
+    if (it == range_starts.begin()) {
+        return false;
+    }
+    size_t index = range_graphs[it - range_starts.begin() - 1];
+    return graphs[index]->has_node(node_id - id_offsets[index]);
+}
+
+handle_t UnionOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    auto it = std::upper_bound(range_starts.begin(), range_starts.end(), node_id);
+    if (it == range_starts.begin()) {
+        throw std::runtime_error("error:[UnionOverlay] no node with ID " + std::to_string(node_id));
+    }
+    size_t index = range_graphs[it - range_starts.begin() - 1];
+    return tag(graphs[index]->get_handle(node_id - id_offsets[index], is_reverse), index);
+}
+
+nid_t UnionOverlay::get_id(const handle_t& handle) const {
+    size_t index = get_graph_index(handle);
+    return graphs[index]->get_id(untag(handle)) + id_offsets[index];
+}
+
+bool UnionOverlay::get_is_reverse(const handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_is_reverse(untag(handle));
+}
+
+handle_t UnionOverlay::flip(const handle_t& handle) const {
+    size_t index = get_graph_index(handle);
+    return tag(graphs[index]->flip(untag(handle)), index);
+}
+
+size_t UnionOverlay::get_length(const handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_length(untag(handle));
+}
+
+std::string UnionOverlay::get_sequence(const handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_sequence(untag(handle));
+}
+
+size_t UnionOverlay::get_node_count() const {
+    size_t count = 0;
+    for (auto& graph : graphs) {
+        count += graph->get_node_count();
+    }
+    return count;
+}
+
+nid_t UnionOverlay::min_node_id() const {
+    return range_starts.empty() ? 0 : range_starts.front();
+}
+
+nid_t UnionOverlay::max_node_id() const {
+    if (range_graphs.empty()) {
+        return 0;
+    }
+    size_t index = range_graphs.back();
+    return graphs[index]->max_node_id() + id_offsets[index];
+}
+
+size_t UnionOverlay::get_degree(const handle_t& handle, bool go_left) const {
+    return graphs[get_graph_index(handle)]->get_degree(untag(handle), go_left);
+}
+
+bool UnionOverlay::has_edge(const handle_t& left, const handle_t& right) const {
+    // There are no edges between graphs
+    return get_graph_index(left) == get_graph_index(right)
+        && graphs[get_graph_index(left)]->has_edge(untag(left), untag(right));
+}
+
+size_t UnionOverlay::get_edge_count() const {
+    size_t count = 0;
+    for (auto& graph : graphs) {
+        count += graph->get_edge_count();
+    }
+    return count;
+}
+
+size_t UnionOverlay::get_total_length() const {
+    size_t length = 0;
+    for (auto& graph : graphs) {
+        length += graph->get_total_length();
+    }
+    return length;
+}
+
+char UnionOverlay::get_base(const handle_t& handle, size_t index) const {
+    return graphs[get_graph_index(handle)]->get_base(untag(handle), index);
+}
+
+std::string UnionOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    return graphs[get_graph_index(handle)]->get_subsequence(untag(handle), index, size);
+}
+
+size_t UnionOverlay::copy_sequence(const handle_t& handle, char* dest) const {
+    return graphs[get_graph_index(handle)]->copy_sequence(untag(handle), dest);
+}
+
+bool UnionOverlay::follow_edges_impl(const handle_t& handle, bool go_left,
+                                     const std::function<bool(const handle_t&)>& iteratee) const {
+    size_t index = get_graph_index(handle);
+    return graphs[index]->follow_edges(untag(handle), go_left, [&](const handle_t& other) {
+        return iteratee(tag(other, index));
+    });
+}
+
+bool UnionOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    if (!parallel) {
+        for (size_t index = 0; index < graphs.size(); index++) {
+            bool keep_going = graphs[index]->for_each_handle([&](const handle_t& handle) {
+                return iteratee(tag(handle, index));
+            });
+            if (!keep_going) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Fan out over the graphs, biggest first. Only have each graph also work
+    // in parallel if there aren't enough graphs to keep the threads busy.
+    std::vector<size_t> order(graphs.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::vector<size_t> sizes(graphs.size());
+    for (size_t i = 0; i < graphs.size(); i++) {
+        sizes[i] = graphs[i]->get_node_count();
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return sizes[a] > sizes[b];
+    });
+    bool nested = graphs.size() < algorithms::internal::default_thread_count();
+    std::atomic<bool> keep_going(true);
+    algorithms::internal::parallel_for(order.size(), 0, [&](size_t i) {
+        size_t index = order[i];
+        if (!keep_going.load()) {
+            return;
+        }
+        bool finished = graphs[index]->for_each_handle([&](const handle_t& handle) {
+            if (!keep_going.load()) {
+                return false;
+            }
+            if (!iteratee(tag(handle, index))) {
+                keep_going.store(false);
+                return false;
+            }
+            return true;
+        }, nested);
+        if (!finished) {
+            keep_going.store(false);
+        }
+    });
+    return keep_going.load();
+}
+
+size_t UnionOverlay::get_path_count() const {
+    size_t count = 0;
+    for (auto& graph : graphs) {
+        count += graph->get_path_count();
+    }
+    return count;
+}
+
+bool UnionOverlay::has_path(const std::string& path_name) const {
+    for (auto& graph : graphs) {
+        if (graph->has_path(path_name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+path_handle_t UnionOverlay::get_path_handle(const std::string& path_name) const {
+    // Names are unique across the graphs, so the first match is the only one
+    for (size_t index = 0; index < graphs.size(); index++) {
+        if (graphs[index]->has_path(path_name)) {
+            return tag(graphs[index]->get_path_handle(path_name), index);
+        }
+    }
+    throw std::runtime_error("error:[UnionOverlay] no path named " + path_name);
+}
+
+std::string UnionOverlay::get_path_name(const path_handle_t& path_handle) const {
+    return graphs[get_graph_index(path_handle)]->get_path_name(untag(path_handle));
+}
+
+bool UnionOverlay::get_is_circular(const path_handle_t& path_handle) const {
+    return graphs[get_graph_index(path_handle)]->get_is_circular(untag(path_handle));
+}
+
+size_t UnionOverlay::get_step_count(const path_handle_t& path_handle) const {
+    return graphs[get_graph_index(path_handle)]->get_step_count(untag(path_handle));
+}
+
+size_t UnionOverlay::get_step_count(const handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_step_count(untag(handle));
+}
+
+bool UnionOverlay::is_empty(const path_handle_t& path_handle) const {
+    return graphs[get_graph_index(path_handle)]->is_empty(untag(path_handle));
+}
+
+size_t UnionOverlay::get_step_handles(const path_handle_t& path, step_handle_t& step,
+                                      handle_t* buffer, size_t max_steps) const {
+    size_t index = get_graph_index(path);
+    step_handle_t underlying = untag(step);
+    size_t count = graphs[index]->get_step_handles(untag(path), underlying, buffer, max_steps);
+    for (size_t i = 0; i < count; i++) {
+        buffer[i] = tag(buffer[i], index);
+    }
+    step = tag(underlying, index);
+    return count;
+}
+
+handle_t UnionOverlay::get_handle_of_step(const step_handle_t& step_handle) const {
+    size_t index = index_of(as_integers(step_handle)[0]);
+    return tag(graphs[index]->get_handle_of_step(untag(step_handle)), index);
+}
+
+path_handle_t UnionOverlay::get_path_handle_of_step(const step_handle_t& step_handle) const {
+    size_t index = index_of(as_integers(step_handle)[0]);
+    return tag(graphs[index]->get_path_handle_of_step(untag(step_handle)), index);
+}
+
+step_handle_t UnionOverlay::path_begin(const path_handle_t& path_handle) const {
+    size_t index = get_graph_index(path_handle);
+    return tag(graphs[index]->path_begin(untag(path_handle)), index);
+}
+
+step_handle_t UnionOverlay::path_end(const path_handle_t& path_handle) const {
+    size_t index = get_graph_index(path_handle);
+    return tag(graphs[index]->path_end(untag(path_handle)), index);
+}
+
+step_handle_t UnionOverlay::path_back(const path_handle_t& path_handle) const {
+    size_t index = get_graph_index(path_handle);
+    return tag(graphs[index]->path_back(untag(path_handle)), index);
+}
+
+step_handle_t UnionOverlay::path_front_end(const path_handle_t& path_handle) const {
+    size_t index = get_graph_index(path_handle);
+    return tag(graphs[index]->path_front_end(untag(path_handle)), index);
+}
+
+bool UnionOverlay::has_next_step(const step_handle_t& step_handle) const {
+    return graphs[index_of(as_integers(step_handle)[0])]->has_next_step(untag(step_handle));
+}
+
+bool UnionOverlay::has_previous_step(const step_handle_t& step_handle) const {
+    return graphs[index_of(as_integers(step_handle)[0])]->has_previous_step(untag(step_handle));
+}
+
+step_handle_t UnionOverlay::get_next_step(const step_handle_t& step_handle) const {
+    size_t index = index_of(as_integers(step_handle)[0]);
+    return tag(graphs[index]->get_next_step(untag(step_handle)), index);
+}
+
+step_handle_t UnionOverlay::get_previous_step(const step_handle_t& step_handle) const {
+    size_t index = index_of(as_integers(step_handle)[0]);
+    return tag(graphs[index]->get_previous_step(untag(step_handle)), index);
+}
+
+PathSense UnionOverlay::get_sense(const path_handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_sense(untag(handle));
+}
+
+std::string UnionOverlay::get_sample_name(const path_handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_sample_name(untag(handle));
+}
+
+std::string UnionOverlay::get_locus_name(const path_handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_locus_name(untag(handle));
+}
+
+size_t UnionOverlay::get_haplotype(const path_handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_haplotype(untag(handle));
+}
+
+size_t UnionOverlay::get_phase_block(const path_handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_phase_block(untag(handle));
+}
+
+subrange_t UnionOverlay::get_subrange(const path_handle_t& handle) const {
+    return graphs[get_graph_index(handle)]->get_subrange(untag(handle));
+}
+
+bool UnionOverlay::for_each_path_handle_impl(const std::function<bool(const path_handle_t&)>& iteratee) const {
+    for (size_t index = 0; index < graphs.size(); index++) {
+        bool keep_going = graphs[index]->for_each_path_handle([&](const path_handle_t& path_handle) {
+            return iteratee(tag(path_handle, index));
+        });
+        if (!keep_going) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnionOverlay::for_each_step_on_handle_impl(const handle_t& handle,
+                                                const std::function<bool(const step_handle_t&)>& iteratee) const {
+    size_t index = get_graph_index(handle);
+    return graphs[index]->for_each_step_on_handle(untag(handle), [&](const step_handle_t& step) {
+        return iteratee(tag(step, index));
+    });
+}
+
+bool UnionOverlay::for_each_path_interval_impl(const std::vector<std::pair<nid_t, nid_t>>& id_ranges,
+                                               const std::function<bool(const step_handle_t&, const step_handle_t&)>& iteratee) const {
+    std::vector<std::pair<nid_t, nid_t>> graph_ranges;
+    for (size_t i = 0; i < range_graphs.size(); i++) {
+        size_t index = range_graphs[i];
+        // Clip the ranges to this graph's IDs
+        nid_t first_id = range_starts[i];
+        nid_t last_id = graphs[index]->max_node_id() + id_offsets[index];
+        graph_ranges.clear();
+        for (auto& range : id_ranges) {
+            nid_t first = std::max(range.first, first_id);
+            nid_t last = std::min(range.second, last_id);
+            if (first <= last) {
+                graph_ranges.emplace_back(first - id_offsets[index], last - id_offsets[index]);
+            }
+        }
+        if (graph_ranges.empty()) {
+            continue;
+        }
+        bool keep_going = graphs[index]->for_each_path_interval(graph_ranges, [&](const step_handle_t& first,
+                                                                                  const step_handle_t& last) {
+            return iteratee(tag(first, index), tag(last, index));
+        });
+        if (!keep_going) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnionOverlay::for_each_path_matching_impl(const std::unordered_set<PathSense>* senses,
+                                               const std::unordered_set<std::string>* samples,
+                                               const std::unordered_set<std::string>* loci,
+                                               const std::function<bool(const path_handle_t&)>& iteratee) const {
+    for (size_t index = 0; index < graphs.size(); index++) {
+        bool keep_going = graphs[index]->for_each_path_matching(senses, samples, loci, [&](const path_handle_t& path_handle) {
+            return iteratee(tag(path_handle, index));
+        });
+        if (!keep_going) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnionOverlay::for_each_step_of_sense_impl(const handle_t& visited, const PathSense& sense,
+                                               const std::function<bool(const step_handle_t&)>& iteratee) const {
+    size_t index = get_graph_index(visited);
+    return graphs[index]->for_each_step_of_sense(untag(visited), sense, [&](const step_handle_t& step) {
+        return iteratee(tag(step, index));
+    });
+}
+
+}
@@ -0,0 +1,265 @@
+#include "handlegraph/overlays/vectorizable_overlay.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+/** \file vectorizable_overlay.cpp
+ * Implement the vectorizable overlay.
+ */
+
+namespace handlegraph {
+
+/// Number of ranks handed to a thread at a time while building.
+static const size_t RANK_BLOCK_SIZE = 4096;
+
+VectorizableOverlay::VectorizableOverlay(const HandleGraph* graph, const ExecutionOptions& execution) : graph(graph) {
+
+    node_count = graph->get_node_count();
+    node_offsets.assign(node_count + 1, 0);
+    edge_offsets.assign(node_count + 1, 0);
+    if (node_count == 0) {
+        return;
+    }
+
+    // Collect the IDs. Each node gets its own slot, so the underlying graph
+    // can hand them out from as many threads as it likes.
+    std::vector<nid_t> sorted_ids(node_count);
+    std::atomic<size_t> found(0);
+    graph->for_each_handle([&](const handle_t& handle) {
+        size_t slot = found.fetch_add(1);
+        if (slot < sorted_ids.size()) {
+            sorted_ids[slot] = graph->get_id(handle);
+        }
+    }, execution.get_thread_count() != 1);
+    if (found.load() != node_count) {
+        throw std::runtime_error("error:[VectorizableOverlay] graph reports " + std::to_string(node_count) +
+                                 " nodes but has " + std::to_string(found.load()));
+    }
+    if (!std::is_sorted(sorted_ids.begin(), sorted_ids.end())) {
+        std::sort(sorted_ids.begin(), sorted_ids.end());
+    }
+    min_id = sorted_ids.front();
+    max_id = sorted_ids.back();
+
+    size_t block_count = (node_count + RANK_BLOCK_SIZE - 1) / RANK_BLOCK_SIZE;
+    uint64_t width = (uint64_t) (max_id - min_id) + 1;
+    if (width == node_count) {
+        encoding = RankEncoding::CONTIGUOUS;
+    } else if (width <= 2 * (uint64_t) node_count) {
+        encoding = RankEncoding::DIRECT;
+        ranks.assign(width, 0);
+        execution.parallel_for(block_count, [&](size_t block) {
+            size_t block_end = std::min(node_count, (block + 1) * RANK_BLOCK_SIZE);
+            for (size_t i = block * RANK_BLOCK_SIZE; i < block_end; i++) {
+                ranks[sorted_ids[i] - min_id] = i + 1;
+            }
+        });
+        ids = std::move(sorted_ids);
+    } else {
+        encoding = RankEncoding::ELIAS_FANO;
+        std::vector<uint64_t> values(node_count);
+        execution.parallel_for(block_count, [&](size_t block) {
+            size_t block_end = std::min(node_count, (block + 1) * RANK_BLOCK_SIZE);
+            for (size_t i = block * RANK_BLOCK_SIZE; i < block_end; i++) {
+                values[i] = sorted_ids[i] - min_id;
+            }
+        });
+        sorted_ids.clear();
+        sorted_ids.shrink_to_fit();
+        id_sequence = EliasFanoSequence(values);
+    }
+
+    // Measure each node, and count the edges numbered from it, with each
+    // rank's numbers shifted up one so the sums come out as offsets.
+    execution.parallel_for(block_count, [&](size_t block) {
+        size_t block_end = std::min(node_count, (block + 1) * RANK_BLOCK_SIZE);
+        for (size_t i = block * RANK_BLOCK_SIZE; i < block_end; i++) {
+            nid_t node_id = rank_to_id(i + 1);
+            node_offsets[i + 1] = graph->get_length(graph->get_handle(node_id));
+            size_t edge_count = 0;
+            for_each_numbered_edge(node_id, [&](const edge_t&) {
+                edge_count++;
+                return true;
+            });
+            edge_offsets[i + 1] = edge_count;
+        }
+    });
+    for (size_t i = 1; i <= node_count; i++) {
+        node_offsets[i] += node_offsets[i - 1];
+        edge_offsets[i] += edge_offsets[i - 1];
+    }
+}
+
+VectorizableOverlay::RankEncoding VectorizableOverlay::get_rank_encoding() const {
+    return encoding;
+}
+
+size_t VectorizableOverlay::get_memory_usage() const {
+    return sizeof(*this) +
+        ranks.capacity() * sizeof(size_t) +
+        ids.capacity() * sizeof(nid_t) +
+        id_sequence.get_memory_usage() - sizeof(id_sequence) +
+        node_offsets.capacity() * sizeof(size_t) +
+        edge_offsets.capacity() * sizeof(size_t);
+}
+
+bool VectorizableOverlay::has_node(nid_t node_id) const {
+    return graph->has_node(node_id);
+}
+
+handle_t VectorizableOverlay::get_handle(const nid_t& node_id, bool is_reverse) const {
+    return graph->get_handle(node_id, is_reverse);
+}
+
+nid_t VectorizableOverlay::get_id(const handle_t& handle) const {
+    return graph->get_id(handle);
+}
+
+bool VectorizableOverlay::get_is_reverse(const handle_t& handle) const {
+    return graph->get_is_reverse(handle);
+}
+
+handle_t VectorizableOverlay::flip(const handle_t& handle) const {
+    return graph->flip(handle);
+}
+
+size_t VectorizableOverlay::get_length(const handle_t& handle) const {
+    return graph->get_length(handle);
+}
+
+std::string VectorizableOverlay::get_sequence(const handle_t& handle) const {
+    return graph->get_sequence(handle);
+}
+
+size_t VectorizableOverlay::get_node_count() const {
+    return node_count;
+}
+
+nid_t VectorizableOverlay::min_node_id() const {
+    return node_count == 0 ? graph->min_node_id() : min_id;
+}
+
+nid_t VectorizableOverlay::max_node_id() const {
+    return node_count == 0 ? graph->max_node_id() : max_id;
+}
+
+size_t VectorizableOverlay::get_degree(const handle_t& handle, bool go_left) const {
+    return graph->get_degree(handle, go_left);
+}
+
+bool VectorizableOverlay::has_edge(const handle_t& left, const handle_t& right) const {
+    return graph->has_edge(left, right);
+}
+
+size_t VectorizableOverlay::get_edge_count() const {
+    return edge_offsets.back();
+}
+
+size_t VectorizableOverlay::get_total_length() const {
+    return node_offsets.back();
+}
+
+char VectorizableOverlay::get_base(const handle_t& handle, size_t index) const {
+    return graph->get_base(handle, index);
+}
+
+std::string VectorizableOverlay::get_subsequence(const handle_t& handle, size_t index, size_t size) const {
+    return graph->get_subsequence(handle, index, size);
+}
+
+size_t VectorizableOverlay::id_to_rank(const nid_t& node_id) const {
+    if (node_count == 0 || node_id < min_id || node_id > max_id) {
+        return 0;
+    }
+    uint64_t offset = node_id - min_id;
+    switch (encoding) {
+    case RankEncoding::CONTIGUOUS:
+        return offset + 1;
+    case RankEncoding::DIRECT:
+        return ranks[offset];
+    default:
+        {
+            size_t index = id_sequence.lower_bound(offset);
+            return id_sequence.get(index) == offset ? index + 1 : 0;
+        }
+    }
+}
+
+nid_t VectorizableOverlay::rank_to_id(const size_t& rank) const {
+    switch (encoding) {
+    case RankEncoding::CONTIGUOUS:
+        return min_id + (nid_t) (rank - 1);
+    case RankEncoding::DIRECT:
+        return ids[rank - 1];
+    default:
+        return min_id + (nid_t) id_sequence.get(rank - 1);
+    }
+}
+
+size_t VectorizableOverlay::node_vector_offset(const nid_t& node_id) const {
+    return node_offsets[id_to_rank(node_id) - 1];
+}
+
+nid_t VectorizableOverlay::node_at_vector_offset(const size_t& offset) const {
+    if (offset >= node_offsets.back()) {
+        throw std::runtime_error("error:[VectorizableOverlay] offset " + std::to_string(offset) +
+                                 " is past the end of the node vector");
+    }
+    // Find the last rank starting at or before the offset
+    size_t rank = std::upper_bound(node_offsets.begin(), node_offsets.end(), offset) - node_offsets.begin();
+    return rank_to_id(rank);
+}
+
+size_t VectorizableOverlay::edge_index(const edge_t& edge) const {
+    edge_t canonical = graph->edge_handle(edge.first, edge.second);
+    nid_t node_id = graph->get_id(canonical.first);
+    size_t rank = id_to_rank(node_id);
+    if (rank != 0) {
+        size_t index = edge_offsets[rank - 1];
+        bool found = !for_each_numbered_edge(node_id, [&](const edge_t& numbered) {
+            index++;
+            return numbered != canonical;
+        });
+        if (found) {
+            return index;
+        }
+    }
+    throw std::runtime_error("error:[VectorizableOverlay] no edge from " + std::to_string(node_id) +
+                             (graph->get_is_reverse(canonical.first) ? "-" : "+") + " to " +
+                             std::to_string(graph->get_id(canonical.second)) +
+                             (graph->get_is_reverse(canonical.second) ? "-" : "+"));
+}
+
+handle_t VectorizableOverlay::get_underlying_handle(const handle_t& handle) const {
+    return handle;
+}
+
+bool VectorizableOverlay::follow_edges_impl(const handle_t& handle, bool go_left, const std::function<bool(const handle_t&)>& iteratee) const {
+    return graph->follow_edges(handle, go_left, iteratee);
+}
+
+bool VectorizableOverlay::for_each_handle_impl(const std::function<bool(const handle_t&)>& iteratee, bool parallel) const {
+    return graph->for_each_handle(iteratee, parallel);
+}
+
+bool VectorizableOverlay::for_each_numbered_edge(nid_t node_id, const std::function<bool(const edge_t&)>& iteratee) const {
+    // Every edge in canonical orientation leaves exactly one handle to the
+    // right, so we number it there.
+    for (bool is_reverse : {false, true}) {
+        handle_t handle = graph->get_handle(node_id, is_reverse);
+        bool keep_going = graph->follow_edges(handle, false, [&](const handle_t& next) {
+            edge_t edge(handle, next);
+            if (graph->edge_handle(handle, next) != edge) {
+                return true;
+            }
+            return iteratee(edge);
+        });
+        if (!keep_going) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}